@@ -210,11 +210,21 @@ typedef struct {
 
 /*
  * Generic Acmd Packet
+ *
+ * The synthesis code steps through its command buffer as u64s, so the words
+ * stay 32 bits wide on 64-bit hosts too. DRAM addresses are truncated to
+ * 32 bits there, and only work if everything they point to is below 4 GB
+ * (see tools/audio_render).
  */
 
 typedef struct {
+#if IS_64_BIT
+    unsigned int w0;
+    unsigned int w1;
+#else
     uintptr_t w0;
     uintptr_t w1;
+#endif
 } Awords;
 
 typedef union {
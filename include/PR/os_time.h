@@ -18,6 +18,15 @@ typedef struct OSTimer_str
 
 typedef u64 OSTime;
 
+/* Timing macros, as in os.h. osGetTime counts at OS_CPU_COUNTER a second */
+
+#define    OS_CLOCK_RATE        62500000LL
+#define    OS_CPU_COUNTER        (OS_CLOCK_RATE*3/4)
+#define OS_NSEC_TO_CYCLES(n)    (((u64)(n)*(OS_CPU_COUNTER/15625000LL))/(1000000000LL/15625000LL))
+#define OS_USEC_TO_CYCLES(n)    (((u64)(n)*(OS_CPU_COUNTER/15625LL))/(1000000LL/15625LL))
+#define OS_CYCLES_TO_NSEC(c)    (((u64)(c)*(1000000000LL/15625000LL))/(OS_CPU_COUNTER/15625000LL))
+#define OS_CYCLES_TO_USEC(c)    (((u64)(c)*(1000000LL/15625LL))/(OS_CPU_COUNTER/15625LL))
+
 /* Functions */
 
 OSTime osGetTime(void);
@@ -22,4 +22,157 @@
 // Debug Build
 #define DEBUG
 
+// Static Surface Partition
+// Splits each of the 16x16 level collision cells into an NxN grid of smaller cells
+// (must be a power of two, 1 = vanilla). Large levels spend less time walking surface
+// lists in find_floor, find_ceil and find_wall_collisions, at the cost of more
+// surface nodes and a bigger partition.
+#define STATIC_SURFACE_SUBDIVISIONS 1
+
+// Static Surface Y Bands
+// Number of height bands that each static cell indexes its floors and ceilings by.
+// find_floor and find_ceil start from the first surface that can be reached from the
+// band the query is in, skipping stacked surfaces above or below it (1 = no skipping).
+// The entry points are allocated from the main pool with the surface pools, and take 2 KB
+// per band (times STATIC_SURFACE_SUBDIVISIONS squared), so 16 KB with 8 bands. With 1 band
+// there is no table.
+#define STATIC_SURFACE_Y_BANDS 8
+
+// Incremental Dynamic Surfaces
+// Objects keep their collision surfaces from frame to frame while their transform stays
+// the same, instead of every object surface being cleared and reloaded each frame.
+// Surfaces of unmoved objects stay loaded while the objects before them update, and
+// object floors at the same height can be ordered differently than in vanilla. Off by
+// default, since that can change which object surface Mario collides with.
+// #define INCREMENTAL_DYNAMIC_SURFACES
+
+// Surface Query Cache
+// find_floor and find_ceil remember their results for the rest of the frame, by the whole
+// number position they were asked about, so that camera.c can reuse the floors and ceilings
+// that mario_step.c or its own earlier checks already found. Loading or unloading an object's
+// surfaces forgets the ones in the cells it touched. gSurfaceQueryCacheStats in
+// surface_collision.c has this frame's hits and misses. Off by default, since the cache adds
+// about 1.3 KB of BSS and 1.4 KB of code to the engine segment, which has little room left
+// below the framebuffers in the default memory layout.
+// #define SURFACE_QUERY_CACHE
+
+// Surface Collision Profiler
+// Counts the surfaces tested by find_floor, find_ceil and find_wall_collisions
+// (gNumSurfacesVisited in surface_collision.c), and shows the average per check on the
+// debug surface info page. Off by default, since it adds a counter to the inner loop of
+// every surface check.
+// #define SURFACE_COLLISION_PROFILER
+
+// Object Collision Broadphase
+// Sorts each object list's tangible objects along the x axis before detecting object
+// collisions, so each object is only hitbox tested against objects near it. Objects are
+// still tested in list order, and collide with the same objects as without it.
+#define OBJECT_COLLISION_BROADPHASE
+
+// Object Profiler
+// Records how long each update_objects phase, object list and behavior takes into a ring
+// buffer of the last frames (gObjectProfilerFrames in profiler.c). tools/object_profile.py
+// turns a RAM dump of it into a Chrome trace. Off by default, since it reads the clock
+// around every object update.
+// #define OBJECT_PROFILER
+
+// Behavior Profiler
+// Totals the time taken and behavior commands run by cur_obj_update for each behavior
+// script across the frames of a level (gBehaviorCosts in behavior_script.c). The objectinfo
+// debug page lists the most expensive ones, and tools/object_profile.py --top prints a full
+// report. Off by default, since it reads the clock around every cur_obj_update.
+// #define BEHAVIOR_PROFILER
+
+// Streaming Segment Decompression
+// MIO0 segments are decompressed while they're read from ROM, a chunk at a time, instead
+// of the whole compressed segment being read into the main pool first. gSegmentLoadStats
+// in memory.c has the DMA and decode times of the last load of each segment.
+#define STREAMING_SEGMENT_DECOMPRESSION
+
+// Memory Tracker
+// Records the call site and size of every main pool block, the high-water marks of both
+// sides of the main pool, the usage of every memory pool and a snapshot at each push/pop
+// of the pool state in gMemoryTracker. Dump RDRAM and run tools/memory_report.py on it.
+// Off by default, since every tagged call also stores its call site.
+// #define MEMORY_TRACKER
+
+// Master List Sorting
+// The opaque and alpha-tested layers of each master list are sorted by display list and
+// transform before they're drawn, and a transform isn't loaded again if it's already the
+// current one. Display lists made by geo functions and ones that set the env or prim color
+// keep their place. gMasterListStats has how many commands that saved in the last frame.
+#define MASTER_LIST_SORTING
+
+// Frustum Culling
+// Objects and culling radius nodes are tested against all sides of the view frustum,
+// with the aspect ratio accounted for, instead of only its depth and horizontal edges.
+// Subtrees of a culling sphere that's entirely in view aren't tested again. The far
+// side stays at 20000 units, and Mario and objects holding another object are not
+// tested against the top and bottom sides, so the HOLP and PU behavior is unchanged.
+#define FRUSTUM_CULLING
+
+// Animation Pose Cache
+// The values of each animated part are read once per animation and frame in a frame, and
+// shared by every object playing that animation at that frame. Up to 16 poses are kept, in
+// about 37 KB of RAM. gAnimPoseCacheStats has the hits and misses of the last frame.
+#define ANIMATION_POSE_CACHE
+
+// Compiled Geo Layouts
+// The graph nodes process_geo_layout builds for a model are kept in a buffer of
+// COMPILED_GEO_BUFFER_SIZE bytes, and copied back into place the next time the model's geo
+// layout is loaded from the same ROM data, instead of running its commands again.
+// gCompiledGeoStats has the time spent on each. Off by default, since the buffer is kept in
+// RAM for the whole game.
+// #define COMPILED_GEO_LAYOUTS
+#define COMPILED_GEO_BUFFER_SIZE 0x10000
+
+// Sample DMA Cache
+// dma_sample_data keeps the sample DMA buffers in least recently used order and finds
+// them by device address through a hash table, instead of with fixed TTLs and two reuse
+// queues. Each note gets SAMPLE_DMA_BUFFERS_PER_NOTE buffers, and the next part of a
+// note's sample is read ahead once it's within SAMPLE_DMA_PREFETCH_DISTANCE bytes of the
+// end of its buffer (0 to turn this off). gSampleDmaCacheStats in load.c counts hits,
+// misses and evictions.
+#define SAMPLE_DMA_CACHE
+#define SAMPLE_DMA_BUFFERS_PER_NOTE 4
+#define SAMPLE_DMA_PREFETCH_DISTANCE 0x280
+
+// Audio Profiler
+// Counts the active notes, notes stolen from lower priority layers, sample DMAs and audio
+// commands of each audio update in the last frame (gAudioUpdateStats in synthesis.c).
+// tools/audio_render/sequence_report turns it on and prints them for every sequence. Off by
+// default, since it checks every note after each audio update.
+// #define AUDIO_PROFILER
+
+// Goddard Name Index
+// get_dynobj_info finds dynlist objects through a hash table of their names that
+// add_to_dynobj_list keeps up to date, instead of comparing against every object made so
+// far, and integer names are formatted without sprintf. gDynObjLookupStats in
+// dynlist_proc.c counts the lookups and name comparisons since the last reset_dynlist.
+#define GODDARD_DYNOBJ_INDEX
+
+// Goddard Packed Skinning
+// When the Mario head's nets are reset, the vertices that each skin net moves and the
+// weights of the bone nets that pull on them are copied into flat arrays. The weights are
+// then applied in one tight loop that also writes the Vtx, when convert_net_verts runs at
+// V-blank, instead of a walk through the object groups in move_nets and another in
+// convert_net_verts. Nets that don't fit the pattern are moved the original way.
+#define GODDARD_PACKED_SKIN
+
+// Goddard Slab Allocator
+// gd_malloc serves requests of up to 768 bytes from pages of heap memory cut into slots of
+// one size, instead of giving each one a GMemBlock and searching the free block list for
+// it, so far less memory has to be kept for GMemBlocks and GD_HEAP_SIZE is smaller.
+// gGdMemStats in gd_memory.c counts slots and pages per size class, and slab_stats prints
+// them with how fragmented the heap is.
+#define GODDARD_SLAB_ALLOCATOR
+
+// Goddard Hand Display List Cache
+// update_cursor uses the hand's display list from two frames before again, instead of
+// making it, when the hand is in the same place with the same sprite. gHandDlStats in
+// renderer.c counts the display lists made and reused. The views' display lists are still
+// made every frame, since measuring them found no view that was unchanged between frames,
+// so a cache for them never reused anything.
+#define GODDARD_HAND_DL_CACHE
+
 #endif // CONFIG_H
@@ -1,5 +1,4 @@
 #include <ultra64.h>
-#include <PR/os.h>
 
 #include "data.h"
 #include "external.h"
@@ -9,6 +8,37 @@
 
 #define ALIGN16(val) (((val) + 0xF) & ~0xF)
 
+#ifdef SAMPLE_DMA_CACHE
+// Sample DMAs are read from addresses aligned to SAMPLE_DMA_BLOCK_SIZE, and buffers are
+// big enough that any chunk a note asks for that starts in a block fits in that block's
+// buffer.
+#define SAMPLE_DMA_BLOCK_SIZE 0x400
+#define SAMPLE_DMA_BUFFER_SIZE (144 * 9)
+#define SAMPLE_DMA_HASH_SIZE 64
+#define SAMPLE_DMA_NONE 0xFF
+
+// A buffer that was read by the command list of a frame can be reused this many frames
+// later, once the RSP is done with it.
+#define SAMPLE_DMA_MIN_AGE 2
+
+// Prefetches leave this many of the frame's DMA messages for notes that miss
+#define SAMPLE_DMA_DEMAND_RESERVE (AUDIO_FRAME_DMA_QUEUE_SIZE / 2)
+
+#define SAMPLE_DMA_INDEXED 0x1    // source is a block address, in sSampleDmaHashTable
+#define SAMPLE_DMA_PREFETCHED 0x2 // read ahead and not used yet
+#define SAMPLE_DMA_UNREAD 0x4     // not read, since the frame's DMA queue was full
+
+struct SharedDma {
+    u8 *buffer;       // target, points to pre-allocated buffer
+    uintptr_t source; // device address, 0 if unused
+    u32 lastUsed;     // sSampleDmaFrame when a command list last read from the buffer
+    u16 bufSize;      // size of buffer
+    u8 prev;          // neighbours in the list from most to least recently used
+    u8 next;
+    u8 hashNext;      // next buffer in the same sSampleDmaHashTable bucket
+    u8 flags;
+};
+#else
 struct SharedDma {
     /*0x0*/ u8 *buffer;       // target, points to pre-allocated buffer
     /*0x4*/ uintptr_t source; // device address
@@ -18,6 +48,7 @@ struct SharedDma {
     /*0xD*/ u8 reuseIndex;    // position in sSampleDmaReuseQueue1/2, if ttl == 0
     /*0xE*/ u8 ttl;           // duration after which the DMA can be discarded
 }; // size = 0x10
+#endif
 
 // EU only
 void port_eu_init(void);
@@ -42,6 +73,13 @@ OSIoMesg gAudioDmaIoMesg;
 
 struct SharedDma sSampleDmas[0x60];
 u32 gSampleDmaNumListItems; // sh: 0x803503D4
+#ifdef SAMPLE_DMA_CACHE
+u32 sSampleDmaFrame;
+u8 sSampleDmaHashTable[SAMPLE_DMA_HASH_SIZE];
+u8 sSampleDmaMostRecent;
+u8 sSampleDmaLeastRecent;
+struct SampleDmaCacheStats gSampleDmaCacheStats;
+#else
 u32 sSampleDmaListSize1;    // sh: 0x803503D8
 u32 sUnused80226B40;        // set to 0, never read, sh: 0x803503DC
 
@@ -52,6 +90,7 @@ u8 sSampleDmaReuseQueueTail1;
 u8 sSampleDmaReuseQueueTail2;
 u8 sSampleDmaReuseQueueHead1; // sh: 0x803505E2
 u8 sSampleDmaReuseQueueHead2; // sh: 0x803505E3
+#endif
 
 // bss correct up to here
 
@@ -123,6 +162,218 @@ void audio_dma_partial_copy_async(uintptr_t *devAddr, u8 **vAddr, ssize_t *remai
     *vAddr += transfer;
 }
 
+#ifdef SAMPLE_DMA_CACHE
+#define SAMPLE_DMA_HASH(source) (((source) / SAMPLE_DMA_BLOCK_SIZE) & (SAMPLE_DMA_HASH_SIZE - 1))
+
+static void sample_dma_unlink(u8 index) {
+    struct SharedDma *dma = &sSampleDmas[index];
+
+    if (dma->prev != SAMPLE_DMA_NONE) {
+        sSampleDmas[dma->prev].next = dma->next;
+    } else {
+        sSampleDmaMostRecent = dma->next;
+    }
+    if (dma->next != SAMPLE_DMA_NONE) {
+        sSampleDmas[dma->next].prev = dma->prev;
+    } else {
+        sSampleDmaLeastRecent = dma->prev;
+    }
+}
+
+/**
+ * Marks a buffer as read by the command list of this frame.
+ */
+static void sample_dma_touch(u8 index) {
+    struct SharedDma *dma = &sSampleDmas[index];
+
+    dma->lastUsed = sSampleDmaFrame;
+    if (sSampleDmaMostRecent == index) {
+        return;
+    }
+    sample_dma_unlink(index);
+    dma->prev = SAMPLE_DMA_NONE;
+    dma->next = sSampleDmaMostRecent;
+    sSampleDmas[sSampleDmaMostRecent].prev = index;
+    sSampleDmaMostRecent = index;
+}
+
+static u8 sample_dma_find_block(uintptr_t source) {
+    u8 index = sSampleDmaHashTable[SAMPLE_DMA_HASH(source)];
+
+    while (index != SAMPLE_DMA_NONE && sSampleDmas[index].source != source) {
+        index = sSampleDmas[index].hashNext;
+    }
+    return index;
+}
+
+static void sample_dma_remove_block(u8 index) {
+    u8 *link = &sSampleDmaHashTable[SAMPLE_DMA_HASH(sSampleDmas[index].source)];
+
+    while (*link != index) {
+        link = &sSampleDmas[*link].hashNext;
+    }
+    *link = sSampleDmas[index].hashNext;
+}
+
+/**
+ * Reads bufSize bytes at source into the least recently used buffer, and returns the
+ * buffer's index. If a command list of the last SAMPLE_DMA_MIN_AGE frames might still
+ * read that buffer, it's only used if force is set, and SAMPLE_DMA_NONE is returned
+ * otherwise. The same goes for when the frame's DMA queue is full, except that the
+ * buffer isn't read and is marked SAMPLE_DMA_UNREAD, so it's read again next time.
+ */
+static u8 sample_dma_start(uintptr_t source, s32 indexed, s32 force) {
+    u8 index = sSampleDmaLeastRecent;
+    struct SharedDma *dma = &sSampleDmas[index];
+
+    if (!force && gCurrAudioFrameDmaCount >= AUDIO_FRAME_DMA_QUEUE_SIZE) {
+        return SAMPLE_DMA_NONE;
+    }
+
+    if (sSampleDmaFrame - dma->lastUsed < SAMPLE_DMA_MIN_AGE) {
+        if (!force) {
+            return SAMPLE_DMA_NONE;
+        }
+        gSampleDmaCacheStats.overruns++;
+    }
+
+    if (dma->source != 0) {
+        gSampleDmaCacheStats.evictions++;
+        if (dma->flags & SAMPLE_DMA_INDEXED) {
+            sample_dma_remove_block(index);
+        }
+    }
+    dma->source = source;
+    dma->flags = 0;
+
+    if (gCurrAudioFrameDmaCount >= AUDIO_FRAME_DMA_QUEUE_SIZE) {
+        // Starting another DMA would overrun gCurrAudioFrameDmaIoMesgBufs
+        gSampleDmaCacheStats.queueFull++;
+        dma->flags = SAMPLE_DMA_UNREAD;
+        return index;
+    }
+
+    if (indexed) {
+        dma->flags = SAMPLE_DMA_INDEXED;
+        dma->hashNext = sSampleDmaHashTable[SAMPLE_DMA_HASH(source)];
+        sSampleDmaHashTable[SAMPLE_DMA_HASH(source)] = index;
+    }
+
+    gCurrAudioFrameDmaCount++;
+    osPiStartDma(&gCurrAudioFrameDmaIoMesgBufs[gCurrAudioFrameDmaCount - 1], OS_MESG_PRI_NORMAL,
+                 OS_READ, source, dma->buffer, dma->bufSize, &gCurrAudioFrameDmaQueue);
+    return index;
+}
+
+/**
+ * Reads the block after the one the note is in, if the note is close to the end of
+ * its buffer and the block isn't already in a buffer.
+ */
+static void sample_dma_prefetch(struct SharedDma *dma, uintptr_t end) {
+    uintptr_t next = dma->source + SAMPLE_DMA_BLOCK_SIZE;
+    u8 index;
+
+    if (!(dma->flags & SAMPLE_DMA_INDEXED)
+        || end + SAMPLE_DMA_PREFETCH_DISTANCE <= dma->source + dma->bufSize
+        || gCurrAudioFrameDmaCount >= AUDIO_FRAME_DMA_QUEUE_SIZE - SAMPLE_DMA_DEMAND_RESERVE
+        || sample_dma_find_block(next) != SAMPLE_DMA_NONE) {
+        return;
+    }
+
+    index = sample_dma_start(next, TRUE, FALSE);
+    if (index != SAMPLE_DMA_NONE) {
+        // So that it isn't the next buffer to be reused
+        sample_dma_touch(index);
+        sSampleDmas[index].flags |= SAMPLE_DMA_PREFETCHED;
+        gSampleDmaCacheStats.prefetches++;
+    }
+}
+
+// Called once the command list of a frame has been made
+void decrease_sample_dma_ttls() {
+    sSampleDmaFrame++;
+}
+
+/**
+ * Returns where size bytes of sample data at devAddr can be read by this frame's
+ * command list. The buffer the note last used is tried first, then the buffer of the
+ * block devAddr is in, and if neither has the data the least recently used buffer is
+ * read into.
+ */
+void *dma_sample_data(uintptr_t devAddr, u32 size, UNUSED s32 arg2, u8 *dmaIndexRef) {
+    struct SharedDma *dma;
+    uintptr_t source;
+    u8 index = *dmaIndexRef;
+
+    if (index >= gSampleDmaNumListItems || sSampleDmas[index].source == 0
+        || (sSampleDmas[index].flags & SAMPLE_DMA_UNREAD) || devAddr < sSampleDmas[index].source
+        || devAddr - sSampleDmas[index].source + size > sSampleDmas[index].bufSize) {
+        source = devAddr & ~(SAMPLE_DMA_BLOCK_SIZE - 1);
+        if (devAddr - source + size > SAMPLE_DMA_BUFFER_SIZE) {
+            // Doesn't fit in its block's buffer, so it's read on its own
+            gSampleDmaCacheStats.misses++;
+            index = sample_dma_start(devAddr & ~0xF, FALSE, TRUE);
+        } else {
+            index = sample_dma_find_block(source);
+            if (index == SAMPLE_DMA_NONE) {
+                gSampleDmaCacheStats.misses++;
+                index = sample_dma_start(source, TRUE, TRUE);
+            } else {
+                gSampleDmaCacheStats.hits++;
+            }
+        }
+    } else {
+        gSampleDmaCacheStats.hits++;
+    }
+
+    dma = &sSampleDmas[index];
+    if (dma->flags & SAMPLE_DMA_PREFETCHED) {
+        dma->flags &= ~SAMPLE_DMA_PREFETCHED;
+        gSampleDmaCacheStats.prefetchHits++;
+    }
+    sample_dma_touch(index);
+    *dmaIndexRef = index;
+
+    if (SAMPLE_DMA_PREFETCH_DISTANCE != 0) {
+        sample_dma_prefetch(dma, devAddr + size);
+    }
+    return (devAddr - dma->source) + dma->buffer;
+}
+
+void init_sample_dma_buffers(UNUSED s32 arg0) {
+    s32 i;
+
+    sDmaBufSize = SAMPLE_DMA_BUFFER_SIZE;
+
+    for (i = 0; i < gMaxSimultaneousNotes * SAMPLE_DMA_BUFFERS_PER_NOTE
+                && i < (s32) ARRAY_COUNT(sSampleDmas); i++) {
+        sSampleDmas[gSampleDmaNumListItems].buffer = soundAlloc(&gNotesAndBuffersPool, sDmaBufSize);
+        if (sSampleDmas[gSampleDmaNumListItems].buffer == NULL) {
+            break;
+        }
+        sSampleDmas[gSampleDmaNumListItems].bufSize = sDmaBufSize;
+        sSampleDmas[gSampleDmaNumListItems].source = 0;
+        sSampleDmas[gSampleDmaNumListItems].flags = 0;
+        gSampleDmaNumListItems++;
+    }
+
+    sSampleDmaFrame = 0;
+    for (i = 0; (u32) i < gSampleDmaNumListItems; i++) {
+        sSampleDmas[i].lastUsed = sSampleDmaFrame - SAMPLE_DMA_MIN_AGE;
+        sSampleDmas[i].prev = (i == 0) ? SAMPLE_DMA_NONE : i - 1;
+        sSampleDmas[i].next = ((u32) i + 1 == gSampleDmaNumListItems) ? SAMPLE_DMA_NONE : i + 1;
+    }
+    sSampleDmaMostRecent = 0;
+    sSampleDmaLeastRecent = gSampleDmaNumListItems - 1;
+
+    for (i = 0; i < SAMPLE_DMA_HASH_SIZE; i++) {
+        sSampleDmaHashTable[i] = SAMPLE_DMA_NONE;
+    }
+
+    bzero(&gSampleDmaCacheStats, sizeof(gSampleDmaCacheStats));
+    gSampleDmaCacheStats.numBuffers = gSampleDmaNumListItems;
+}
+#else
 void decrease_sample_dma_ttls() {
     u32 i;
 
@@ -299,6 +550,7 @@ out2:
     sSampleDmaReuseQueueTail2 = 0;
     sSampleDmaReuseQueueHead2 = gSampleDmaNumListItems - sSampleDmaListSize1;
 }
+#endif
 
 UNUSED static void patch_sound(UNUSED struct AudioBankSound *sound, UNUSED u8 *memBase,
                                UNUSED u8 *offsetBase) {
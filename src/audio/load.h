@@ -30,6 +30,25 @@ extern struct NotePool gNoteFreeLists;
 
 extern OSMesgQueue gCurrAudioFrameDmaQueue;
 extern u32 gSampleDmaNumListItems;
+
+#ifdef SAMPLE_DMA_CACHE
+/**
+ * How the sample DMA buffers have done since the audio heap was last reset. A hit is a
+ * chunk of sample data that was already in a buffer.
+ */
+struct SampleDmaCacheStats {
+    u32 numBuffers;
+    u32 hits;
+    u32 misses;
+    u32 evictions;    // buffers that were read into again
+    u32 prefetches;
+    u32 prefetchHits; // prefetched buffers that a note went on to use
+    u32 overruns;     // misses with no buffer old enough to reuse safely
+    u32 queueFull;    // misses that weren't read, since the frame's DMA queue was full
+};
+
+extern struct SampleDmaCacheStats gSampleDmaCacheStats;
+#endif
 extern ALSeqFile *gAlCtlHeader;
 extern ALSeqFile *gAlTbl;
 extern ALSeqFile *gSeqFileHeader;
@@ -484,6 +484,9 @@ struct Note *alloc_note_from_active(struct NotePool *pool, struct SequenceChanne
     if (aNote == NULL) {
         eu_stubbed_printf_0("Audio: C-Alloc : lowerPrio is NULL\n");
     } else {
+#ifdef AUDIO_PROFILER
+        gAudioNoteSteals++;
+#endif
         func_80319728(aNote, seqLayer);
         audio_list_push_back(&pool->releasing, &aNote->listItem);
     }
@@ -55,6 +55,11 @@ u64 *note_apply_headset_pan_effects(u64 *cmd, struct Note *note, s32 bufLen, s32
 struct SynthesisReverb gSynthesisReverb;
 u8 sAudioSynthesisPad[0x20];
 
+#ifdef AUDIO_PROFILER
+struct AudioUpdateStats gAudioUpdateStats[MAX_UPDATES_PER_FRAME];
+u32 gAudioNoteSteals = 0;
+#endif
+
 void prepare_reverb_ring_buffer(s32 chunkLen, u32 updateIndex) {
     struct ReverbRingBufferItem *item;
     s32 srcPos;
@@ -138,10 +143,22 @@ u64 *synthesis_execute(u64 *cmdBuf, s32 *writtenCmds, s16 *aiBuf, s32 bufLen) {
     u32 *aiBufPtr = (u32 *) aiBuf;
     u64 *cmd = cmdBuf + 1;
     s32 v0;
+#ifdef AUDIO_PROFILER
+    struct AudioUpdateStats *stats;
+    u64 *updateCmd;
+    u32 noteSteals;
+    s32 dmaCount;
+    s32 j;
+#endif
 
     aSegment(cmdBuf, 0, 0);
 
     for (i = gAudioUpdatesPerFrame; i > 0; i--) {
+#ifdef AUDIO_PROFILER
+        updateCmd = cmd;
+        noteSteals = gAudioNoteSteals;
+        dmaCount = gCurrAudioFrameDmaCount;
+#endif
         if (i == 1) {
             // 'bufLen' will automatically be divisible by 8, no need to round
             chunkLen = bufLen;
@@ -159,6 +176,20 @@ u64 *synthesis_execute(u64 *cmdBuf, s32 *writtenCmds, s16 *aiBuf, s32 bufLen) {
             prepare_reverb_ring_buffer(chunkLen, gAudioUpdatesPerFrame - i);
         }
         cmd = synthesis_do_one_audio_update((s16 *) aiBufPtr, chunkLen, cmd, gAudioUpdatesPerFrame - i);
+#ifdef AUDIO_PROFILER
+        if (gAudioUpdatesPerFrame - i < MAX_UPDATES_PER_FRAME) {
+            stats = &gAudioUpdateStats[gAudioUpdatesPerFrame - i];
+            stats->activeNotes = 0;
+            for (j = 0; j < gMaxSimultaneousNotes; j++) {
+                if (gNotes[j].enabled) {
+                    stats->activeNotes++;
+                }
+            }
+            stats->noteSteals = gAudioNoteSteals - noteSteals;
+            stats->dmaRequests = gCurrAudioFrameDmaCount - dmaCount;
+            stats->numCmds = cmd - updateCmd;
+        }
+#endif
         bufLen -= chunkLen;
         aiBufPtr += chunkLen;
     }
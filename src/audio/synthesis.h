@@ -40,6 +40,22 @@ struct SynthesisReverb {
 }; // 0xCC <= size <= 0x100
 extern struct SynthesisReverb gSynthesisReverb;
 
+#ifdef AUDIO_PROFILER
+/**
+ * What one audio update did, from processing the sequences to adding its
+ * commands to the command list.
+ */
+struct AudioUpdateStats {
+    u16 activeNotes; // enabled at the end of the update
+    u16 noteSteals;  // notes taken from lower priority layers by alloc_note_from_active
+    u16 dmaRequests; // sample DMAs started by dma_sample_data
+    u16 numCmds;
+};
+
+extern struct AudioUpdateStats gAudioUpdateStats[MAX_UPDATES_PER_FRAME];
+extern u32 gAudioNoteSteals;
+#endif
+
 u64 *synthesis_execute(u64 *cmdBuf, s32 *writtenCmds, s16 *aiBuf, s32 bufLen);
 void note_init_volume(struct Note *note);
 void note_set_vel_pan_reverb(struct Note *note, f32 velocity, f32 pan, u8 reverbVol);
@@ -30,6 +30,12 @@
 
 static u16 gRandomSeed16;
 
+#ifdef BEHAVIOR_PROFILER
+// Open addressed by behavior script address, so entries aren't in any order.
+struct BehaviorCost gBehaviorCosts[BEHAVIOR_PROFILER_CAPACITY];
+s32 gNumBehaviorCosts = 0;
+#endif
+
 // Unused function that directly jumps to a behavior command and resets the object's stack index.
 UNUSED static void goto_behavior_unused(const BehaviorScript *bhvAddr) {
     gCurBhvCommand = segmented_to_virtual(bhvAddr);
@@ -901,6 +907,81 @@ static BhvCommandProc BehaviorCmdTable[] = {
     bhv_cmd_spawn_water_droplet,
 };
 
+#ifdef BEHAVIOR_PROFILER
+// Clear the behavior costs so that they're totalled from this point on.
+void reset_behavior_costs(void) {
+    s32 i;
+
+    for (i = 0; i < BEHAVIOR_PROFILER_CAPACITY; i++) {
+        gBehaviorCosts[i].behavior = NULL;
+    }
+
+    gNumBehaviorCosts = 0;
+}
+
+// Add an update of an object with the given behavior to the behavior's totals.
+static void log_behavior_cost(const BehaviorScript *behavior, u32 time, u32 numCommands) {
+    s32 i = ((uintptr_t) behavior >> 2) & (BEHAVIOR_PROFILER_CAPACITY - 1);
+    struct BehaviorCost *cost = &gBehaviorCosts[i];
+
+    while (cost->behavior != behavior) {
+        if (cost->behavior == NULL) {
+            // Leave a free entry so that lookups always stop.
+            if (gNumBehaviorCosts == BEHAVIOR_PROFILER_CAPACITY - 1) {
+                return;
+            }
+
+            cost->behavior = behavior;
+            cost->time = 0;
+            cost->numUpdates = 0;
+            cost->numCommands = 0;
+            gNumBehaviorCosts++;
+            break;
+        }
+
+        i = (i + 1) & (BEHAVIOR_PROFILER_CAPACITY - 1);
+        cost = &gBehaviorCosts[i];
+    }
+
+    cost->time += time;
+    cost->numUpdates++;
+    cost->numCommands += numCommands;
+}
+
+/**
+ * Fill top with the (at most) count behaviors that took the most time, most expensive
+ * first. Returns how many were filled.
+ */
+s32 get_top_behavior_costs(struct BehaviorCost **top, s32 count) {
+    s32 numTop = 0;
+    s32 i, j;
+
+    for (i = 0; i < BEHAVIOR_PROFILER_CAPACITY; i++) {
+        struct BehaviorCost *cost = &gBehaviorCosts[i];
+
+        if (cost->behavior == NULL) {
+            continue;
+        }
+
+        // Insertion sort into the list so far, dropping whatever falls off the end.
+        for (j = numTop; j > 0 && top[j - 1]->time < cost->time; j--) {
+            if (j < count) {
+                top[j] = top[j - 1];
+            }
+        }
+
+        if (j < count) {
+            top[j] = cost;
+            if (numTop < count) {
+                numTop++;
+            }
+        }
+    }
+
+    return numTop;
+}
+#endif
+
 // Execute the behavior script of the current object, process the object flags, and other miscellaneous
 // code for updating objects.
 void cur_obj_update(void) {
@@ -910,6 +991,12 @@ void cur_obj_update(void) {
     f32 distanceFromMario;
     BhvCommandProc bhvCmdProc;
     s32 bhvProcResult;
+#ifdef BEHAVIOR_PROFILER
+    // The behavior can be changed during the update, so the cost goes to the one it started with.
+    const BehaviorScript *behavior = gCurrentObject->behavior;
+    OSTime startTime = osGetTime();
+    u32 numCommands = 0;
+#endif
 
     // Calculate the distance from the object to Mario.
     if (objFlags & OBJ_FLAG_COMPUTE_DIST_TO_MARIO) {
@@ -936,6 +1023,9 @@ void cur_obj_update(void) {
     do {
         bhvCmdProc = BehaviorCmdTable[*gCurBhvCommand >> 24];
         bhvProcResult = bhvCmdProc();
+#ifdef BEHAVIOR_PROFILER
+        numCommands++;
+#endif
     } while (bhvProcResult == BHV_PROC_CONTINUE);
 
     gCurrentObject->curBhvCommand = gCurBhvCommand;
@@ -1000,4 +1090,8 @@ void cur_obj_update(void) {
             }
         }
     }
+
+#ifdef BEHAVIOR_PROFILER
+    log_behavior_cost(behavior, osGetTime() - startTime, numCommands);
+#endif
 }
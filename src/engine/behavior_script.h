@@ -3,6 +3,8 @@
 
 #include <PR/ultratypes.h>
 
+#include "types.h"
+
 #define BHV_PROC_CONTINUE 0
 #define BHV_PROC_BREAK    1
 
@@ -19,6 +21,24 @@
 
 #define obj_and_int(object, offset, value) object->OBJECT_FIELD_S32(offset) &= (s32)(value)
 
+#ifdef BEHAVIOR_PROFILER
+#define BEHAVIOR_PROFILER_CAPACITY 512
+
+/**
+ * Totals for all cur_obj_update calls of objects with one behavior script,
+ * since the profiler was last reset.
+ */
+struct BehaviorCost {
+    /* 0x00 */ u64 time; // osGetTime ticks
+    /* 0x08 */ const BehaviorScript *behavior;
+    /* 0x0C */ u32 numUpdates;
+    /* 0x10 */ u32 numCommands;
+};
+
+extern struct BehaviorCost gBehaviorCosts[BEHAVIOR_PROFILER_CAPACITY];
+extern s32 gNumBehaviorCosts;
+#endif
+
 u16 random_u16(void);
 float random_float(void);
 s32 random_sign(void);
@@ -26,5 +46,9 @@ s32 random_sign(void);
 void stub_behavior_script_2(void);
 
 void cur_obj_update(void);
+#ifdef BEHAVIOR_PROFILER
+void reset_behavior_costs(void);
+s32 get_top_behavior_costs(struct BehaviorCost **top, s32 count);
+#endif
 
 #endif // BEHAVIOR_SCRIPT_H
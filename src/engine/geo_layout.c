@@ -1,4 +1,5 @@
 #include <ultra64.h>
+#include <string.h>
 #include "sm64.h"
 
 #include "geo_layout.h"
@@ -102,6 +103,61 @@ u8 *gGeoLayoutCommand;
 
 u32 unused_8038B894[3] = { 0 };
 
+#ifdef COMPILED_GEO_LAYOUTS
+#define COMPILED_GEO_MAX_SEGMENTS 4
+#define COMPILED_GEO_MAX_RELOCS 1024
+#define COMPILED_GEO_MAX_FUNC_NODES 64
+
+/**
+ * The graph nodes of a geo layout as process_geo_layout built them. It's
+ * followed in the buffer by the offsets of the pointers between the nodes, the
+ * offsets of the nodes with functions, and the nodes themselves, with the
+ * pointers stored as offsets from the first node.
+ */
+struct CompiledGeoLayout {
+    void *segptr;
+    u8 numSegments;
+    u8 segments[COMPILED_GEO_MAX_SEGMENTS]; // segments the geo layout commands were read from
+    uintptr_t segmentROMAddrs[COMPILED_GEO_MAX_SEGMENTS];
+    u16 size;
+    u16 rootOffset;
+    u16 numRelocs;
+    u16 numFuncNodes;
+};
+
+struct CompiledGeoStats gCompiledGeoStats;
+
+static u32 sCompiledGeoBuffer[COMPILED_GEO_BUFFER_SIZE / sizeof(u32)];
+static u32 sCompiledGeoBufferUsed;
+
+// Segments read by the geo layout being processed
+static u32 sGeoLayoutSegments;
+
+// The pool space the geo layout's nodes were allocated in, while compiling it
+static u8 *sCompileStart;
+static u8 *sCompileEnd;
+static u32 sCompileNodeBytes;
+static u16 sCompileRelocs[COMPILED_GEO_MAX_RELOCS];
+static s32 sCompileNumRelocs;
+static u16 sCompileFuncNodes[COMPILED_GEO_MAX_FUNC_NODES];
+static s32 sCompileNumFuncNodes;
+#endif
+
+/**
+ * Convert the address of geo layout commands, noting its segment so that a
+ * compiled copy of the layout can tell when the segment has been reloaded.
+ */
+static void *geo_layout_segmented_to_virtual(void *segptr) {
+#if defined(COMPILED_GEO_LAYOUTS) && !defined(NO_SEGMENTED_MEMORY)
+    uintptr_t segment = (uintptr_t) segptr >> 24;
+
+    if (segment < 32) {
+        sGeoLayoutSegments |= (u32) 1 << segment;
+    }
+#endif
+    return segmented_to_virtual(segptr);
+}
+
 /*
   0x00: Branch and store return address
    cmd+0x04: void *branchTarget
@@ -110,7 +166,7 @@ void geo_layout_cmd_branch_and_link(void) {
     gGeoLayoutStack[gGeoLayoutStackIndex++] = (uintptr_t) (gGeoLayoutCommand + CMD_PROCESS_OFFSET(8));
     gGeoLayoutStack[gGeoLayoutStackIndex++] = (gCurGraphNodeIndex << 16) + gGeoLayoutReturnIndex;
     gGeoLayoutReturnIndex = gGeoLayoutStackIndex;
-    gGeoLayoutCommand = segmented_to_virtual(cur_geo_cmd_ptr(0x04));
+    gGeoLayoutCommand = geo_layout_segmented_to_virtual(cur_geo_cmd_ptr(0x04));
 }
 
 // 0x01: Terminate geo layout
@@ -131,7 +187,7 @@ void geo_layout_cmd_branch(void) {
             (uintptr_t) (gGeoLayoutCommand + CMD_PROCESS_OFFSET(8));
     }
 
-    gGeoLayoutCommand = segmented_to_virtual(cur_geo_cmd_ptr(0x04));
+    gGeoLayoutCommand = geo_layout_segmented_to_virtual(cur_geo_cmd_ptr(0x04));
 }
 
 // 0x03: Return from branch
@@ -769,7 +825,271 @@ void geo_layout_cmd_node_culling_radius(void) {
     gGeoLayoutCommand += 0x04 << CMD_SIZE_SHIFT;
 }
 
+#ifdef COMPILED_GEO_LAYOUTS
+/**
+ * Return the size of a node made by the geo layout commands, or 0 if the
+ * node can't be part of a compiled geo layout. Root nodes fill in gGeoViews
+ * and camera nodes allocate their Camera, so geo layouts with them are always
+ * run.
+ */
+static s32 compiled_geo_node_size(struct GraphNode *node) {
+    switch (node->type) {
+        case GRAPH_NODE_TYPE_ORTHO_PROJECTION:
+            return sizeof(struct GraphNodeOrthoProjection);
+        case GRAPH_NODE_TYPE_PERSPECTIVE:
+            return sizeof(struct GraphNodePerspective);
+        case GRAPH_NODE_TYPE_MASTER_LIST:
+            return sizeof(struct GraphNodeMasterList);
+        case GRAPH_NODE_TYPE_START:
+            return sizeof(struct GraphNodeStart);
+        case GRAPH_NODE_TYPE_LEVEL_OF_DETAIL:
+            return sizeof(struct GraphNodeLevelOfDetail);
+        case GRAPH_NODE_TYPE_SWITCH_CASE:
+            return sizeof(struct GraphNodeSwitchCase);
+        case GRAPH_NODE_TYPE_TRANSLATION_ROTATION:
+            return sizeof(struct GraphNodeTranslationRotation);
+        case GRAPH_NODE_TYPE_TRANSLATION:
+            return sizeof(struct GraphNodeTranslation);
+        case GRAPH_NODE_TYPE_ROTATION:
+            return sizeof(struct GraphNodeRotation);
+        case GRAPH_NODE_TYPE_ANIMATED_PART:
+            return sizeof(struct GraphNodeAnimatedPart);
+        case GRAPH_NODE_TYPE_BILLBOARD:
+            return sizeof(struct GraphNodeBillboard);
+        case GRAPH_NODE_TYPE_DISPLAY_LIST:
+            return sizeof(struct GraphNodeDisplayList);
+        case GRAPH_NODE_TYPE_SCALE:
+            return sizeof(struct GraphNodeScale);
+        case GRAPH_NODE_TYPE_SHADOW:
+            return sizeof(struct GraphNodeShadow);
+        case GRAPH_NODE_TYPE_OBJECT_PARENT:
+            return sizeof(struct GraphNodeObjectParent);
+        case GRAPH_NODE_TYPE_GENERATED_LIST:
+            return sizeof(struct GraphNodeGenerated);
+        case GRAPH_NODE_TYPE_BACKGROUND:
+            return sizeof(struct GraphNodeBackground);
+        case GRAPH_NODE_TYPE_HELD_OBJ:
+            return sizeof(struct GraphNodeHeldObject);
+        case GRAPH_NODE_TYPE_CULLING_RADIUS:
+            return sizeof(struct GraphNodeCullingRadius);
+    }
+    return 0;
+}
+
+/**
+ * Record the pointer at 'field' to be relocated if it points to one of the
+ * nodes being compiled. Return FALSE if there are too many pointers.
+ */
+static s32 compiled_geo_add_reloc(void *field) {
+    u8 *ptr = *(u8 **) field;
+
+    if (ptr >= sCompileStart && ptr < sCompileEnd) {
+        if (sCompileNumRelocs == COMPILED_GEO_MAX_RELOCS) {
+            return FALSE;
+        }
+        sCompileRelocs[sCompileNumRelocs++] = (u8 *) field - sCompileStart;
+    }
+    return TRUE;
+}
+
+/**
+ * Record the relocations and function nodes of a node and its siblings and
+ * their children. Return FALSE if any of them can't be compiled.
+ */
+static s32 compile_geo_nodes(struct GraphNode *firstNode) {
+    struct GraphNode *node = firstNode;
+    s32 size;
+
+    do {
+        size = compiled_geo_node_size(node);
+        if (size == 0) {
+            return FALSE;
+        }
+        sCompileNodeBytes += (size + 3) & ~3;
+
+        if (!compiled_geo_add_reloc(&node->prev) || !compiled_geo_add_reloc(&node->next)
+            || !compiled_geo_add_reloc(&node->parent) || !compiled_geo_add_reloc(&node->children)) {
+            return FALSE;
+        }
+        if (node->type == GRAPH_NODE_TYPE_OBJECT_PARENT
+            && !compiled_geo_add_reloc(&((struct GraphNodeObjectParent *) node)->sharedChild)) {
+            return FALSE;
+        }
+        if (node->type == GRAPH_NODE_TYPE_HELD_OBJ
+            && !compiled_geo_add_reloc(&((struct GraphNodeHeldObject *) node)->objNode)) {
+            return FALSE;
+        }
+
+        if ((node->type & GRAPH_NODE_TYPE_FUNCTIONAL) && ((struct FnGraphNode *) node)->func != NULL) {
+            if (sCompileNumFuncNodes == COMPILED_GEO_MAX_FUNC_NODES) {
+                return FALSE;
+            }
+            sCompileFuncNodes[sCompileNumFuncNodes++] = (u8 *) node - sCompileStart;
+        }
+
+        if (node->children != NULL && !compile_geo_nodes(node->children)) {
+            return FALSE;
+        }
+        node = node->next;
+    } while (node != firstNode);
+
+    return TRUE;
+}
+
+static u8 *compiled_geo_image(struct CompiledGeoLayout *compiled) {
+    u32 offset = sizeof(struct CompiledGeoLayout) + (compiled->numRelocs + compiled->numFuncNodes) * sizeof(u16);
+
+    return (u8 *) compiled + ((offset + 3) & ~3);
+}
+
+static u32 compiled_geo_total_size(struct CompiledGeoLayout *compiled) {
+    return compiled_geo_image(compiled) + compiled->size - (u8 *) compiled;
+}
+
+/**
+ * Keep a copy of the nodes a geo layout was just turned into, which were
+ * allocated between 'start' and 'end'. Geo layouts whose nodes can't be
+ * copied, or that allocated anything else, aren't kept.
+ */
+static void compile_geo_layout(void *segptr, struct GraphNode *root, u8 *start, u8 *end) {
+    struct CompiledGeoLayout compiled;
+    struct CompiledGeoLayout *dest;
+    u16 *offsets;
+    u8 *image;
+    u32 totalSize;
+    s32 i;
+
+    if (end - start > 0xFFFF) {
+        return;
+    }
+
+    compiled.segptr = segptr;
+    compiled.numSegments = 0;
+    for (i = 0; i < 32; i++) {
+        if (sGeoLayoutSegments & ((u32) 1 << i)) {
+            if (compiled.numSegments == COMPILED_GEO_MAX_SEGMENTS || get_segment_rom_addr(i) == 0) {
+                return;
+            }
+            compiled.segments[compiled.numSegments] = i;
+            compiled.segmentROMAddrs[compiled.numSegments] = get_segment_rom_addr(i);
+            compiled.numSegments++;
+        }
+    }
+
+    sCompileStart = start;
+    sCompileEnd = end;
+    sCompileNodeBytes = 0;
+    sCompileNumRelocs = 0;
+    sCompileNumFuncNodes = 0;
+    if (!compile_geo_nodes(root) || sCompileNodeBytes != (u32) (end - start)) {
+        return;
+    }
+
+    compiled.size = end - start;
+    compiled.rootOffset = (u8 *) root - start;
+    compiled.numRelocs = sCompileNumRelocs;
+    compiled.numFuncNodes = sCompileNumFuncNodes;
+
+    // Start over once the buffer is full
+    totalSize = compiled_geo_total_size(&compiled);
+    if (totalSize > sizeof(sCompiledGeoBuffer)) {
+        return;
+    }
+    if (sCompiledGeoBufferUsed + totalSize > sizeof(sCompiledGeoBuffer)) {
+        sCompiledGeoBufferUsed = 0;
+    }
+
+    dest = (struct CompiledGeoLayout *) ((u8 *) sCompiledGeoBuffer + sCompiledGeoBufferUsed);
+    *dest = compiled;
+    offsets = (u16 *) (dest + 1);
+    for (i = 0; i < sCompileNumRelocs; i++) {
+        *offsets++ = sCompileRelocs[i];
+    }
+    for (i = 0; i < sCompileNumFuncNodes; i++) {
+        *offsets++ = sCompileFuncNodes[i];
+    }
+
+    image = compiled_geo_image(dest);
+    memcpy(image, start, compiled.size);
+    for (i = 0; i < sCompileNumRelocs; i++) {
+        *(uintptr_t *) (image + sCompileRelocs[i]) -= (uintptr_t) start;
+    }
+
+    sCompiledGeoBufferUsed += totalSize;
+}
+
+/**
+ * Find the compiled copy of a geo layout, if its segments still hold the same
+ * ROM data as when it was compiled.
+ */
+static struct CompiledGeoLayout *find_compiled_geo_layout(void *segptr) {
+    u8 *pos = (u8 *) sCompiledGeoBuffer;
+    u8 *end = pos + sCompiledGeoBufferUsed;
+    struct CompiledGeoLayout *compiled;
+    s32 i;
+
+    while (pos < end) {
+        compiled = (struct CompiledGeoLayout *) pos;
+        if (compiled->segptr == segptr) {
+            for (i = 0; i < compiled->numSegments; i++) {
+                if (get_segment_rom_addr(compiled->segments[i]) != compiled->segmentROMAddrs[i]) {
+                    break;
+                }
+            }
+            if (i == compiled->numSegments) {
+                return compiled;
+            }
+        }
+        pos += compiled_geo_total_size(compiled);
+    }
+    return NULL;
+}
+
+/**
+ * Copy a compiled geo layout's nodes into the pool, point them at each other,
+ * and call the node functions the way the geo layout commands would have.
+ */
+static struct GraphNode *load_compiled_geo_layout(struct AllocOnlyPool *pool,
+                                                  struct CompiledGeoLayout *compiled) {
+    u16 *relocs = (u16 *) (compiled + 1);
+    u16 *funcNodes = relocs + compiled->numRelocs;
+    struct FnGraphNode *fnNode;
+    u8 *nodes = alloc_only_pool_alloc(pool, compiled->size);
+    s32 i;
+
+    if (nodes == NULL) {
+        return NULL;
+    }
+
+    memcpy(nodes, compiled_geo_image(compiled), compiled->size);
+    for (i = 0; i < compiled->numRelocs; i++) {
+        *(uintptr_t *) (nodes + relocs[i]) += (uintptr_t) nodes;
+    }
+    for (i = 0; i < compiled->numFuncNodes; i++) {
+        fnNode = (struct FnGraphNode *) (nodes + funcNodes[i]);
+        fnNode->func(GEO_CONTEXT_CREATE, &fnNode->node, pool);
+    }
+
+    return (struct GraphNode *) (nodes + compiled->rootOffset);
+}
+#endif
+
 struct GraphNode *process_geo_layout(struct AllocOnlyPool *pool, void *segptr) {
+#ifdef COMPILED_GEO_LAYOUTS
+    OSTime startTime = osGetTime();
+    struct CompiledGeoLayout *compiled = find_compiled_geo_layout(segptr);
+    u8 *start = pool->freePtr;
+
+    if (compiled != NULL) {
+        gGraphNodePool = pool;
+        gCurRootGraphNode = load_compiled_geo_layout(pool, compiled);
+        gCompiledGeoStats.numLoaded++;
+        gCompiledGeoStats.loadTime += osGetTime() - startTime;
+        return gCurRootGraphNode;
+    }
+    sGeoLayoutSegments = 0;
+#endif
+
     // set by register_scene_graph_node when gCurGraphNodeIndex is 0
     // and gCurRootGraphNode is NULL
     gCurRootGraphNode = NULL;
@@ -782,7 +1102,7 @@ struct GraphNode *process_geo_layout(struct AllocOnlyPool *pool, void *segptr) {
     gGeoLayoutStackIndex = 2;
     gGeoLayoutReturnIndex = 2; // stack index is often copied here?
 
-    gGeoLayoutCommand = segmented_to_virtual(segptr);
+    gGeoLayoutCommand = geo_layout_segmented_to_virtual(segptr);
 
     gGraphNodePool = pool;
 
@@ -793,5 +1113,13 @@ struct GraphNode *process_geo_layout(struct AllocOnlyPool *pool, void *segptr) {
         GeoLayoutJumpTable[gGeoLayoutCommand[0x00]]();
     }
 
+#ifdef COMPILED_GEO_LAYOUTS
+    gCompiledGeoStats.numRun++;
+    gCompiledGeoStats.runTime += osGetTime() - startTime;
+    if (gCurRootGraphNode != NULL) {
+        compile_geo_layout(segptr, gCurRootGraphNode, start, pool->freePtr);
+    }
+#endif
+
     return gCurRootGraphNode;
 }
@@ -84,4 +84,19 @@ void geo_layout_cmd_node_culling_radius(void);
 
 struct GraphNode *process_geo_layout(struct AllocOnlyPool *a0, void *segptr);
 
+#ifdef COMPILED_GEO_LAYOUTS
+/**
+ * How many geo layouts process_geo_layout has run the commands of and copied
+ * from a compiled copy since boot, and the osGetTime ticks spent on each.
+ */
+struct CompiledGeoStats {
+    u32 numRun;
+    u32 numLoaded;
+    u32 runTime;
+    u32 loadTime;
+};
+
+extern struct CompiledGeoStats gCompiledGeoStats;
+#endif
+
 #endif // GEO_LAYOUT_H
@@ -114,6 +114,10 @@ struct DisplayListNode {
     Mtx *transform;
     void *displayList;
     struct DisplayListNode *next;
+#ifdef MASTER_LIST_SORTING
+    // Made by a geo function, so it may rely on or change state left by the others
+    u8 isGenerated;
+#endif
 };
 
 /** GraphNode that manages the 8 top-level display lists that will be drawn
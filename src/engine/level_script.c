@@ -279,10 +279,9 @@ static void level_cmd_load_mio0(void) {
 }
 
 static void level_cmd_load_mario_head(void) {
-    // TODO: Fix these hardcoded sizes
-    void *addr = main_pool_alloc(DOUBLE_SIZE_ON_64_BIT(0xE1000), MEMORY_POOL_LEFT);
+    void *addr = main_pool_alloc(GD_HEAP_SIZE, MEMORY_POOL_LEFT);
     if (addr != NULL) {
-        gdm_init(addr, DOUBLE_SIZE_ON_64_BIT(0xE1000));
+        gdm_init(addr, GD_HEAP_SIZE);
         gd_add_to_heap(gZBuffer, sizeof(gZBuffer));               // 0x25800
         gd_add_to_heap(gFramebuffer0, 3 * sizeof(gFramebuffer0)); // 0x70800
         gdm_setup();
@@ -8,6 +8,119 @@
 #include "surface_collision.h"
 #include "surface_load.h"
 
+#ifdef SURFACE_COLLISION_PROFILER
+/**
+ * How many surfaces each type of query has tested since the debug
+ * surface info was last printed.
+ */
+struct NumSurfacesVisited gNumSurfacesVisited;
+#endif
+
+#ifdef SURFACE_QUERY_CACHE
+/**************************************************
+ *                   QUERY CACHE                  *
+ **************************************************/
+
+#define SURFACE_QUERY_CACHE_SIZE 64
+
+#define SURFACE_QUERY_FLOOR  0
+#define SURFACE_QUERY_CEIL   1
+#define SURFACE_QUERY_CAMERA 2 // made with gCheckingSurfaceCollisionsForCamera set
+
+/**
+ * The result of a floor or ceiling query. Queries only use the whole number
+ * part of the position, so any query at the same one gets the same result
+ * until the surfaces change.
+ */
+struct SurfaceQuery {
+    u32 timestamp;
+    TerrainData x, y, z;
+    u8 type;
+    u8 floorMissed; // whether the floor query counted a miss in gNumFindFloorMisses
+    f32 height;
+    struct Surface *surface;
+};
+
+struct SurfaceQueryCacheStats gSurfaceQueryCacheStats;
+
+static struct SurfaceQuery sSurfaceQueryCache[SURFACE_QUERY_CACHE_SIZE];
+// Queries are only valid while the surfaces are the same as when they were made
+static u32 sSurfaceQueryCacheTimestamp = 1;
+
+/**
+ * Forget the cached queries and their counts, at the start of a frame.
+ */
+void reset_surface_query_cache(void) {
+    sSurfaceQueryCacheTimestamp++;
+    gSurfaceQueryCacheStats.hits = 0;
+    gSurfaceQueryCacheStats.misses = 0;
+}
+
+/**
+ * Forget the cached queries in the given cells, since surfaces were added to
+ * or removed from them. Queries elsewhere only read other cells, so they stay.
+ */
+void invalidate_surface_query_cache(s32 minCellX, s32 minCellZ, s32 maxCellX, s32 maxCellZ) {
+    struct SurfaceQuery *query;
+    s32 cellX, cellZ;
+    s32 i;
+
+    for (i = 0; i < SURFACE_QUERY_CACHE_SIZE; i++) {
+        query = &sSurfaceQueryCache[i];
+        if (query->timestamp == sSurfaceQueryCacheTimestamp) {
+            cellX = ((query->x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+            cellZ = ((query->z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
+
+            if (cellX >= minCellX && cellX <= maxCellX && cellZ >= minCellZ && cellZ <= maxCellZ) {
+                query->timestamp = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Find the slot for a query of the given type at (x, y, z). Sets `found` if it
+ * already holds the result of that query.
+ */
+static struct SurfaceQuery *find_surface_query(s32 x, s32 y, s32 z, s32 type, s32 *found) {
+    struct SurfaceQuery *query;
+    u32 hash;
+
+    if (gCheckingSurfaceCollisionsForCamera != 0) {
+        type |= SURFACE_QUERY_CAMERA;
+    }
+
+    // The type goes in the bits that pick the slot, so that floor and ceiling
+    // queries at the same position don't evict each other.
+    hash = ((u32) x * 0x9E3779B1) ^ ((u32) z * 0x85EBCA77) ^ ((u32) y * 0xC2B2AE3D) ^ (type << 16);
+    query = &sSurfaceQueryCache[(hash >> 16) % SURFACE_QUERY_CACHE_SIZE];
+
+    *found = query->timestamp == sSurfaceQueryCacheTimestamp && query->x == x && query->y == y
+             && query->z == z && query->type == type;
+    if (*found) {
+        gSurfaceQueryCacheStats.hits++;
+    } else {
+        gSurfaceQueryCacheStats.misses++;
+        query->timestamp = 0;
+        query->x = x;
+        query->y = y;
+        query->z = z;
+        query->type = type;
+    }
+
+    return query;
+}
+
+/**
+ * Save the result of the query in `query`, from find_surface_query.
+ */
+static void save_surface_query(struct SurfaceQuery *query, f32 height, struct Surface *surface) {
+    query->timestamp = sSurfaceQueryCacheTimestamp;
+    query->height = height;
+    query->surface = surface;
+}
+#endif
+
 /**************************************************
  *                      WALLS                     *
  **************************************************/
@@ -38,6 +151,9 @@ static s32 find_wall_collisions_from_list(struct SurfaceNode *surfaceNode,
     while (surfaceNode != NULL) {
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
+#ifdef SURFACE_COLLISION_PROFILER
+        gNumSurfacesVisited.wall++;
+#endif
 
         // Exclude a large number of walls immediately to optimize.
         if (y < surf->lowerY || y > surf->upperY) {
@@ -171,6 +287,27 @@ s32 f32_find_wall_collision(f32 *xPtr, f32 *yPtr, f32 *zPtr, f32 offsetY, f32 ra
     return numCollisions;
 }
 
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+/**
+ * Find the list of course walls to check. This is the subdivided cell the check
+ * is in, unless object walls pushed it out of the 16x16 cell it started in.
+ */
+static struct SurfaceNode *find_static_wall_list(struct WallCollisionData *colData, s16 cellX,
+                                                 s16 cellZ) {
+    f32 x = colData->x + LEVEL_BOUNDARY_MAX;
+    f32 z = colData->z + LEVEL_BOUNDARY_MAX;
+
+    if (x < cellX * CELL_SIZE || x >= (cellX + 1) * CELL_SIZE || z < cellZ * CELL_SIZE
+        || z >= (cellZ + 1) * CELL_SIZE) {
+        return gStaticWallPartition[cellZ][cellX].next;
+    }
+
+    return gStaticSurfacePartition[(s32) z / STATIC_CELL_SIZE][(s32) x / STATIC_CELL_SIZE]
+                                  [SPATIAL_PARTITION_WALLS]
+                                      .next;
+}
+#endif
+
 /**
  * Find wall collisions and receive their push.
  */
@@ -200,7 +337,11 @@ s32 find_wall_collisions(struct WallCollisionData *colData) {
     numCollisions += find_wall_collisions_from_list(node, colData);
 
     // Check for surfaces that are a part of level geometry.
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+    node = find_static_wall_list(colData, cellX, cellZ);
+#else
     node = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_WALLS].next;
+#endif
     numCollisions += find_wall_collisions_from_list(node, colData);
 
     // Increment the debug tracker.
@@ -228,6 +369,9 @@ static struct Surface *find_ceil_from_list(struct SurfaceNode *surfaceNode, s32
     while (surfaceNode != NULL) {
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
+#ifdef SURFACE_COLLISION_PROFILER
+        gNumSurfacesVisited.ceil++;
+#endif
 
         x1 = surf->vertex1[0];
         z1 = surf->vertex1[2];
@@ -302,6 +446,10 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
 
     struct Surface *ceil, *dynamicCeil;
     struct SurfaceNode *surfaceList;
+#ifdef SURFACE_QUERY_CACHE
+    struct SurfaceQuery *query;
+    s32 found;
+#endif
 
     f32 height = CELL_HEIGHT_LIMIT;
     f32 dynamicHeight = CELL_HEIGHT_LIMIT;
@@ -322,6 +470,15 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
         return height;
     }
 
+#ifdef SURFACE_QUERY_CACHE
+    query = find_surface_query(x, y, z, SURFACE_QUERY_CEIL, &found);
+    if (found) {
+        *pceil = query->surface;
+        gNumCalls.ceil++;
+        return query->height;
+    }
+#endif
+
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
@@ -331,7 +488,9 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     dynamicCeil = find_ceil_from_list(surfaceList, x, y, z, &dynamicHeight);
 
     // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_CEILS].next;
+    cellX = ((x + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE) & NUM_STATIC_CELLS_INDEX;
+    cellZ = ((z + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE) & NUM_STATIC_CELLS_INDEX;
+    surfaceList = STATIC_SURFACE_LIST(cellZ, cellX, SPATIAL_PARTITION_CEILS, y);
     ceil = find_ceil_from_list(surfaceList, x, y, z, &height);
 
     if (dynamicHeight < height) {
@@ -340,6 +499,9 @@ f32 find_ceil(f32 posX, f32 posY, f32 posZ, struct Surface **pceil) {
     }
 
     *pceil = ceil;
+#ifdef SURFACE_QUERY_CACHE
+    save_surface_query(query, height, ceil);
+#endif
 
     // Increment the debug tracker.
     gNumCalls.ceil++;
@@ -405,6 +567,9 @@ static struct Surface *find_floor_from_list(struct SurfaceNode *surfaceNode, s32
     while (surfaceNode != NULL) {
         surf = surfaceNode->surface;
         surfaceNode = surfaceNode->next;
+#ifdef SURFACE_COLLISION_PROFILER
+        gNumSurfacesVisited.floor++;
+#endif
 
         x1 = surf->vertex1[0];
         z1 = surf->vertex1[2];
@@ -510,6 +675,10 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
 
     struct Surface *floor, *dynamicFloor;
     struct SurfaceNode *surfaceList;
+#ifdef SURFACE_QUERY_CACHE
+    struct SurfaceQuery *query = NULL;
+    s32 found;
+#endif
 
     f32 height = FLOOR_LOWER_LIMIT;
     f32 dynamicHeight = FLOOR_LOWER_LIMIT;
@@ -530,6 +699,21 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         return height;
     }
 
+#ifdef SURFACE_QUERY_CACHE
+    // Queries that include intangible floors are rare, and aren't cached.
+    if (!gFindFloorIncludeSurfaceIntangible) {
+        query = find_surface_query(x, y, z, SURFACE_QUERY_FLOOR, &found);
+        if (found) {
+            *pfloor = query->surface;
+            if (query->floorMissed) {
+                gNumFindFloorMisses++;
+            }
+            gNumCalls.floor++;
+            return query->height;
+        }
+    }
+#endif
+
     // Each level is split into cells to limit load, find the appropriate cell.
     cellX = ((x + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
     cellZ = ((z + LEVEL_BOUNDARY_MAX) / CELL_SIZE) & NUM_CELLS_INDEX;
@@ -539,7 +723,9 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     dynamicFloor = find_floor_from_list(surfaceList, x, y, z, &dynamicHeight);
 
     // Check for surfaces that are a part of level geometry.
-    surfaceList = gStaticSurfacePartition[cellZ][cellX][SPATIAL_PARTITION_FLOORS].next;
+    cellX = ((x + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE) & NUM_STATIC_CELLS_INDEX;
+    cellZ = ((z + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE) & NUM_STATIC_CELLS_INDEX;
+    surfaceList = STATIC_SURFACE_LIST(cellZ, cellX, SPATIAL_PARTITION_FLOORS, y);
     floor = find_floor_from_list(surfaceList, x, y, z, &height);
 
     // To prevent the Merry-Go-Round room from loading when Mario passes above the hole that leads
@@ -551,7 +737,10 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
         //  (happens when there is no floor under the SURFACE_INTANGIBLE floor) but returns the height
         //  of the SURFACE_INTANGIBLE floor instead of the typical -11000 returned for a NULL floor.
         if (floor != NULL && floor->type == SURFACE_INTANGIBLE) {
-            floor = find_floor_from_list(surfaceList, x, (s32) (height - 200.0f), z, &height);
+            s32 belowY = (s32) (height - 200.0f);
+
+            surfaceList = STATIC_SURFACE_LIST(cellZ, cellX, SPATIAL_PARTITION_FLOORS, belowY);
+            floor = find_floor_from_list(surfaceList, x, belowY, z, &height);
         }
     } else {
         // To prevent accidentally leaving the floor tangible, stop checking for it.
@@ -562,6 +751,11 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     if (floor == NULL) {
         gNumFindFloorMisses++;
     }
+#ifdef SURFACE_QUERY_CACHE
+    if (query != NULL) {
+        query->floorMissed = (floor == NULL);
+    }
+#endif
 
     if (dynamicHeight > height) {
         floor = dynamicFloor;
@@ -569,6 +763,11 @@ f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor) {
     }
 
     *pfloor = floor;
+#ifdef SURFACE_QUERY_CACHE
+    if (query != NULL) {
+        save_surface_query(query, height, floor);
+    }
+#endif
 
     // Increment the debug tracker.
     gNumCalls.floor++;
@@ -673,9 +872,22 @@ static s32 surface_list_length(struct SurfaceNode *list) {
     return count;
 }
 
+#ifdef SURFACE_COLLISION_PROFILER
+/**
+ * Finds the average number of surfaces tested per call for debug purposes.
+ */
+static s32 surfaces_visited_per_call(s32 numVisited, s16 numCalls) {
+    if (numCalls == 0) {
+        return 0;
+    }
+
+    return numVisited / numCalls;
+}
+#endif
+
 /**
  * Print the area,number of walls, how many times they were called,
- * and some allocation information.
+ * how many surfaces each call tested, and some allocation information.
  */
 void debug_surface_list_info(f32 xPos, f32 zPos) {
     struct SurfaceNode *list;
@@ -685,10 +897,10 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
 
     s32 cellX = (xPos + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
     s32 cellZ = (zPos + LEVEL_BOUNDARY_MAX) / CELL_SIZE;
+    s32 staticCellX = ((s32) (xPos + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE) & NUM_STATIC_CELLS_INDEX;
+    s32 staticCellZ = ((s32) (zPos + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE) & NUM_STATIC_CELLS_INDEX;
 
-    list = gStaticSurfacePartition[cellZ & NUM_CELLS_INDEX][cellX & NUM_CELLS_INDEX]
-                                  [SPATIAL_PARTITION_FLOORS]
-                                      .next;
+    list = gStaticSurfacePartition[staticCellZ][staticCellX][SPATIAL_PARTITION_FLOORS].next;
     numFloors += surface_list_length(list);
 
     list = gDynamicSurfacePartition[cellZ & NUM_CELLS_INDEX][cellX & NUM_CELLS_INDEX]
@@ -696,9 +908,7 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
                                        .next;
     numFloors += surface_list_length(list);
 
-    list = gStaticSurfacePartition[cellZ & NUM_CELLS_INDEX][cellX & NUM_CELLS_INDEX]
-                                  [SPATIAL_PARTITION_WALLS]
-                                      .next;
+    list = gStaticSurfacePartition[staticCellZ][staticCellX][SPATIAL_PARTITION_WALLS].next;
     numWalls += surface_list_length(list);
 
     list = gDynamicSurfacePartition[cellZ & NUM_CELLS_INDEX][cellX & NUM_CELLS_INDEX]
@@ -706,9 +916,7 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
                                        .next;
     numWalls += surface_list_length(list);
 
-    list = gStaticSurfacePartition[cellZ & NUM_CELLS_INDEX][cellX & NUM_CELLS_INDEX]
-                                  [SPATIAL_PARTITION_CEILS]
-                                      .next;
+    list = gStaticSurfacePartition[staticCellZ][staticCellX][SPATIAL_PARTITION_CEILS].next;
     numCeils += surface_list_length(list);
 
     list = gDynamicSurfacePartition[cellZ & NUM_CELLS_INDEX][cellX & NUM_CELLS_INDEX]
@@ -735,10 +943,36 @@ void debug_surface_list_info(f32 xPos, f32 zPos) {
     print_debug_top_down_mapinfo("listal %d", gSurfaceNodesAllocated);
     print_debug_top_down_mapinfo("statbg %d", gNumStaticSurfaces);
     print_debug_top_down_mapinfo("movebg %d", gSurfacesAllocated - gNumStaticSurfaces);
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    // Object surfaces reloaded and retained this frame.
+    print_debug_top_down_mapinfo("reload %d", gDynamicSurfaceCounts.reloaded);
+    print_debug_top_down_mapinfo("retain %d", gDynamicSurfaceCounts.retained);
+#endif
+#ifdef SURFACE_QUERY_CACHE
+    // Floor and ceiling checks answered from the query cache, and made, this frame.
+    print_debug_top_down_mapinfo("qhit  %d", gSurfaceQueryCacheStats.hits);
+    print_debug_top_down_mapinfo("qmiss %d", gSurfaceQueryCacheStats.misses);
+#endif
+
+#ifdef SURFACE_COLLISION_PROFILER
+    // Surfaces tested per ground, wall and roof check.
+    print_debug_top_down_mapinfo("vg %d",
+                                 surfaces_visited_per_call(gNumSurfacesVisited.floor, gNumCalls.floor));
+    print_debug_top_down_mapinfo("vw %d",
+                                 surfaces_visited_per_call(gNumSurfacesVisited.wall, gNumCalls.wall));
+    print_debug_top_down_mapinfo("vr %d",
+                                 surfaces_visited_per_call(gNumSurfacesVisited.ceil, gNumCalls.ceil));
+#endif
 
     gNumCalls.floor = 0;
     gNumCalls.ceil = 0;
     gNumCalls.wall = 0;
+
+#ifdef SURFACE_COLLISION_PROFILER
+    gNumSurfacesVisited.floor = 0;
+    gNumSurfacesVisited.ceil = 0;
+    gNumSurfacesVisited.wall = 0;
+#endif
 }
 
 /**
@@ -26,6 +26,28 @@ struct WallCollisionData {
     /*0x18*/ struct Surface *walls[4];
 };
 
+#ifdef SURFACE_COLLISION_PROFILER
+struct NumSurfacesVisited {
+    s32 floor;
+    s32 ceil;
+    s32 wall;
+};
+
+extern struct NumSurfacesVisited gNumSurfacesVisited;
+#endif
+
+#ifdef SURFACE_QUERY_CACHE
+/**
+ * Floor and ceiling queries answered from the query cache, and made, this frame.
+ */
+struct SurfaceQueryCacheStats {
+    s32 hits;
+    s32 misses;
+};
+
+extern struct SurfaceQueryCacheStats gSurfaceQueryCacheStats;
+#endif
+
 struct FloorGeometry {
     u8 filler[16]; // possibly position data?
     f32 normalX;
@@ -42,6 +64,10 @@ f32 find_floor_height(f32 x, f32 y, f32 z);
 f32 find_floor(f32 xPos, f32 yPos, f32 zPos, struct Surface **pfloor);
 f32 find_water_level(f32 x, f32 z);
 f32 find_poison_gas_level(f32 x, f32 z);
+#ifdef SURFACE_QUERY_CACHE
+void reset_surface_query_cache(void);
+void invalidate_surface_query_cache(s32 minCellX, s32 minCellZ, s32 maxCellX, s32 maxCellZ);
+#endif
 void debug_surface_list_info(f32 xPos, f32 zPos);
 
 #endif // SURFACE_COLLISION_H
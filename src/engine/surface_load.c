@@ -1,4 +1,5 @@
 #include <PR/ultratypes.h>
+#include <PR/os_libc.h>
 
 #include "sm64.h"
 #include "game/ingame_menu.h"
@@ -17,11 +18,35 @@ s32 unused8038BE90;
 
 /**
  * Partitions for course and object surfaces. The arrays represent
- * the 16x16 cells that each level is split into.
+ * the 16x16 cells that each level is split into, with the course cells
+ * optionally subdivided further (see STATIC_SURFACE_SUBDIVISIONS).
  */
-SpatialPartitionCell gStaticSurfacePartition[NUM_CELLS][NUM_CELLS];
+SpatialPartitionCell gStaticSurfacePartition[NUM_STATIC_CELLS][NUM_STATIC_CELLS];
 SpatialPartitionCell gDynamicSurfacePartition[NUM_CELLS][NUM_CELLS];
 
+#if STATIC_SURFACE_Y_BANDS > 1
+/**
+ * Entry points into the course floor and ceiling lists for each height band,
+ * for each static cell. Allocated from the main pool in alloc_surface_pools.
+ */
+SurfaceYBandCell (*gStaticSurfaceYBands)[NUM_STATIC_CELLS];
+#endif
+
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+/**
+ * Course walls for each of the 16x16 cells. Object walls can push a wall check
+ * out of the cell it started in, and the subdivided lists only cover their own
+ * cell, so find_wall_collisions falls back to these.
+ */
+struct SurfaceNode gStaticWallPartition[NUM_CELLS][NUM_CELLS];
+
+/**
+ * How far outside its bounds a wall can still push. Wall checks are capped at a
+ * radius of 200, and the projection axis is at most 45 degrees off the normal.
+ */
+#define STATIC_WALL_CELL_MARGIN 300
+#endif
+
 /**
  * Pools of data to contain either surface nodes or surfaces.
  */
@@ -35,16 +60,56 @@ s16 sSurfacePoolSize;
 
 u8 unused8038EEA8[0x30];
 
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+/**
+ * The surfaces an object loaded, and the transform and collision model they
+ * were loaded with. If neither has changed, the object keeps its surfaces.
+ */
+struct ObjectSurfaces {
+    TerrainData *collisionData; // NULL if the object has no surfaces loaded
+    Vec3f transform[4];
+    struct SurfaceNode *surfaces; // The object's surfaces, chained through nodes not in any cell
+    s16 numSurfaces;
+    s16 minCellX, minCellZ, maxCellX, maxCellZ;
+    u8 loaded; // Whether the object loaded its surfaces this frame
+};
+
+/**
+ * Loaded surfaces for each object in gObjectPool.
+ */
+static struct ObjectSurfaces sObjectSurfaces[OBJECT_POOL_CAPACITY];
+
+/**
+ * Surface nodes and surfaces that were freed by objects unloading their surfaces.
+ * Free surfaces are chained through nodes that point to them.
+ */
+static struct SurfaceNode *sFreeSurfaceNodes;
+static struct SurfaceNode *sFreeSurfaces;
+
+struct DynamicSurfaceCounts gDynamicSurfaceCounts;
+#endif
+
 /**
  * Allocate the part of the surface node pool to contain a surface node.
  */
 static struct SurfaceNode *alloc_surface_node(void) {
-    struct SurfaceNode *node = &sSurfaceNodePool[gSurfaceNodesAllocated];
+    struct SurfaceNode *node;
+
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    if (sFreeSurfaceNodes != NULL) {
+        node = sFreeSurfaceNodes;
+        sFreeSurfaceNodes = node->next;
+        node->next = NULL;
+        return node;
+    }
+#endif
+
+    node = &sSurfaceNodePool[gSurfaceNodesAllocated];
     gSurfaceNodesAllocated++;
 
     node->next = NULL;
 
-    if (gSurfaceNodesAllocated >= 7000) {
+    if (gSurfaceNodesAllocated >= SURFACE_NODE_POOL_SIZE) {
         CN_DEBUG_PRINTF((" mcMakeBGCheckList OVERFLOW\n"));
     }
 
@@ -56,12 +121,28 @@ static struct SurfaceNode *alloc_surface_node(void) {
  * initialize the surface.
  */
 static struct Surface *alloc_surface(void) {
+    struct Surface *surface = NULL;
+
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    struct SurfaceNode *node = sFreeSurfaces;
 
-    struct Surface *surface = &sSurfacePool[gSurfacesAllocated];
-    gSurfacesAllocated++;
+    // Reuse a surface that an object unloaded, and free the node that held it.
+    if (node != NULL) {
+        surface = node->surface;
+        sFreeSurfaces = node->next;
 
-    if (gSurfacesAllocated >= sSurfacePoolSize) {
-        CN_DEBUG_PRINTF((" mcMakeBGCheckData OVERFLOW\n"));
+        node->next = sFreeSurfaceNodes;
+        sFreeSurfaceNodes = node;
+    }
+#endif
+
+    if (surface == NULL) {
+        surface = &sSurfacePool[gSurfacesAllocated];
+        gSurfacesAllocated++;
+
+        if (gSurfacesAllocated >= sSurfacePoolSize) {
+            CN_DEBUG_PRINTF((" mcMakeBGCheckData OVERFLOW\n"));
+        }
     }
 
     surface->type = 0;
@@ -76,8 +157,8 @@ static struct Surface *alloc_surface(void) {
 /**
  * Iterates through the entire partition, clearing the surfaces.
  */
-static void clear_spatial_partition(SpatialPartitionCell *cells) {
-    register s32 i = NUM_CELLS * NUM_CELLS;
+static void clear_spatial_partition(SpatialPartitionCell *cells, s32 numCells) {
+    register s32 i = numCells * numCells;
 
     while (i--) {
         (*cells)[SPATIAL_PARTITION_FLOORS].next = NULL;
@@ -92,39 +173,125 @@ static void clear_spatial_partition(SpatialPartitionCell *cells) {
  * Clears the static (level) surface partitions for new use.
  */
 static void clear_static_surfaces(void) {
-    clear_spatial_partition(&gStaticSurfacePartition[0][0]);
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+    register s32 i = NUM_CELLS * NUM_CELLS;
+    struct SurfaceNode *walls = &gStaticWallPartition[0][0];
+
+    while (i--) {
+        walls->next = NULL;
+        walls++;
+    }
+#endif
+
+    clear_spatial_partition(&gStaticSurfacePartition[0][0], NUM_STATIC_CELLS);
+#if STATIC_SURFACE_Y_BANDS > 1
+    bzero(gStaticSurfaceYBands, NUM_STATIC_CELLS * NUM_STATIC_CELLS * sizeof(SurfaceYBandCell));
+#endif
 }
 
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
 /**
- * Add a surface to the correct cell list of surfaces.
- * @param dynamic Determines whether the surface is static or dynamic
- * @param cellX The X position of the cell in which the surface resides
- * @param cellZ The Z position of the cell in which the surface resides
- * @param surface The surface to add
+ * Forget which surfaces each object has loaded, for when the dynamic
+ * partition and surface pools are cleared.
  */
-static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surface *surface) {
-    struct SurfaceNode *newNode = alloc_surface_node();
-    struct SurfaceNode *list;
-    s16 surfacePriority;
-    s16 priority;
-    s16 sortDir;
+static void clear_object_surfaces(void) {
+    s32 i;
+
+    for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+        sObjectSurfaces[i].collisionData = NULL;
+        sObjectSurfaces[i].surfaces = NULL;
+        sObjectSurfaces[i].numSurfaces = 0;
+        sObjectSurfaces[i].loaded = FALSE;
+    }
+
+    sFreeSurfaceNodes = NULL;
+    sFreeSurfaces = NULL;
+}
+#endif
+
+/**
+ * Returns which cell list (floors, ceilings or walls) a surface belongs in.
+ * @param sortDir Set to the direction that list is sorted in
+ */
+static s16 get_surface_list_index(struct Surface *surface, s16 *sortDir) {
     s16 listIndex;
 
     if (surface->normal.y > 0.01) {
         listIndex = SPATIAL_PARTITION_FLOORS;
-        sortDir = 1; // highest to lowest, then insertion order
+        *sortDir = 1; // highest to lowest, then insertion order
     } else if (surface->normal.y < -0.01) {
         listIndex = SPATIAL_PARTITION_CEILS;
-        sortDir = -1; // lowest to highest, then insertion order
+        *sortDir = -1; // lowest to highest, then insertion order
     } else {
         listIndex = SPATIAL_PARTITION_WALLS;
-        sortDir = 0; // insertion order
+        *sortDir = 0; // insertion order
 
         if (surface->normal.x < -0.707 || surface->normal.x > 0.707) {
             surface->flags |= SURFACE_FLAG_X_PROJECTION;
         }
     }
 
+    return listIndex;
+}
+
+/**
+ * Returns the height band that a height is in.
+ */
+s32 get_surface_y_band(s32 y) {
+    s32 band = (y + LEVEL_BOUNDARY_MAX) / SURFACE_Y_BAND_SIZE;
+
+    if (band < 0) {
+        band = 0;
+    }
+
+    if (band > STATIC_SURFACE_Y_BANDS - 1) {
+        band = STATIC_SURFACE_Y_BANDS - 1;
+    }
+
+    return band;
+}
+
+#if STATIC_SURFACE_Y_BANDS > 1
+/**
+ * Returns whether a query anywhere in a height band could find a floor whose
+ * lowerY is surfaceY (sortDir 1), or a ceiling whose upperY is surfaceY (sortDir -1).
+ */
+static s32 surface_reachable_from_y_band(s32 surfaceY, s16 sortDir, s32 band) {
+    s32 bandBottom = band * SURFACE_Y_BAND_SIZE - LEVEL_BOUNDARY_MAX;
+
+    if (sortDir > 0) {
+        // The top band has no upper limit, so every floor can be reached from it.
+        return band == STATIC_SURFACE_Y_BANDS - 1
+               || surfaceY <= bandBottom + SURFACE_Y_BAND_SIZE - 1 + SURFACE_Y_BAND_BUFFER;
+    } else {
+        // Likewise for ceilings and the bottom band.
+        return band == 0 || surfaceY >= bandBottom - SURFACE_Y_BAND_BUFFER;
+    }
+}
+#endif
+
+/**
+ * Insert a surface into a cell list, keeping the list sorted.
+ * @param list The head of the cell list
+ * @param surface The surface to add
+ * @param sortDir The direction the list is sorted in
+ * @param yBands The list's height band entry points to update, or NULL (unused with 1 band)
+ */
+static void insert_surface_node(struct SurfaceNode *list, struct Surface *surface, s16 sortDir,
+                                UNUSED struct SurfaceNode **yBands) {
+    struct SurfaceNode *newNode = alloc_surface_node();
+    s16 surfacePriority;
+    s16 priority;
+#if STATIC_SURFACE_Y_BANDS > 1
+    s32 band;
+
+    s32 surfaceY = (sortDir > 0) ? surface->lowerY : surface->upperY;
+
+    // The lowest floor or highest ceiling in the list before the new node.
+    s32 prevY = surfaceY;
+    s32 hasPrev = FALSE;
+#endif
+
     //! (Surface Cucking) Surfaces are sorted by the height of their first
     //  vertex. Since vertices aren't ordered by height, this causes many
     //  lower triangles to be sorted higher. This worsens surface cucking since
@@ -135,12 +302,6 @@ static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surfac
 
     newNode->surface = surface;
 
-    if (dynamic) {
-        list = &gDynamicSurfacePartition[cellZ][cellX][listIndex];
-    } else {
-        list = &gStaticSurfacePartition[cellZ][cellX][listIndex];
-    }
-
     // Loop until we find the appropriate place for the surface in the list.
     while (list->next != NULL) {
         priority = list->next->surface->vertex1[1] * sortDir;
@@ -150,10 +311,60 @@ static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surfac
         }
 
         list = list->next;
+
+#if STATIC_SURFACE_Y_BANDS > 1
+        if (sortDir > 0 && (!hasPrev || list->surface->lowerY < prevY)) {
+            prevY = list->surface->lowerY;
+        } else if (sortDir < 0 && (!hasPrev || list->surface->upperY > prevY)) {
+            prevY = list->surface->upperY;
+        }
+        hasPrev = TRUE;
+#endif
     }
 
     newNode->next = list->next;
     list->next = newNode;
+
+#if STATIC_SURFACE_Y_BANDS > 1
+    // The new node becomes a band's entry point if it is reachable from that band
+    // and nothing before it in the list was.
+    if (yBands != NULL) {
+        for (band = 0; band < STATIC_SURFACE_Y_BANDS; band++) {
+            if (surface_reachable_from_y_band(surfaceY, sortDir, band)
+                && !(hasPrev && surface_reachable_from_y_band(prevY, sortDir, band))) {
+                yBands[band] = newNode;
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * Add a surface to the correct cell list of surfaces.
+ * @param dynamic Determines whether the surface is static or dynamic
+ * @param cellX The X position of the cell in which the surface resides
+ * @param cellZ The Z position of the cell in which the surface resides
+ * @param surface The surface to add
+ */
+static void add_surface_to_cell(s16 dynamic, s16 cellX, s16 cellZ, struct Surface *surface) {
+    struct SurfaceNode *list;
+    struct SurfaceNode **yBands = NULL;
+    s16 sortDir;
+    s16 listIndex = get_surface_list_index(surface, &sortDir);
+
+    if (dynamic) {
+        list = &gDynamicSurfacePartition[cellZ][cellX][listIndex];
+    } else {
+        list = &gStaticSurfacePartition[cellZ][cellX][listIndex];
+
+#if STATIC_SURFACE_Y_BANDS > 1
+        if (listIndex != SPATIAL_PARTITION_WALLS) {
+            yBands = gStaticSurfaceYBands[cellZ][cellX][listIndex];
+        }
+#endif
+    }
+
+    insert_surface_node(list, surface, sortDir, yBands);
 }
 
 /**
@@ -250,6 +461,81 @@ static s16 upper_cell_index(TerrainData coord) {
     return index;
 }
 
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+/**
+ * Returns the subdivided cell for a given x/z position, clamped to the
+ * subdivisions of the 16x16 cells [minCell, maxCell].
+ */
+static s32 static_cell_index(s32 coord, s16 minCell, s16 maxCell) {
+    s32 index = (coord + LEVEL_BOUNDARY_MAX) / STATIC_CELL_SIZE;
+
+    if (index < minCell * STATIC_SURFACE_SUBDIVISIONS) {
+        index = minCell * STATIC_SURFACE_SUBDIVISIONS;
+    }
+
+    if (index > maxCell * STATIC_SURFACE_SUBDIVISIONS + (STATIC_SURFACE_SUBDIVISIONS - 1)) {
+        index = maxCell * STATIC_SURFACE_SUBDIVISIONS + (STATIC_SURFACE_SUBDIVISIONS - 1);
+    }
+
+    return index;
+}
+
+/**
+ * Adds a course surface to every subdivided cell its bounds overlap, but only
+ * within the 16x16 cells it would normally be added to. This keeps each
+ * subdivided list an ordered subset of the full cell list, so queries give the
+ * same results as they would on the 16x16 grid.
+ * @param surface The surface to add
+ * @param minCellX, minCellZ, maxCellX, maxCellZ The 16x16 cells the surface is in
+ */
+static void add_static_surface(struct Surface *surface, s16 minCellX, s16 minCellZ, s16 maxCellX,
+                               s16 maxCellZ) {
+    s32 minX, minZ, maxX, maxZ;
+    s32 minSubX, minSubZ, maxSubX, maxSubZ;
+    s32 cellZ, cellX;
+    s32 margin = 0;
+    s16 sortDir;
+    s16 listIndex = get_surface_list_index(surface, &sortDir);
+    struct SurfaceNode **yBands = NULL;
+
+    if (minCellX > maxCellX || minCellZ > maxCellZ) {
+        return;
+    }
+
+    if (listIndex == SPATIAL_PARTITION_WALLS) {
+        for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
+            for (cellX = minCellX; cellX <= maxCellX; cellX++) {
+                insert_surface_node(&gStaticWallPartition[cellZ][cellX], surface, sortDir, NULL);
+            }
+        }
+
+        margin = STATIC_WALL_CELL_MARGIN;
+    }
+
+    minX = min_3(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0]) - margin;
+    minZ = min_3(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2]) - margin;
+    maxX = max_3(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0]) + margin;
+    maxZ = max_3(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2]) + margin;
+
+    minSubX = static_cell_index(minX, minCellX, maxCellX);
+    minSubZ = static_cell_index(minZ, minCellZ, maxCellZ);
+    maxSubX = static_cell_index(maxX, minCellX, maxCellX);
+    maxSubZ = static_cell_index(maxZ, minCellZ, maxCellZ);
+
+    for (cellZ = minSubZ; cellZ <= maxSubZ; cellZ++) {
+        for (cellX = minSubX; cellX <= maxSubX; cellX++) {
+#if STATIC_SURFACE_Y_BANDS > 1
+            yBands = (listIndex != SPATIAL_PARTITION_WALLS)
+                         ? gStaticSurfaceYBands[cellZ][cellX][listIndex]
+                         : NULL;
+#endif
+            insert_surface_node(&gStaticSurfacePartition[cellZ][cellX][listIndex], surface,
+                                sortDir, yBands);
+        }
+    }
+}
+#endif
+
 /**
  * Every level is split into 16x16 cells, this takes a surface, finds
  * the appropriate cells (with a buffer), and adds the surface to those
@@ -278,6 +564,13 @@ static void add_surface(struct Surface *surface, s32 dynamic) {
     minCellZ = lower_cell_index(minZ);
     maxCellZ = upper_cell_index(maxZ);
 
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+    if (!dynamic) {
+        add_static_surface(surface, minCellX, minCellZ, maxCellX, maxCellZ);
+        return;
+    }
+#endif
+
     for (cellZ = minCellZ; cellZ <= maxCellZ; cellZ++) {
         for (cellX = minCellX; cellX <= maxCellX; cellX++) {
             add_surface_to_cell(dynamic, cellX, cellZ, surface);
@@ -517,12 +810,18 @@ static void load_environmental_regions(TerrainData **data) {
 }
 
 /**
- * Allocate some of the main pool for surfaces (2300 surf) and for surface nodes (7000 nodes).
+ * Allocate some of the main pool for surfaces (2300 surf) and for surface nodes
+ * (7000 nodes, scaled by the number of static cells each 16x16 cell is split into).
  */
 void alloc_surface_pools(void) {
     sSurfacePoolSize = 2300;
-    sSurfaceNodePool = main_pool_alloc(7000 * sizeof(struct SurfaceNode), MEMORY_POOL_LEFT);
+    sSurfaceNodePool =
+        main_pool_alloc(SURFACE_NODE_POOL_SIZE * sizeof(struct SurfaceNode), MEMORY_POOL_LEFT);
     sSurfacePool = main_pool_alloc(sSurfacePoolSize * sizeof(struct Surface), MEMORY_POOL_LEFT);
+#if STATIC_SURFACE_Y_BANDS > 1
+    gStaticSurfaceYBands =
+        main_pool_alloc(NUM_STATIC_CELLS * NUM_STATIC_CELLS * sizeof(SurfaceYBandCell), MEMORY_POOL_LEFT);
+#endif
 }
 
 #ifdef NO_SEGMENTED_MEMORY
@@ -591,6 +890,15 @@ void load_area_terrain(s16 index, TerrainData *data, RoomData *surfaceRooms, s16
     gSurfacesAllocated = 0;
 
     clear_static_surfaces();
+#ifdef SURFACE_QUERY_CACHE
+    reset_surface_query_cache();
+#endif
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    // Object surfaces are no longer cleared every frame, and the pools they
+    // were allocated from are about to be reused.
+    clear_spatial_partition(&gDynamicSurfacePartition[0][0], NUM_CELLS);
+    clear_object_surfaces();
+#endif
 
     // A while loop iterating through each section of the level data. Sections of data
     // are prefixed by a terrain "type." This type is reused for surfaces as the surface
@@ -638,34 +946,187 @@ void load_area_terrain(s16 index, TerrainData *data, RoomData *surfaceRooms, s16
  * If not in time stop, clear the surface partitions.
  */
 void clear_dynamic_surfaces(void) {
+#ifdef SURFACE_QUERY_CACHE
+    reset_surface_query_cache();
+#endif
+
     if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
         gSurfacesAllocated = gNumStaticSurfaces;
         gSurfaceNodesAllocated = gNumStaticSurfaceNodes;
 
-        clear_spatial_partition(&gDynamicSurfacePartition[0][0]);
+        clear_spatial_partition(&gDynamicSurfacePartition[0][0], NUM_CELLS);
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+        clear_object_surfaces();
+#endif
     }
 }
 
 UNUSED static void unused_80383604(void) {
 }
 
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
 /**
- * Applies an object's transformation to the object's vertices.
+ * Returns the loaded surfaces for an object.
  */
-void transform_object_vertices(TerrainData **data, TerrainData *vertexData) {
-    register TerrainData *vertices;
-    register f32 vx, vy, vz;
-    register s32 numVertices;
+static struct ObjectSurfaces *get_object_surfaces(struct Object *obj) {
+    return &sObjectSurfaces[obj - gObjectPool];
+}
 
-    Mat4 *objectTransform;
-    Mat4 m;
+/**
+ * Remove an object's surfaces from the dynamic partition and free them.
+ */
+static void unload_object_surfaces(struct Object *obj) {
+    struct ObjectSurfaces *objSurfaces = get_object_surfaces(obj);
+    struct SurfaceNode *list;
+    struct SurfaceNode *node;
+    s32 cellZ, cellX, listIndex;
 
-    objectTransform = &gCurrentObject->transform;
+    if (objSurfaces->collisionData == NULL) {
+        return;
+    }
 
-    numVertices = *(*data);
-    (*data)++;
+#ifdef SURFACE_QUERY_CACHE
+    invalidate_surface_query_cache(objSurfaces->minCellX, objSurfaces->minCellZ,
+                                   objSurfaces->maxCellX, objSurfaces->maxCellZ);
+#endif
 
-    vertices = *data;
+    for (cellZ = objSurfaces->minCellZ; cellZ <= objSurfaces->maxCellZ; cellZ++) {
+        for (cellX = objSurfaces->minCellX; cellX <= objSurfaces->maxCellX; cellX++) {
+            for (listIndex = 0; listIndex < 3; listIndex++) {
+                list = &gDynamicSurfacePartition[cellZ][cellX][listIndex];
+
+                while ((node = list->next) != NULL) {
+                    if (node->surface->object == obj) {
+                        list->next = node->next;
+
+                        node->next = sFreeSurfaceNodes;
+                        sFreeSurfaceNodes = node;
+                    } else {
+                        list = node;
+                    }
+                }
+            }
+        }
+    }
+
+    // The chain of the object's surfaces joins the free surfaces as is.
+    if ((node = objSurfaces->surfaces) != NULL) {
+        while (node->next != NULL) {
+            node = node->next;
+        }
+
+        node->next = sFreeSurfaces;
+        sFreeSurfaces = objSurfaces->surfaces;
+    }
+
+    objSurfaces->collisionData = NULL;
+    objSurfaces->surfaces = NULL;
+    objSurfaces->numSurfaces = 0;
+}
+
+/**
+ * Returns whether an object's loaded surfaces were loaded from the given
+ * collision model and transform, meaning they would be loaded the same again.
+ */
+static s32 object_surfaces_match(struct ObjectSurfaces *objSurfaces, TerrainData *collisionData,
+                                  Mat4 m) {
+    s32 i;
+
+    if (objSurfaces->collisionData != collisionData) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 4; i++) {
+        if (objSurfaces->transform[i][0] != m[i][0] || objSurfaces->transform[i][1] != m[i][1]
+            || objSurfaces->transform[i][2] != m[i][2]) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Record a surface the current object has loaded, and the cells it is in.
+ */
+static void add_object_surface(struct ObjectSurfaces *objSurfaces, struct Surface *surface) {
+    struct SurfaceNode *node = alloc_surface_node();
+    s16 minCellX, minCellZ, maxCellX, maxCellZ;
+
+    minCellX = lower_cell_index(min_3(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0]));
+    minCellZ = lower_cell_index(min_3(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2]));
+    maxCellX = upper_cell_index(max_3(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0]));
+    maxCellZ = upper_cell_index(max_3(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2]));
+
+    node->surface = surface;
+    node->next = objSurfaces->surfaces;
+    objSurfaces->surfaces = node;
+    objSurfaces->numSurfaces++;
+
+    if (minCellX < objSurfaces->minCellX) {
+        objSurfaces->minCellX = minCellX;
+    }
+    if (minCellZ < objSurfaces->minCellZ) {
+        objSurfaces->minCellZ = minCellZ;
+    }
+    if (maxCellX > objSurfaces->maxCellX) {
+        objSurfaces->maxCellX = maxCellX;
+    }
+    if (maxCellZ > objSurfaces->maxCellZ) {
+        objSurfaces->maxCellZ = maxCellZ;
+    }
+}
+
+/**
+ * If not in time stop, start a frame of object surface updates. Unlike
+ * clear_dynamic_surfaces, objects keep their surfaces until they are loaded
+ * again with a different transform, or not loaded at all. Objects that were
+ * unloaded last frame lose their surfaces here.
+ */
+void begin_dynamic_surface_update(void) {
+    s32 i;
+
+#ifdef SURFACE_QUERY_CACHE
+    reset_surface_query_cache();
+#endif
+
+    if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
+        gDynamicSurfaceCounts.reloaded = 0;
+        gDynamicSurfaceCounts.retained = 0;
+
+        for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+            if (!(gObjectPool[i].activeFlags & ACTIVE_FLAG_ACTIVE)) {
+                unload_object_surfaces(&gObjectPool[i]);
+            }
+
+            sObjectSurfaces[i].loaded = FALSE;
+        }
+    }
+}
+
+/**
+ * If not in time stop, unload the surfaces of objects that have not loaded
+ * them so far this frame. Called once the surface objects have updated, since
+ * that is when most objects that have surfaces load them.
+ */
+void unload_stale_dynamic_surfaces(void) {
+    s32 i;
+
+    if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
+        for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
+            if (!sObjectSurfaces[i].loaded) {
+                unload_object_surfaces(&gObjectPool[i]);
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * Get the matrix that gCurrentObject's collision model is transformed by.
+ */
+static void get_object_collision_transform(Mat4 m) {
+    Mat4 *objectTransform = &gCurrentObject->transform;
 
     if (gCurrentObject->header.gfx.throwMatrix == NULL) {
         gCurrentObject->header.gfx.throwMatrix = objectTransform;
@@ -673,6 +1134,20 @@ void transform_object_vertices(TerrainData **data, TerrainData *vertexData) {
     }
 
     obj_apply_scale_to_matrix(gCurrentObject, m, *objectTransform);
+}
+
+/**
+ * Applies an object's transformation to the object's vertices.
+ */
+void transform_object_vertices(TerrainData **data, TerrainData *vertexData, Mat4 m) {
+    register TerrainData *vertices;
+    register f32 vx, vy, vz;
+    register s32 numVertices;
+
+    numVertices = *(*data);
+    (*data)++;
+
+    vertices = *data;
 
     // Go through all vertices, rotating and translating them to transform the object.
     while (numVertices--) {
@@ -689,6 +1164,32 @@ void transform_object_vertices(TerrainData **data, TerrainData *vertexData) {
     *data = vertices;
 }
 
+#ifdef SURFACE_QUERY_CACHE
+/**
+ * Grow the cells in `cells` (min x, min z, max x, max z) to the ones a dynamic
+ * surface was added to.
+ */
+static void update_query_cache_cells(struct Surface *surface, s16 *cells) {
+    s16 minCellX = lower_cell_index(min_3(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0]));
+    s16 minCellZ = lower_cell_index(min_3(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2]));
+    s16 maxCellX = upper_cell_index(max_3(surface->vertex1[0], surface->vertex2[0], surface->vertex3[0]));
+    s16 maxCellZ = upper_cell_index(max_3(surface->vertex1[2], surface->vertex2[2], surface->vertex3[2]));
+
+    if (minCellX < cells[0]) {
+        cells[0] = minCellX;
+    }
+    if (minCellZ < cells[1]) {
+        cells[1] = minCellZ;
+    }
+    if (maxCellX > cells[2]) {
+        cells[2] = maxCellX;
+    }
+    if (maxCellZ > cells[3]) {
+        cells[3] = maxCellZ;
+    }
+}
+#endif
+
 /**
  * Load in the surfaces for the gCurrentObject. This includes setting the flags, exertion, and room.
  */
@@ -698,6 +1199,13 @@ void load_object_surfaces(TerrainData **data, TerrainData *vertexData) {
     s32 numSurfaces;
     TerrainData hasForce;
     TerrainData flags;
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    struct ObjectSurfaces *objSurfaces;
+#endif
+#ifdef SURFACE_QUERY_CACHE
+    // The cells the surfaces were added to: min x, min z, max x, max z
+    s16 queryCells[4] = { NUM_CELLS, NUM_CELLS, -1, -1 };
+#endif
 
     surfaceType = *(*data);
     (*data)++;
@@ -710,6 +1218,10 @@ void load_object_surfaces(TerrainData **data, TerrainData *vertexData) {
     flags = surf_has_no_cam_collision(surfaceType);
     flags |= SURFACE_FLAG_DYNAMIC;
 
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    objSurfaces = get_object_surfaces(gCurrentObject);
+#endif
+
     for (i = 0; i < numSurfaces; i++) {
         struct Surface *surface = read_surface_data(vertexData, data);
 
@@ -726,6 +1238,12 @@ void load_object_surfaces(TerrainData **data, TerrainData *vertexData) {
             surface->flags |= flags;
             surface->room = 0;
             add_surface(surface, TRUE);
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+            add_object_surface(objSurfaces, surface);
+#endif
+#ifdef SURFACE_QUERY_CACHE
+            update_query_cache_cells(surface, queryCells);
+#endif
         }
 
         if (hasForce) {
@@ -734,6 +1252,27 @@ void load_object_surfaces(TerrainData **data, TerrainData *vertexData) {
             *data += 3;
         }
     }
+
+#ifdef SURFACE_QUERY_CACHE
+    // Only queries in the cells that gained surfaces have to be redone.
+    if (queryCells[0] <= queryCells[2]) {
+        invalidate_surface_query_cache(queryCells[0], queryCells[1], queryCells[2], queryCells[3]);
+    }
+#endif
+}
+
+/**
+ * Transform gCurrentObject's collision model by m and load its surfaces.
+ */
+static void load_object_collision_surfaces(TerrainData *collisionData, Mat4 m) {
+    TerrainData vertexData[600];
+
+    transform_object_vertices(&collisionData, vertexData, m);
+
+    // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
+    while (*collisionData != TERRAIN_LOAD_CONTINUE) {
+        load_object_surfaces(&collisionData, vertexData);
+    }
 }
 
 /**
@@ -741,7 +1280,11 @@ void load_object_surfaces(TerrainData **data, TerrainData *vertexData) {
  */
 void load_object_collision_model(void) {
     UNUSED u8 filler[4];
-    TerrainData vertexData[600];
+    Mat4 m;
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    struct ObjectSurfaces *objSurfaces = get_object_surfaces(gCurrentObject);
+    s32 i;
+#endif
 
     TerrainData *collisionData = gCurrentObject->collisionData;
     f32 marioDist = gCurrentObject->oDistanceToMario;
@@ -763,13 +1306,40 @@ void load_object_collision_model(void) {
     if (!(gTimeStopState & TIME_STOP_ACTIVE) && marioDist < tangibleDist
         && !(gCurrentObject->activeFlags & ACTIVE_FLAG_IN_DIFFERENT_ROOM)) {
         collisionData++;
-        transform_object_vertices(&collisionData, vertexData);
+        get_object_collision_transform(m);
 
-        // TERRAIN_LOAD_CONTINUE acts as an "end" to the terrain data.
-        while (*collisionData != TERRAIN_LOAD_CONTINUE) {
-            load_object_surfaces(&collisionData, vertexData);
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+        objSurfaces->loaded = TRUE;
+
+        // Keep the surfaces from the last time if the object hasn't moved.
+        if (object_surfaces_match(objSurfaces, collisionData, m)) {
+            gDynamicSurfaceCounts.retained += objSurfaces->numSurfaces;
+        } else {
+            unload_object_surfaces(gCurrentObject);
+
+            objSurfaces->collisionData = collisionData;
+            for (i = 0; i < 4; i++) {
+                objSurfaces->transform[i][0] = m[i][0];
+                objSurfaces->transform[i][1] = m[i][1];
+                objSurfaces->transform[i][2] = m[i][2];
+            }
+
+            objSurfaces->minCellX = objSurfaces->minCellZ = NUM_CELLS;
+            objSurfaces->maxCellX = objSurfaces->maxCellZ = -1;
+
+            load_object_collision_surfaces(collisionData, m);
+            gDynamicSurfaceCounts.reloaded += objSurfaces->numSurfaces;
         }
+#else
+        load_object_collision_surfaces(collisionData, m);
+#endif
     }
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    else if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
+        // Out of range or in a different room, so the object is intangible this frame.
+        unload_object_surfaces(gCurrentObject);
+    }
+#endif
 
     if (marioDist < gCurrentObject->oDrawingDistance) {
         gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_ACTIVE;
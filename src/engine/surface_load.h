@@ -9,6 +9,24 @@
 #define NUM_CELLS       (2 * LEVEL_BOUNDARY_MAX / CELL_SIZE)
 #define NUM_CELLS_INDEX (NUM_CELLS - 1)
 
+#if STATIC_SURFACE_SUBDIVISIONS & (STATIC_SURFACE_SUBDIVISIONS - 1)
+#error "STATIC_SURFACE_SUBDIVISIONS must be a power of two"
+#endif
+
+// Level geometry may use a finer grid than object surfaces.
+#define STATIC_CELL_SIZE        (CELL_SIZE / STATIC_SURFACE_SUBDIVISIONS)
+#define NUM_STATIC_CELLS        (NUM_CELLS * STATIC_SURFACE_SUBDIVISIONS)
+#define NUM_STATIC_CELLS_INDEX  (NUM_STATIC_CELLS - 1)
+
+// Height bands for indexing static floors and ceilings. Heights outside the
+// level boundary fall in the top or bottom band.
+#define SURFACE_Y_BAND_SIZE     (2 * LEVEL_BOUNDARY_MAX / STATIC_SURFACE_Y_BANDS)
+
+// Floors and ceilings are found up to this far above or below a query.
+#define SURFACE_Y_BAND_BUFFER   78
+
+#define SURFACE_NODE_POOL_SIZE  (7000 * STATIC_SURFACE_SUBDIVISIONS * STATIC_SURFACE_SUBDIVISIONS)
+
 struct SurfaceNode {
     struct SurfaceNode *next;
     struct Surface *surface;
@@ -22,21 +40,58 @@ enum {
 
 typedef struct SurfaceNode SpatialPartitionCell[3];
 
+#if STATIC_SURFACE_Y_BANDS > 1
+/**
+ * For each height band, the first floor and ceiling in a cell's list that
+ * a query in that band could find. Indexed by SPATIAL_PARTITION_FLOORS/CEILS.
+ */
+typedef struct SurfaceNode *SurfaceYBandCell[2][STATIC_SURFACE_Y_BANDS];
+
+// The first surface in a static cell's floor or ceiling list that a query at height y could find
+#define STATIC_SURFACE_LIST(cellZ, cellX, listIndex, y) \
+    (gStaticSurfaceYBands[cellZ][cellX][listIndex][get_surface_y_band(y)])
+#else
+#define STATIC_SURFACE_LIST(cellZ, cellX, listIndex, y) \
+    (gStaticSurfacePartition[cellZ][cellX][listIndex].next)
+#endif
+
 // Needed for bs bss reordering memes.
 extern s32 unused8038BE90;
 
-extern SpatialPartitionCell gStaticSurfacePartition[NUM_CELLS][NUM_CELLS];
+extern SpatialPartitionCell gStaticSurfacePartition[NUM_STATIC_CELLS][NUM_STATIC_CELLS];
+#if STATIC_SURFACE_SUBDIVISIONS > 1
+extern struct SurfaceNode gStaticWallPartition[NUM_CELLS][NUM_CELLS];
+#endif
+#if STATIC_SURFACE_Y_BANDS > 1
+extern SurfaceYBandCell (*gStaticSurfaceYBands)[NUM_STATIC_CELLS];
+#endif
 extern SpatialPartitionCell gDynamicSurfacePartition[NUM_CELLS][NUM_CELLS];
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+/**
+ * Object surfaces that were loaded again or kept from the last frame.
+ */
+struct DynamicSurfaceCounts {
+    s32 reloaded;
+    s32 retained;
+};
+
+extern struct DynamicSurfaceCounts gDynamicSurfaceCounts;
+#endif
 extern struct SurfaceNode *sSurfaceNodePool;
 extern struct Surface *sSurfacePool;
 extern s16 sSurfacePoolSize;
 
+s32 get_surface_y_band(s32 y);
 void alloc_surface_pools(void);
 #ifdef NO_SEGMENTED_MEMORY
 u32 get_area_terrain_size(TerrainData *data);
 #endif
 void load_area_terrain(s16 index, TerrainData *data, RoomData *surfaceRooms, s16 *macroObjects);
 void clear_dynamic_surfaces(void);
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+void begin_dynamic_surface_update(void);
+void unload_stale_dynamic_surfaces(void);
+#endif
 void load_object_collision_model(void);
 
 #endif // SURFACE_LOAD_H
@@ -244,6 +244,9 @@ void load_area(s32 index) {
         }
 
         load_obj_warp_nodes();
+#ifdef MASTER_LIST_SORTING
+        reset_display_list_color_cache();
+#endif
         geo_call_global_function_nodes(&gCurrentArea->unk04->node, GEO_CONTEXT_AREA_LOAD);
     }
 }
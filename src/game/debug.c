@@ -1,16 +1,22 @@
 #include <PR/ultratypes.h>
+#include <PR/os_time.h>
 
 #include "behavior_data.h"
 #include "debug.h"
 #include "engine/behavior_script.h"
+#include "engine/geo_layout.h"
 #include "engine/surface_collision.h"
 #include "game_init.h"
 #include "main.h"
+#include "memory.h"
 #include "object_constants.h"
 #include "object_fields.h"
+#include "object_collision.h"
 #include "object_helpers.h"
 #include "object_list_processor.h"
 #include "print.h"
+#include "profiler.h"
+#include "rendering_graph_node.h"
 #include "sm64.h"
 #include "types.h"
 
@@ -75,6 +81,15 @@ void stub_debug_4(void) {
  * counts. They likely have stubbed out code that calculated the clock count and
  * its difference for consecutive calls.
  */
+#ifdef OBJECT_PROFILER
+s64 get_current_clock(void) {
+    return osGetTime();
+}
+
+s64 get_clock_difference(s64 cycles) {
+    return osGetTime() - cycles;
+}
+#else
 s64 get_current_clock(void) {
     s64 wtf = 0;
 
@@ -86,6 +101,7 @@ s64 get_clock_difference(UNUSED s64 cycles) {
 
     return wtf;
 }
+#endif
 
 /*
  * Set the print state info given a pointer to a print state and the relevent
@@ -210,7 +226,59 @@ void print_surfaceinfo(void) {
 void print_stageinfo(void) {
     print_debug_top_down_normal("stageinfo", 0);
     print_debug_top_down_normal("stage param %d", gTTCSpeedSetting);
+#ifdef MASTER_LIST_SORTING
+    // RSP commands for the master lists without and with sorting
+    print_debug_top_down_normal("gfx cmd %d", gMasterListStats.numCommandsBefore);
+    print_debug_top_down_normal("sorted  %d", gMasterListStats.numCommandsAfter);
+    print_debug_top_down_normal("mtx %d", gMasterListStats.numMatrixLoads);
+#endif
+#ifdef FRUSTUM_CULLING
+    // Culling spheres entirely in, partly in and out of view
+    print_debug_top_down_normal("in view %d", gCullingStats.numInView);
+    print_debug_top_down_normal("partly  %d", gCullingStats.numPartlyInView);
+    print_debug_top_down_normal("culled  %d", gCullingStats.numCulled);
+#endif
+#ifdef ANIMATION_POSE_CACHE
+    print_debug_top_down_normal("pose hit  %d", gAnimPoseCacheStats.numHits);
+    print_debug_top_down_normal("pose miss %d", gAnimPoseCacheStats.numMisses);
+#endif
+#ifdef COMPILED_GEO_LAYOUTS
+    // Geo layouts run and copied from a compiled copy, with the average microseconds of each
+    print_debug_top_down_normal("geo run  %d", gCompiledGeoStats.numRun);
+    if (gCompiledGeoStats.numRun != 0) {
+        print_debug_top_down_normal(" us %d", (s32) (OS_CYCLES_TO_USEC(gCompiledGeoStats.runTime)
+                                                     / gCompiledGeoStats.numRun));
+    }
+    print_debug_top_down_normal("geo copy %d", gCompiledGeoStats.numLoaded);
+    if (gCompiledGeoStats.numLoaded != 0) {
+        print_debug_top_down_normal(" us %d", (s32) (OS_CYCLES_TO_USEC(gCompiledGeoStats.loadTime)
+                                                     / gCompiledGeoStats.numLoaded));
+    }
+#endif
+}
+
+#ifdef BEHAVIOR_PROFILER
+#define NUM_DEBUG_BEHAVIOR_COSTS 2
+
+/*
+ * List the behaviors that have taken the most time in cur_obj_update so far, by
+ * segmented address (as the bhv symbols appear in the map file), with the total
+ * milliseconds and the behavior commands run per update.
+ */
+void print_bhvinfo(void) {
+    struct BehaviorCost *top[NUM_DEBUG_BEHAVIOR_COSTS];
+    s32 numTop = get_top_behavior_costs(top, NUM_DEBUG_BEHAVIOR_COSTS);
+    s32 i;
+
+    print_debug_top_down_normal("bhvinfo", 0);
+
+    for (i = 0; i < numTop; i++) {
+        print_debug_top_down_mapinfo("%x", (uintptr_t) virtual_to_segmented(0x13, top[i]->behavior));
+        print_debug_top_down_mapinfo(" ms  %d", (s32) (OS_CYCLES_TO_USEC(top[i]->time) / 1000));
+        print_debug_top_down_mapinfo(" cmd %d", top[i]->numCommands / top[i]->numUpdates);
+    }
 }
+#endif
 
 /*
  * Common printer function for effectinfo and enemyinfo. This function
@@ -425,6 +493,11 @@ void try_print_debug_mario_object_info(void) {
     }
 
     print_debug_top_down_mapinfo("obj  %d", gObjectCounter);
+#ifdef OBJECT_COLLISION_BROADPHASE
+    // Hitbox tests done out of the pairs in the lists that would be tested without the broadphase.
+    print_debug_top_down_mapinfo("hit  %d", gNumHitboxTests.tested);
+    print_debug_top_down_mapinfo("pair %d", gNumHitboxTests.pairs);
+#endif
 
     if (gNumFindFloorMisses != 0) {
         print_debug_bottom_up("NULLBG %d", gNumFindFloorMisses);
@@ -442,7 +515,10 @@ void try_print_debug_mario_object_info(void) {
 void try_print_debug_mario_level_info(void) {
     switch (sDebugPage) {
         case DEBUG_PAGE_OBJECTINFO:
-            break; // no info list is printed for obj info.
+#ifdef BEHAVIOR_PROFILER
+            print_bhvinfo();
+#endif
+            break; // otherwise no info list is printed for obj info.
         case DEBUG_PAGE_CHECKSURFACEINFO:
             print_checkinfo();
             break;
@@ -39,6 +39,9 @@ struct MemoryPool {
     u32 totalSpace;
     struct MemoryBlock *firstBlock;
     struct MemoryBlock freeList;
+#ifdef MEMORY_TRACKER
+    struct MemoryTrackerPool *tracker;
+#endif
 };
 
 // Double declared to preserve US bss ordering.
@@ -64,8 +67,194 @@ FORCE_BSS struct MainPoolBlock *sPoolListHeadR;
 
 static struct MainPoolState *gMainPoolState = NULL;
 
+#ifdef COMPILED_GEO_LAYOUTS
+// ROM address each segment was loaded from, or 0 if it was set some other way
+static uintptr_t sSegmentROMTable[32];
+#endif
+
+#ifdef MEMORY_TRACKER
+struct MemoryTracker gMemoryTracker;
+const char *gMemoryTag = NULL;
+
+// The live pool of each tracker entry, if it was made by mem_pool_init
+static struct MemoryPool *sTrackedMemoryPools[MEMORY_TRACKER_MAX_POOLS];
+
+/**
+ * Record a block that was just allocated from the main pool, and update the
+ * high-water marks.
+ */
+static void memory_tracker_add_block(u32 side, void *addr, u32 size) {
+    struct MemoryTracker *tracker = &gMemoryTracker;
+    struct MemoryTrackerBlock *block;
+
+    tracker->usedSpace[side] += size;
+    if (tracker->maxUsedSpace[side] < tracker->usedSpace[side]) {
+        tracker->maxUsedSpace[side] = tracker->usedSpace[side];
+    }
+    if (tracker->minFreeSpace > sPoolFreeSpace || tracker->minFreeSpace == 0) {
+        tracker->minFreeSpace = sPoolFreeSpace;
+    }
+
+    if (tracker->numBlocks[side] == MEMORY_TRACKER_MAX_BLOCKS) {
+        tracker->numUntrackedBlocks++;
+        return;
+    }
+
+    block = &tracker->blocks[side][tracker->numBlocks[side]++];
+    block->tag = gMemoryTag;
+    block->addr = addr;
+    block->size = size;
+}
+
+/**
+ * Forget the blocks that have been freed by main_pool_free or
+ * main_pool_pop_state, and the pools that were in them.
+ */
+static void memory_tracker_remove_freed_blocks(void) {
+    struct MemoryTracker *tracker = &gMemoryTracker;
+    struct MemoryTrackerBlock *block;
+    s32 i, j;
+
+    // Blocks are freed from the top of each side's stack
+    while (tracker->numBlocks[MEMORY_POOL_LEFT] > 0) {
+        block = &tracker->blocks[MEMORY_POOL_LEFT][tracker->numBlocks[MEMORY_POOL_LEFT] - 1];
+        if ((u8 *) block->addr - 16 < (u8 *) sPoolListHeadL) {
+            break;
+        }
+        tracker->numBlocks[MEMORY_POOL_LEFT]--;
+    }
+
+    while (tracker->numBlocks[MEMORY_POOL_RIGHT] > 0) {
+        block = &tracker->blocks[MEMORY_POOL_RIGHT][tracker->numBlocks[MEMORY_POOL_RIGHT] - 1];
+        if ((u8 *) block->addr - 16 >= (u8 *) sPoolListHeadR) {
+            break;
+        }
+        tracker->numBlocks[MEMORY_POOL_RIGHT]--;
+    }
+
+    tracker->usedSpace[MEMORY_POOL_LEFT] = (u8 *) sPoolListHeadL - (sPoolStart - 16);
+    tracker->usedSpace[MEMORY_POOL_RIGHT] = sPoolEnd - (u8 *) sPoolListHeadR;
+
+    for (i = 0; i < tracker->numPools; i++) {
+        void *pool = tracker->pools[i].pool;
+
+        if (pool == NULL) {
+            continue;
+        }
+
+        // Pools are created at the start of a main pool block
+        tracker->pools[i].pool = NULL;
+        for (j = 0; j < tracker->numBlocks[MEMORY_POOL_LEFT]; j++) {
+            if (tracker->blocks[MEMORY_POOL_LEFT][j].addr == pool) {
+                tracker->pools[i].pool = pool;
+            }
+        }
+        for (j = 0; j < tracker->numBlocks[MEMORY_POOL_RIGHT]; j++) {
+            if (tracker->blocks[MEMORY_POOL_RIGHT][j].addr == pool) {
+                tracker->pools[i].pool = pool;
+            }
+        }
+    }
+}
+
+/**
+ * Return the entry for the pools created at the current tag, creating it if
+ * needed, and make pool its live pool. Return NULL if there is no room.
+ */
+static struct MemoryTrackerPool *memory_tracker_add_pool(void *pool, u32 totalSpace) {
+    struct MemoryTracker *tracker = &gMemoryTracker;
+    struct MemoryTrackerPool *entry;
+    s32 i;
+
+    for (i = 0; i < tracker->numPools; i++) {
+        if (tracker->pools[i].tag == gMemoryTag) {
+            break;
+        }
+    }
+
+    if (i == MEMORY_TRACKER_MAX_POOLS) {
+        return NULL;
+    }
+
+    entry = &tracker->pools[i];
+    if (i == tracker->numPools) {
+        tracker->numPools++;
+        entry->tag = gMemoryTag;
+        entry->numInits = 0;
+        entry->maxUsedSpace = 0;
+    }
+
+    sTrackedMemoryPools[i] = NULL;
+    entry->pool = pool;
+    entry->numInits++;
+    entry->totalSpace = totalSpace;
+    entry->usedSpace = 0;
+    entry->numFreeBlocks = 1;
+    entry->largestFreeBlock = totalSpace;
+    return entry;
+}
+
+static void memory_tracker_update_pool(struct MemoryTrackerPool *entry, s32 change) {
+    if (entry != NULL) {
+        entry->usedSpace += change;
+        if (entry->maxUsedSpace < entry->usedSpace) {
+            entry->maxUsedSpace = entry->usedSpace;
+        }
+    }
+}
+
+/**
+ * Record the main pool usage and how fragmented the live memory pools are.
+ */
+static void memory_tracker_take_snapshot(u32 isPop) {
+    struct MemoryTracker *tracker = &gMemoryTracker;
+    struct MemoryTrackerSnapshot *snapshot =
+        &tracker->snapshots[tracker->numSnapshots % MEMORY_TRACKER_MAX_SNAPSHOTS];
+    struct MainPoolState *state;
+    struct MemoryPool *pool;
+    struct MemoryBlock *freeBlock;
+    s32 depth = 0;
+    s32 i;
+
+    for (state = gMainPoolState; state != NULL; state = state->prev) {
+        depth++;
+    }
+
+    snapshot->tag = gMemoryTag;
+    snapshot->isPop = isPop;
+    snapshot->depth = depth;
+    snapshot->numBlocksL = tracker->numBlocks[MEMORY_POOL_LEFT];
+    snapshot->numBlocksR = tracker->numBlocks[MEMORY_POOL_RIGHT];
+    snapshot->usedSpaceL = tracker->usedSpace[MEMORY_POOL_LEFT];
+    snapshot->usedSpaceR = tracker->usedSpace[MEMORY_POOL_RIGHT];
+    snapshot->freeSpace = sPoolFreeSpace;
+    tracker->numSnapshots++;
+
+    for (i = 0; i < tracker->numPools; i++) {
+        pool = sTrackedMemoryPools[i];
+
+        // Allocation-only pools can't fragment
+        if (pool == NULL || tracker->pools[i].pool != pool) {
+            continue;
+        }
+
+        tracker->pools[i].numFreeBlocks = 0;
+        tracker->pools[i].largestFreeBlock = 0;
+        for (freeBlock = pool->freeList.next; freeBlock != NULL; freeBlock = freeBlock->next) {
+            tracker->pools[i].numFreeBlocks++;
+            if (tracker->pools[i].largestFreeBlock < freeBlock->size) {
+                tracker->pools[i].largestFreeBlock = freeBlock->size;
+            }
+        }
+    }
+}
+#endif
+
 uintptr_t set_segment_base_addr(s32 segment, void *addr) {
     sSegmentTable[segment] = (uintptr_t) addr & 0x1FFFFFFF;
+#ifdef COMPILED_GEO_LAYOUTS
+    sSegmentROMTable[segment] = 0;
+#endif
     return sSegmentTable[segment];
 }
 
@@ -73,6 +262,16 @@ void *get_segment_base_addr(s32 segment) {
     return (void *) (sSegmentTable[segment] | 0x80000000);
 }
 
+#ifdef COMPILED_GEO_LAYOUTS
+/**
+ * Return the ROM address the segment was last loaded from, or 0 if its base
+ * address was set to something that wasn't loaded from ROM.
+ */
+uintptr_t get_segment_rom_addr(s32 segment) {
+    return sSegmentROMTable[segment];
+}
+#endif
+
 #ifndef NO_SEGMENTED_MEMORY
 void *segmented_to_virtual(const void *addr) {
     size_t segment = (uintptr_t) addr >> 24;
@@ -152,6 +351,9 @@ void *main_pool_alloc(u32 size, u32 side) {
             sPoolListHeadR = newListHead;
             addr = (u8 *) sPoolListHeadR + 16;
         }
+#ifdef MEMORY_TRACKER
+        memory_tracker_add_block(side, addr, size);
+#endif
     }
     return addr;
 }
@@ -181,6 +383,9 @@ u32 main_pool_free(void *addr) {
         sPoolListHeadR->prev = NULL;
         sPoolFreeSpace += (uintptr_t) sPoolListHeadR - (uintptr_t) oldListHead;
     }
+#ifdef MEMORY_TRACKER
+    memory_tracker_remove_freed_blocks();
+#endif
     return sPoolFreeSpace;
 }
 
@@ -224,6 +429,9 @@ u32 main_pool_push_state(void) {
     gMainPoolState->listHeadL = lhead;
     gMainPoolState->listHeadR = rhead;
     gMainPoolState->prev = prevState;
+#ifdef MEMORY_TRACKER
+    memory_tracker_take_snapshot(FALSE);
+#endif
     return sPoolFreeSpace;
 }
 
@@ -236,6 +444,10 @@ u32 main_pool_pop_state(void) {
     sPoolListHeadL = gMainPoolState->listHeadL;
     sPoolListHeadR = gMainPoolState->listHeadR;
     gMainPoolState = gMainPoolState->prev;
+#ifdef MEMORY_TRACKER
+    memory_tracker_remove_freed_blocks();
+    memory_tracker_take_snapshot(TRUE);
+#endif
     return sPoolFreeSpace;
 }
 
@@ -285,6 +497,9 @@ void *load_segment(s32 segment, u8 *srcStart, u8 *srcEnd, u32 side) {
 
     if (addr != NULL) {
         set_segment_base_addr(segment, addr);
+#ifdef COMPILED_GEO_LAYOUTS
+        sSegmentROMTable[segment] = (uintptr_t) srcStart;
+#endif
     }
     return addr;
 }
@@ -314,6 +529,249 @@ void *load_to_fixed_pool_addr(u8 *destAddr, u8 *srcStart, u8 *srcEnd) {
     return dest;
 }
 
+#ifdef STREAMING_SEGMENT_DECOMPRESSION
+#define MIO0_CHUNK_SIZE 0x400
+
+enum Mio0StreamId {
+    MIO0_STREAM_BITS,         // header and layout bits
+    MIO0_STREAM_COMPRESSED,   // back-references
+    MIO0_STREAM_UNCOMPRESSED, // literal bytes
+    NUM_MIO0_STREAMS
+};
+
+/**
+ * One of the three parts of MIO0 data, read from ROM a chunk at a time. While
+ * one chunk of buf is decoded, the next one is DMA'd into the other.
+ */
+struct Mio0Stream {
+    OSIoMesg ioMesg; // must be first, the DMA's completion message points to it
+    u8 *buf;
+    u8 *pos;
+    u8 *end;
+    u8 *romPos;
+    s32 dmaPending;
+};
+
+struct Mio0StreamState {
+    u8 buffers[NUM_MIO0_STREAMS][2][MIO0_CHUNK_SIZE];
+    struct Mio0Stream streams[NUM_MIO0_STREAMS];
+    u8 *romEnd;
+    OSMesgQueue dmaQueue;
+    OSMesg dmaMesgs[NUM_MIO0_STREAMS * 2];
+    u32 bytesInFlight;
+    struct SegmentLoadStats *stats;
+};
+
+struct SegmentLoadStats gSegmentLoadStats[32];
+
+/**
+ * Start reading the next chunk of a stream from ROM into dest.
+ */
+static void mio0_stream_start_dma(struct Mio0StreamState *state, struct Mio0Stream *stream, u8 *dest) {
+    u32 size = state->romEnd - stream->romPos;
+
+    if (stream->romPos >= state->romEnd) {
+        return;
+    }
+    if (size > MIO0_CHUNK_SIZE) {
+        size = MIO0_CHUNK_SIZE;
+    }
+
+    osInvalDCache(dest, MIO0_CHUNK_SIZE);
+    osPiStartDma(&stream->ioMesg, OS_MESG_PRI_NORMAL, OS_READ, (uintptr_t) stream->romPos, dest, size,
+                 &state->dmaQueue);
+    stream->romPos += size;
+    stream->dmaPending = TRUE;
+
+    state->bytesInFlight += size;
+    if (state->stats->maxBytesInFlight < state->bytesInFlight) {
+        state->stats->maxBytesInFlight = state->bytesInFlight;
+    }
+}
+
+/**
+ * Block until the DMA into a stream's next chunk has finished.
+ */
+static void mio0_stream_wait(struct Mio0StreamState *state, struct Mio0Stream *stream) {
+    OSIoMesg *ioMesg;
+    OSTime startTime = osGetTime();
+
+    while (stream->dmaPending) {
+        osRecvMesg(&state->dmaQueue, (OSMesg *) &ioMesg, OS_MESG_BLOCK);
+        ((struct Mio0Stream *) ioMesg)->dmaPending = FALSE;
+        state->bytesInFlight -= ioMesg->size;
+    }
+
+    state->stats->dmaWaitTime += osGetTime() - startTime;
+}
+
+/**
+ * Start reading a stream from the ROM address romStart, which doesn't need to
+ * be aligned.
+ */
+static void mio0_stream_open(struct Mio0StreamState *state, enum Mio0StreamId id, u8 *romStart) {
+    struct Mio0Stream *stream = &state->streams[id];
+    u32 skip = (uintptr_t) romStart & 0xF;
+
+    stream->buf = state->buffers[id][0];
+    stream->romPos = romStart - skip;
+
+    mio0_stream_start_dma(state, stream, stream->buf);
+    mio0_stream_wait(state, stream);
+    mio0_stream_start_dma(state, stream, stream->buf + MIO0_CHUNK_SIZE);
+
+    stream->pos = stream->buf + skip;
+    stream->end = stream->buf + MIO0_CHUNK_SIZE;
+}
+
+/**
+ * Move on to a stream's next chunk once the current one has been decoded, and
+ * return its first byte.
+ */
+static u8 mio0_stream_next_chunk(struct Mio0StreamState *state, struct Mio0Stream *stream) {
+    u8 *doneChunk = stream->end - MIO0_CHUNK_SIZE;
+    u8 *nextChunk = (doneChunk == stream->buf) ? stream->buf + MIO0_CHUNK_SIZE : stream->buf;
+
+    mio0_stream_wait(state, stream);
+    mio0_stream_start_dma(state, stream, doneChunk);
+
+    stream->pos = nextChunk;
+    stream->end = nextChunk + MIO0_CHUNK_SIZE;
+    return *stream->pos++;
+}
+
+#define MIO0_STREAM_READ(state, stream) \
+    ((stream)->pos < (stream)->end ? *(stream)->pos++ : mio0_stream_next_chunk(state, stream))
+
+static u32 mio0_stream_read_u32(struct Mio0StreamState *state, struct Mio0Stream *stream) {
+    u32 val = MIO0_STREAM_READ(state, stream) << 24;
+
+    val |= MIO0_STREAM_READ(state, stream) << 16;
+    val |= MIO0_STREAM_READ(state, stream) << 8;
+    return val | MIO0_STREAM_READ(state, stream);
+}
+
+/**
+ * Decompress the MIO0 data from srcStart to srcEnd into dest while it is being
+ * read from ROM, instead of reading all of it into memory first. If dest is
+ * NULL, a buffer for the data is allocated. Return dest, or NULL if there
+ * wasn't enough memory.
+ */
+static void *dma_read_decompress(s32 segment, u8 *srcStart, u8 *srcEnd, u8 *dest) {
+    struct SegmentLoadStats *stats = &gSegmentLoadStats[segment];
+    struct Mio0StreamState *state;
+    struct Mio0Stream *bits;
+    struct Mio0Stream *comp;
+    struct Mio0Stream *uncomp;
+    OSTime startTime = osGetTime();
+    u32 size, compOffset, uncompOffset;
+    u32 bitsLeft = 0;
+    u8 layoutBits = 0;
+    u8 *out;
+    u8 *outEnd;
+    s32 i;
+
+    state = main_pool_alloc(sizeof(struct Mio0StreamState), MEMORY_POOL_RIGHT);
+    if (state == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < NUM_MIO0_STREAMS; i++) {
+        state->streams[i].dmaPending = FALSE;
+    }
+
+    stats->compressedSize = srcEnd - srcStart;
+    stats->maxBytesInFlight = 0;
+    stats->dmaWaitTime = 0;
+    state->stats = stats;
+    state->romEnd = srcStart + ALIGN16(srcEnd - srcStart);
+    state->bytesInFlight = 0;
+    osCreateMesgQueue(&state->dmaQueue, state->dmaMesgs, ARRAY_COUNT(state->dmaMesgs));
+
+    // MIO0 header: magic, decompressed size, offsets of the compressed and uncompressed data
+    bits = &state->streams[MIO0_STREAM_BITS];
+    mio0_stream_open(state, MIO0_STREAM_BITS, srcStart);
+    mio0_stream_read_u32(state, bits);
+    size = mio0_stream_read_u32(state, bits);
+    compOffset = mio0_stream_read_u32(state, bits);
+    uncompOffset = mio0_stream_read_u32(state, bits);
+
+    if (dest == NULL) {
+        dest = main_pool_alloc(size, MEMORY_POOL_LEFT);
+    }
+
+    if (dest != NULL) {
+        comp = &state->streams[MIO0_STREAM_COMPRESSED];
+        uncomp = &state->streams[MIO0_STREAM_UNCOMPRESSED];
+        mio0_stream_open(state, MIO0_STREAM_COMPRESSED, srcStart + compOffset);
+        mio0_stream_open(state, MIO0_STREAM_UNCOMPRESSED, srcStart + uncompOffset);
+
+        out = dest;
+        outEnd = dest + size;
+        while (out < outEnd) {
+            if (bitsLeft == 0) {
+                layoutBits = MIO0_STREAM_READ(state, bits);
+                bitsLeft = 8;
+            }
+
+            if (layoutBits & 0x80) {
+                *out++ = MIO0_STREAM_READ(state, uncomp);
+            } else {
+                u8 byte1 = MIO0_STREAM_READ(state, comp);
+                u8 byte2 = MIO0_STREAM_READ(state, comp);
+                u8 *copySrc = out - (((byte1 & 0xF) << 8) | byte2) - 1;
+                s32 length = (byte1 >> 4) + 3;
+
+                while (length-- > 0) {
+                    *out++ = *copySrc++;
+                }
+            }
+
+            layoutBits <<= 1;
+            bitsLeft--;
+        }
+
+        stats->size = size;
+    }
+
+    // Let any DMAs that were started past the end of the data finish before
+    // their buffers are freed.
+    for (i = 0; i < NUM_MIO0_STREAMS; i++) {
+        mio0_stream_wait(state, &state->streams[i]);
+    }
+    main_pool_free(state);
+
+    stats->decodeTime = osGetTime() - startTime;
+    return dest;
+}
+
+/**
+ * Decompress the block of ROM data from srcStart to srcEnd and return a
+ * pointer to an allocated buffer holding the decompressed data. Set the
+ * base address of segment to this address.
+ */
+void *load_segment_decompress(s32 segment, u8 *srcStart, u8 *srcEnd) {
+    void *dest = dma_read_decompress(segment, srcStart, srcEnd, NULL);
+
+    if (dest != NULL) {
+        set_segment_base_addr(segment, dest);
+#ifdef COMPILED_GEO_LAYOUTS
+        sSegmentROMTable[segment] = (uintptr_t) srcStart;
+#endif
+    }
+    return dest;
+}
+
+void *load_segment_decompress_heap(u32 segment, u8 *srcStart, u8 *srcEnd) {
+    if (dma_read_decompress(segment, srcStart, srcEnd, gDecompressionHeap) != NULL) {
+        set_segment_base_addr(segment, gDecompressionHeap);
+#ifdef COMPILED_GEO_LAYOUTS
+        sSegmentROMTable[segment] = (uintptr_t) srcStart;
+#endif
+    }
+    return gDecompressionHeap;
+}
+#else
 /**
  * Decompress the block of ROM data from srcStart to srcEnd and return a
  * pointer to an allocated buffer holding the decompressed data. Set the
@@ -361,6 +819,8 @@ void *load_segment_decompress_heap(u32 segment, u8 *srcStart, u8 *srcEnd) {
     return gDecompressionHeap;
 }
 
+#endif
+
 void load_engine_code_segment(void) {
     void *startAddr = (void *) SEG_ENGINE;
     u32 totalSize = SEG_FRAMEBUFFERS - SEG_ENGINE;
@@ -391,6 +851,9 @@ struct AllocOnlyPool *alloc_only_pool_init(u32 size, u32 side) {
         subPool->usedSpace = 0;
         subPool->startPtr = (u8 *) addr + sizeof(struct AllocOnlyPool);
         subPool->freePtr = (u8 *) addr + sizeof(struct AllocOnlyPool);
+#ifdef MEMORY_TRACKER
+        subPool->tracker = memory_tracker_add_pool(subPool, size);
+#endif
     }
     return subPool;
 }
@@ -407,6 +870,9 @@ void *alloc_only_pool_alloc(struct AllocOnlyPool *pool, s32 size) {
         addr = pool->freePtr;
         pool->freePtr += size;
         pool->usedSpace += size;
+#ifdef MEMORY_TRACKER
+        memory_tracker_update_pool(pool->tracker, size);
+#endif
     }
     return addr;
 }
@@ -424,6 +890,12 @@ struct AllocOnlyPool *alloc_only_pool_resize(struct AllocOnlyPool *pool, u32 siz
     newPool = main_pool_realloc(pool, size + sizeof(struct AllocOnlyPool));
     if (newPool != NULL) {
         pool->totalSpace = size;
+#ifdef MEMORY_TRACKER
+        if (pool->tracker != NULL) {
+            pool->tracker->pool = pool;
+            pool->tracker->totalSpace = size;
+        }
+#endif
     }
     return newPool;
 }
@@ -450,6 +922,12 @@ struct MemoryPool *mem_pool_init(u32 size, u32 side) {
         block = pool->firstBlock;
         block->next = NULL;
         block->size = pool->totalSpace;
+#ifdef MEMORY_TRACKER
+        pool->tracker = memory_tracker_add_pool(pool, size);
+        if (pool->tracker != NULL) {
+            sTrackedMemoryPools[pool->tracker - gMemoryTracker.pools] = pool;
+        }
+#endif
     }
     return pool;
 }
@@ -474,6 +952,9 @@ void *mem_pool_alloc(struct MemoryPool *pool, u32 size) {
                 freeBlock->next->size = size;
                 freeBlock->next = newBlock;
             }
+#ifdef MEMORY_TRACKER
+            memory_tracker_update_pool(pool->tracker, ((struct MemoryBlock *) addr - 1)->size);
+#endif
             break;
         }
         freeBlock = freeBlock->next;
@@ -488,6 +969,10 @@ BAD_RETURN(s32) mem_pool_free(struct MemoryPool *pool, void *addr) {
     struct MemoryBlock *block = (struct MemoryBlock *) ((u8 *) addr - sizeof(struct MemoryBlock));
     struct MemoryBlock *freeList = pool->freeList.next;
 
+#ifdef MEMORY_TRACKER
+    memory_tracker_update_pool(pool->tracker, -block->size);
+#endif
+
     if (pool->freeList.next == NULL) {
         pool->freeList.next = block;
         block->next = NULL;
@@ -13,6 +13,9 @@ struct AllocOnlyPool {
     s32 usedSpace;
     u8 *startPtr;
     u8 *freePtr;
+#ifdef MEMORY_TRACKER
+    struct MemoryTrackerPool *tracker;
+#endif
 };
 
 struct MemoryPool;
@@ -34,6 +37,84 @@ struct DmaHandlerList {
     void *bufTarget;
 };
 
+#ifdef MEMORY_TRACKER
+#define MEMORY_TRACKER_MAX_BLOCKS 128
+#define MEMORY_TRACKER_MAX_POOLS 16
+#define MEMORY_TRACKER_MAX_SNAPSHOTS 16
+
+#define MEMORY_TRACKER_STRINGIFY(x) #x
+#define MEMORY_TRACKER_TOSTRING(x) MEMORY_TRACKER_STRINGIFY(x)
+#define MEMORY_TAG (__FILE__ ":" MEMORY_TRACKER_TOSTRING(__LINE__))
+
+// A block allocated from the main pool
+struct MemoryTrackerBlock {
+    /*0x00*/ const char *tag;
+    /*0x04*/ void *addr;
+    /*0x08*/ u32 size;
+};
+
+// The memory and allocation-only pools created at one call site
+struct MemoryTrackerPool {
+    /*0x00*/ const char *tag;
+    /*0x04*/ void *pool; // the live pool created there, or NULL if it has been freed
+    /*0x08*/ u32 numInits;
+    /*0x0C*/ u32 totalSpace;
+    /*0x10*/ u32 usedSpace;
+    /*0x14*/ u32 maxUsedSpace; // across every pool created there
+    // Free list of a memory pool, as of the last main pool push or pop
+    /*0x18*/ u32 numFreeBlocks;
+    /*0x1C*/ u32 largestFreeBlock;
+};
+
+// Main pool usage at a main_pool_push_state or main_pool_pop_state
+struct MemoryTrackerSnapshot {
+    /*0x00*/ const char *tag;
+    /*0x04*/ u8 isPop;
+    /*0x05*/ u8 depth;
+    /*0x06*/ u8 numBlocksL;
+    /*0x07*/ u8 numBlocksR;
+    /*0x08*/ u32 usedSpaceL;
+    /*0x0C*/ u32 usedSpaceR;
+    /*0x10*/ u32 freeSpace;
+};
+
+/**
+ * Tagged allocations and high-water marks of the main pool and the pools in it.
+ * tools/memory_report.py prints this from a RAM dump.
+ */
+struct MemoryTracker {
+    /*0x0000*/ struct MemoryTrackerBlock blocks[2][MEMORY_TRACKER_MAX_BLOCKS]; // live, oldest first
+    /*0x0C00*/ struct MemoryTrackerPool pools[MEMORY_TRACKER_MAX_POOLS];
+    /*0x0E00*/ struct MemoryTrackerSnapshot snapshots[MEMORY_TRACKER_MAX_SNAPSHOTS];
+    /*0x0F40*/ s32 numBlocks[2];
+    /*0x0F48*/ u32 usedSpace[2];
+    /*0x0F50*/ u32 maxUsedSpace[2];
+    /*0x0F58*/ u32 minFreeSpace;
+    /*0x0F5C*/ s32 numPools;
+    /*0x0F60*/ s32 numSnapshots; // total, the last MEMORY_TRACKER_MAX_SNAPSHOTS are kept
+    /*0x0F64*/ u32 numUntrackedBlocks;
+};
+
+extern struct MemoryTracker gMemoryTracker;
+// Call site of the allocation being made, set by the macros below
+extern const char *gMemoryTag;
+#endif
+
+#ifdef STREAMING_SEGMENT_DECOMPRESSION
+/**
+ * How the last load of a compressed segment went.
+ */
+struct SegmentLoadStats {
+    u32 compressedSize;
+    u32 size;
+    u32 maxBytesInFlight; // most bytes being DMA'd at once
+    u32 dmaWaitTime;      // osGetTime ticks spent waiting for DMAs
+    u32 decodeTime;       // osGetTime ticks for the whole load
+};
+
+extern struct SegmentLoadStats gSegmentLoadStats[32];
+#endif
+
 #ifndef INCLUDED_FROM_MEMORY_C
 // Declaring this variable extern puts it in the wrong place in the bss order
 // when this file is included from memory.c (first instead of last). Hence,
@@ -43,6 +124,9 @@ extern struct MemoryPool *gEffectsMemoryPool;
 
 uintptr_t set_segment_base_addr(s32 segment, void *addr);
 void *get_segment_base_addr(s32 segment);
+#ifdef COMPILED_GEO_LAYOUTS
+uintptr_t get_segment_rom_addr(s32 segment);
+#endif
 void *segmented_to_virtual(const void *addr);
 void *virtual_to_segmented(u32 segment, const void *addr);
 void move_segment_table_to_dmem(void);
@@ -78,7 +162,31 @@ void *mem_pool_alloc(struct MemoryPool *pool, u32 size);
 BAD_RETURN(s32) mem_pool_free(struct MemoryPool *pool, void *addr);
 
 void *alloc_display_list(u32 size);
+
 void setup_dma_table_list(struct DmaHandlerList *list, void *srcAddr, void *buffer);
 s32 load_patchable_table(struct DmaHandlerList *list, s32 index);
 
+#if defined(MEMORY_TRACKER) && !defined(INCLUDED_FROM_MEMORY_C)
+// Tag allocations with the file and line they're made from. Allocations that memory.c
+// makes on behalf of these functions get the same tag.
+#define main_pool_alloc(size, side) (gMemoryTag = MEMORY_TAG, main_pool_alloc(size, side))
+#define main_pool_realloc(addr, size) (gMemoryTag = MEMORY_TAG, main_pool_realloc(addr, size))
+#define main_pool_push_state() (gMemoryTag = MEMORY_TAG, main_pool_push_state())
+#define main_pool_pop_state() (gMemoryTag = MEMORY_TAG, main_pool_pop_state())
+#ifndef NO_SEGMENTED_MEMORY
+#define load_segment(segment, srcStart, srcEnd, side) \
+    (gMemoryTag = MEMORY_TAG, load_segment(segment, srcStart, srcEnd, side))
+#define load_to_fixed_pool_addr(destAddr, srcStart, srcEnd) \
+    (gMemoryTag = MEMORY_TAG, load_to_fixed_pool_addr(destAddr, srcStart, srcEnd))
+#define load_segment_decompress(segment, srcStart, srcEnd) \
+    (gMemoryTag = MEMORY_TAG, load_segment_decompress(segment, srcStart, srcEnd))
+#define load_segment_decompress_heap(segment, srcStart, srcEnd) \
+    (gMemoryTag = MEMORY_TAG, load_segment_decompress_heap(segment, srcStart, srcEnd))
+#endif
+#define alloc_only_pool_init(size, side) (gMemoryTag = MEMORY_TAG, alloc_only_pool_init(size, side))
+#define mem_pool_init(size, side) (gMemoryTag = MEMORY_TAG, mem_pool_init(size, side))
+#define setup_dma_table_list(list, srcAddr, buffer) \
+    (gMemoryTag = MEMORY_TAG, setup_dma_table_list(list, srcAddr, buffer))
+#endif
+
 #endif // MEMORY_H
@@ -4,9 +4,53 @@
 #include "debug.h"
 #include "interaction.h"
 #include "mario.h"
+#include "object_collision.h"
 #include "object_list_processor.h"
 #include "spawn_object.h"
 
+#ifdef OBJECT_COLLISION_BROADPHASE
+/**
+ * How much wider than its hitbox an object is made in the broadphase, so that
+ * rounding can't rule out a pair that detect_object_hitbox_overlap accepts.
+ */
+#define BROADPHASE_MARGIN 1.0f
+
+/**
+ * The extent along the x axis of a tangible object.
+ */
+struct BroadphaseEntry {
+    f32 minX;
+    f32 maxX;
+    struct Object *obj;
+    s16 rank;
+};
+
+/**
+ * The tangible objects of an object list, sorted by minX.
+ */
+struct BroadphaseList {
+    struct BroadphaseEntry *entries;
+    s16 count;
+    s16 numTangible;
+    f32 maxHalfWidth;
+};
+
+static struct BroadphaseEntry sBroadphaseEntries[OBJECT_POOL_CAPACITY];
+static struct BroadphaseList sBroadphaseLists[NUM_OBJ_LISTS];
+
+/**
+ * For each object in gObjectPool, how many tangible objects come before it in its list.
+ */
+static s16 sBroadphaseRanks[OBJECT_POOL_CAPACITY];
+
+/**
+ * Candidates for a single check_collision_in_list call.
+ */
+static struct BroadphaseEntry *sBroadphaseCandidates[OBJECT_POOL_CAPACITY];
+
+struct NumHitboxTests gNumHitboxTests;
+#endif
+
 struct Object *debug_print_obj_collision(struct Object *a) {
     struct Object *sp24;
     UNUSED u8 filler[4];
@@ -110,6 +154,139 @@ void clear_object_collision(struct Object *a) {
     }
 }
 
+#ifdef OBJECT_COLLISION_BROADPHASE
+/**
+ * Add the tangible objects in an object list to the broadphase.
+ */
+static void build_broadphase_list(s32 listIndex, struct BroadphaseEntry **nextEntry) {
+    struct BroadphaseList *list = &sBroadphaseLists[listIndex];
+    struct Object *head = (struct Object *) &gObjectLists[listIndex];
+    struct Object *obj = (struct Object *) head->header.next;
+    struct BroadphaseEntry *entry;
+    f32 halfWidth;
+    f32 minX;
+
+    list->entries = *nextEntry;
+    list->count = 0;
+    list->numTangible = 0;
+    list->maxHalfWidth = 0.0f;
+
+    while (obj != head) {
+        sBroadphaseRanks[obj - gObjectPool] = list->numTangible;
+
+        if (obj->oIntangibleTimer == 0) {
+            halfWidth = (obj->hitboxRadius > 0.0f ? obj->hitboxRadius : 0.0f) + BROADPHASE_MARGIN;
+            minX = obj->oPosX - halfWidth;
+
+            // NaN positions can't overlap anything, and would break the sort.
+            if (minX <= obj->oPosX + halfWidth) {
+                entry = &list->entries[list->count];
+                while (entry > list->entries && entry[-1].minX > minX) {
+                    entry[0] = entry[-1];
+                    entry--;
+                }
+
+                entry->minX = minX;
+                entry->maxX = obj->oPosX + halfWidth;
+                entry->obj = obj;
+                entry->rank = list->numTangible;
+
+                if (halfWidth > list->maxHalfWidth) {
+                    list->maxHalfWidth = halfWidth;
+                }
+                list->count++;
+            }
+
+            list->numTangible++;
+        }
+
+        obj = (struct Object *) obj->header.next;
+    }
+
+    *nextEntry += list->count;
+}
+
+/**
+ * Build the broadphase for the lists that objects are checked against. Positions
+ * and intangibility don't change while collisions are detected, so this is done once.
+ */
+static void build_broadphase(void) {
+    struct BroadphaseEntry *nextEntry = sBroadphaseEntries;
+
+    build_broadphase_list(OBJ_LIST_POLELIKE, &nextEntry);
+    build_broadphase_list(OBJ_LIST_PLAYER, &nextEntry);
+    build_broadphase_list(OBJ_LIST_PUSHABLE, &nextEntry);
+    build_broadphase_list(OBJ_LIST_GENACTOR, &nextEntry);
+    build_broadphase_list(OBJ_LIST_LEVEL, &nextEntry);
+    build_broadphase_list(OBJ_LIST_SURFACE, &nextEntry);
+    build_broadphase_list(OBJ_LIST_DESTRUCTIVE, &nextEntry);
+
+    gNumHitboxTests.pairs = 0;
+    gNumHitboxTests.tested = 0;
+}
+
+/**
+ * Check a against the objects from b up to the list head c, like the loop below,
+ * but only test the objects whose extent along the x axis overlaps a's. They are
+ * still tested in list order, so the collided objects come out the same.
+ */
+void check_collision_in_list(struct Object *a, struct Object *b, struct Object *c) {
+    struct BroadphaseList *list = &sBroadphaseLists[(struct ObjectNode *) c - gObjectLists];
+    struct BroadphaseEntry *entry;
+    struct BroadphaseEntry *end;
+    struct BroadphaseEntry *candidate;
+    f32 halfWidth, minX, maxX, lowestMinX;
+    s32 minRank;
+    s32 numCandidates = 0;
+    s32 i, lo, hi, mid;
+
+    if (a->oIntangibleTimer != 0 || b == c) {
+        return;
+    }
+
+    minRank = sBroadphaseRanks[b - gObjectPool];
+    gNumHitboxTests.pairs += list->numTangible - minRank;
+
+    halfWidth = (a->hitboxRadius > 0.0f ? a->hitboxRadius : 0.0f) + BROADPHASE_MARGIN;
+    minX = a->oPosX - halfWidth;
+    maxX = a->oPosX + halfWidth;
+
+    // An object that overlaps a can't start further left than this.
+    lowestMinX = minX - 2.0f * list->maxHalfWidth;
+
+    lo = 0;
+    hi = list->count;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (list->entries[mid].minX < lowestMinX) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    end = &list->entries[list->count];
+    for (entry = &list->entries[lo]; entry < end && entry->minX < maxX; entry++) {
+        if (entry->maxX > minX && entry->rank >= minRank) {
+            // Keep the candidates in list order.
+            for (i = numCandidates; i > 0 && sBroadphaseCandidates[i - 1]->rank > entry->rank; i--) {
+                sBroadphaseCandidates[i] = sBroadphaseCandidates[i - 1];
+            }
+            sBroadphaseCandidates[i] = entry;
+            numCandidates++;
+        }
+    }
+
+    for (i = 0; i < numCandidates; i++) {
+        candidate = sBroadphaseCandidates[i];
+        gNumHitboxTests.tested++;
+
+        if (detect_object_hitbox_overlap(a, candidate->obj) && candidate->obj->hurtboxRadius != 0.0f) {
+            detect_object_hurtbox_overlap(a, candidate->obj);
+        }
+    }
+}
+#else
 void check_collision_in_list(struct Object *a, struct Object *b, struct Object *c) {
     if (a->oIntangibleTimer == 0) {
         while (b != c) {
@@ -122,6 +299,7 @@ void check_collision_in_list(struct Object *a, struct Object *b, struct Object *
         }
     }
 }
+#endif
 
 void check_player_object_collision(void) {
     struct Object *sp1C = (struct Object *) &gObjectLists[OBJ_LIST_PLAYER];
@@ -181,6 +359,11 @@ void detect_object_collisions(void) {
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_LEVEL]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_SURFACE]);
     clear_object_collision((struct Object *) &gObjectLists[OBJ_LIST_DESTRUCTIVE]);
+
+#ifdef OBJECT_COLLISION_BROADPHASE
+    build_broadphase();
+#endif
+
     check_player_object_collision();
     check_destructive_object_collision();
     check_pushable_object_collision();
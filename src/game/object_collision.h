@@ -1,6 +1,23 @@
 #ifndef OBJECT_COLLISION_H
 #define OBJECT_COLLISION_H
 
+#include <PR/ultratypes.h>
+
+#include "types.h"
+
+#ifdef OBJECT_COLLISION_BROADPHASE
+/**
+ * Object pairs that would be hitbox tested without the broadphase, and pairs
+ * that actually were, during the last detect_object_collisions.
+ */
+struct NumHitboxTests {
+    s32 pairs;
+    s32 tested;
+};
+
+extern struct NumHitboxTests gNumHitboxTests;
+#endif
+
 void detect_object_collisions(void);
 
 #endif // OBJECT_COLLISION_H
@@ -289,11 +289,22 @@ void bhv_mario_update(void) {
 s32 update_objects_starting_at(struct ObjectNode *objList, struct ObjectNode *firstObj) {
     s32 count = 0;
 
+#ifdef OBJECT_PROFILER
+    s32 listIndex = objList - gObjectLists;
+    OSTime startTime;
+#endif
+
     while (objList != firstObj) {
         gCurrentObject = (struct Object *) firstObj;
 
         gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
+#ifdef OBJECT_PROFILER
+        startTime = osGetTime();
+        cur_obj_update();
+        profiler_log_behavior_time(((struct Object *) firstObj)->behavior, listIndex, startTime);
+#else
         cur_obj_update();
+#endif
 
         firstObj = firstObj->next;
         count++;
@@ -314,6 +325,10 @@ s32 update_objects_starting_at(struct ObjectNode *objList, struct ObjectNode *fi
 s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNode *firstObj) {
     s32 count = 0;
     s32 unfrozen;
+#ifdef OBJECT_PROFILER
+    s32 listIndex = objList - gObjectLists;
+    OSTime startTime;
+#endif
 
     while (objList != firstObj) {
         gCurrentObject = (struct Object *) firstObj;
@@ -340,7 +355,13 @@ s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNod
         // Only update if unfrozen
         if (unfrozen) {
             gCurrentObject->header.gfx.node.flags |= GRAPH_RENDER_HAS_ANIMATION;
+#ifdef OBJECT_PROFILER
+            startTime = osGetTime();
+            cur_obj_update();
+            profiler_log_behavior_time(((struct Object *) firstObj)->behavior, listIndex, startTime);
+#else
             cur_obj_update();
+#endif
         } else {
             gCurrentObject->header.gfx.node.flags &= ~GRAPH_RENDER_HAS_ANIMATION;
         }
@@ -359,6 +380,9 @@ s32 update_objects_during_time_stop(struct ObjectNode *objList, struct ObjectNod
 s32 update_objects_in_list(struct ObjectNode *objList) {
     s32 count;
     struct ObjectNode *firstObj = objList->next;
+#ifdef OBJECT_PROFILER
+    OSTime startTime = osGetTime();
+#endif
 
     if (!(gTimeStopState & TIME_STOP_ACTIVE)) {
         count = update_objects_starting_at(objList, firstObj);
@@ -366,6 +390,10 @@ s32 update_objects_in_list(struct ObjectNode *objList) {
         count = update_objects_during_time_stop(objList, firstObj);
     }
 
+#ifdef OBJECT_PROFILER
+    profiler_log_object_list_time(objList - gObjectLists, startTime, count);
+#endif
+
     return count;
 }
 
@@ -530,6 +558,10 @@ void clear_objects(void) {
 
     stub_behavior_script_2();
     stub_obj_list_processor_1();
+#ifdef BEHAVIOR_PROFILER
+    // Behavior costs are totalled per level.
+    reset_behavior_costs();
+#endif
 
     for (i = 0; i < OBJECT_POOL_CAPACITY; i++) {
         gObjectPool[i].activeFlags = ACTIVE_FLAG_DEACTIVATED;
@@ -612,6 +644,9 @@ void update_objects(UNUSED s32 unused) {
     s64 cycleCounts[30];
 
     cycleCounts[0] = get_current_clock();
+#ifdef OBJECT_PROFILER
+    profiler_begin_object_frame(cycleCounts[0]);
+#endif
 
     gTimeStopState &= ~TIME_STOP_MARIO_OPENED_DOOR;
 
@@ -624,14 +659,25 @@ void update_objects(UNUSED s32 unused) {
 
     gObjectLists = gObjectListArray;
 
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    // If time stop is not active, start reloading the surfaces of objects that move
+    cycleCounts[1] = get_clock_difference(cycleCounts[0]);
+    begin_dynamic_surface_update();
+#else
     // If time stop is not active, unload object surfaces
     cycleCounts[1] = get_clock_difference(cycleCounts[0]);
     clear_dynamic_surfaces();
+#endif
 
     // Update spawners and objects with surfaces
     cycleCounts[2] = get_clock_difference(cycleCounts[0]);
     update_terrain_objects();
 
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+    // Unload the surfaces of objects that didn't load them this frame
+    unload_stale_dynamic_surfaces();
+#endif
+
     // If Mario was touching a moving platform at the end of last frame, apply
     // displacement now
     //! If the platform object unloaded and a different object took its place,
@@ -655,6 +701,9 @@ void update_objects(UNUSED s32 unused) {
     update_mario_platform();
 
     cycleCounts[7] = get_clock_difference(cycleCounts[0]);
+#ifdef OBJECT_PROFILER
+    profiler_end_object_frame(cycleCounts);
+#endif
 
     cycleCounts[0] = 0;
     try_print_debug_mario_object_info();
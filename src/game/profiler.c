@@ -18,6 +18,17 @@ s16 gCurrentFrameIndex2 = 0;
 
 struct ProfilerFrameData gProfilerFrameData[2];
 
+#ifdef OBJECT_PROFILER
+// A ring buffer of the last frames of update_objects timings. gObjectProfilerFrameIndex
+// is the frame being recorded, and the frame after it is the oldest.
+struct ProfilerObjectFrame gObjectProfilerFrames[OBJECT_PROFILER_NUM_FRAMES];
+s16 gObjectProfilerFrameIndex = 0;
+
+// the behavior entry that was last logged to, since objects with the same behavior
+// tend to be next to each other in their lists.
+static s16 sLastBehaviorIndex = 0;
+#endif
+
 // log the current osTime to the appropriate idx for current thread5 processes.
 void profiler_log_thread5_time(enum ProfilerGameEvent eventID) {
     gProfilerFrameData[gCurrentFrameIndex1].gameTimes[eventID] = osGetTime();
@@ -58,6 +69,92 @@ void profiler_log_vblank_time(void) {
     }
 }
 
+#ifdef OBJECT_PROFILER
+// start recording update_objects timings in the next frame of the ring buffer.
+void profiler_begin_object_frame(OSTime startTime) {
+    struct ProfilerObjectFrame *frame;
+    s32 i;
+
+    gObjectProfilerFrameIndex = (gObjectProfilerFrameIndex + 1) % OBJECT_PROFILER_NUM_FRAMES;
+    frame = &gObjectProfilerFrames[gObjectProfilerFrameIndex];
+
+    frame->startTime = startTime;
+
+    for (i = 0; i < NUM_OBJECT_PHASES + 1; i++) {
+        frame->phaseTimes[i] = 0;
+    }
+
+    for (i = 0; i < NUM_OBJ_LISTS; i++) {
+        frame->listStartTimes[i] = 0;
+        frame->listTimes[i] = 0;
+        frame->listCounts[i] = 0;
+    }
+
+    frame->numBehaviors = 0;
+    frame->otherBehaviorsTime = 0;
+    sLastBehaviorIndex = 0;
+}
+
+// log the time since startTime as the time taken to update an object list.
+void profiler_log_object_list_time(s32 listIndex, OSTime startTime, s32 count) {
+    struct ProfilerObjectFrame *frame = &gObjectProfilerFrames[gObjectProfilerFrameIndex];
+
+    frame->listStartTimes[listIndex] = startTime - frame->startTime;
+    frame->listTimes[listIndex] += osGetTime() - startTime;
+    frame->listCounts[listIndex] += count;
+}
+
+// add the time since startTime to the time spent updating objects with a behavior.
+void profiler_log_behavior_time(const BehaviorScript *behavior, s32 listIndex, OSTime startTime) {
+    struct ProfilerObjectFrame *frame = &gObjectProfilerFrames[gObjectProfilerFrameIndex];
+    struct ProfilerBehaviorTime *entry = &frame->behaviors[sLastBehaviorIndex];
+    u32 time = osGetTime() - startTime;
+    s32 i;
+
+    if (sLastBehaviorIndex >= frame->numBehaviors || entry->behavior != behavior
+        || entry->listIndex != listIndex) {
+        for (i = 0; i < frame->numBehaviors; i++) {
+            entry = &frame->behaviors[i];
+            if (entry->behavior == behavior && entry->listIndex == listIndex) {
+                break;
+            }
+        }
+
+        // out of entries, so only the total is kept.
+        if (i == OBJECT_PROFILER_NUM_BEHAVIORS) {
+            frame->otherBehaviorsTime += time;
+            return;
+        }
+
+        entry = &frame->behaviors[i];
+
+        if (i == frame->numBehaviors) {
+            entry->behavior = behavior;
+            entry->time = 0;
+            entry->count = 0;
+            entry->listIndex = listIndex;
+            frame->numBehaviors++;
+        }
+
+        sLastBehaviorIndex = i;
+    }
+
+    entry->time += time;
+    entry->count++;
+}
+
+// log when each update_objects phase started, from the cycleCounts it records. each
+// count is the time since the frame started.
+void profiler_end_object_frame(s64 *cycleCounts) {
+    struct ProfilerObjectFrame *frame = &gObjectProfilerFrames[gObjectProfilerFrameIndex];
+    s32 i;
+
+    for (i = 0; i < NUM_OBJECT_PHASES + 1; i++) {
+        frame->phaseTimes[i] = cycleCounts[i + 1];
+    }
+}
+#endif
+
 // draw the specified profiler given the information passed.
 void draw_profiler_bar(OSTime clockBase, OSTime clockStart, OSTime clockEnd, s16 posY, u16 color) {
     s64 durationStart, durationEnd;
@@ -5,6 +5,7 @@
 #include <PR/os_time.h>
 
 #include "types.h"
+#include "object_list_processor.h"
 
 extern u64 osClockRate;
 
@@ -42,10 +43,58 @@ enum ProfilerGfxEvent {
     RDP_COMPLETE
 };
 
+#ifdef OBJECT_PROFILER
+#define OBJECT_PROFILER_NUM_FRAMES 16
+#define OBJECT_PROFILER_NUM_BEHAVIORS 48
+
+// update_objects phases, in the order they run
+enum ProfilerObjectPhase {
+    OBJECT_PHASE_CLEAR_SURFACES,
+    OBJECT_PHASE_TERRAIN_OBJECTS,
+    OBJECT_PHASE_DETECT_COLLISIONS,
+    OBJECT_PHASE_OTHER_OBJECTS,
+    OBJECT_PHASE_UNLOAD_OBJECTS,
+    OBJECT_PHASE_MARIO_PLATFORM,
+    NUM_OBJECT_PHASES
+};
+
+// Time spent updating the objects with one behavior in one object list
+struct ProfilerBehaviorTime {
+    /* 0x00 */ const BehaviorScript *behavior;
+    /* 0x04 */ u32 time;
+    /* 0x08 */ u16 count;
+    /* 0x0A */ s16 listIndex;
+};
+
+// Times are in osGetTime ticks (OS_CPU_COUNTER a second), and are relative to startTime.
+struct ProfilerObjectFrame {
+    /* 0x000 */ OSTime startTime;
+    // phaseTimes[i] is when phase i starts, and phaseTimes[NUM_OBJECT_PHASES] when
+    // the last phase ends.
+    /* 0x008 */ u32 phaseTimes[NUM_OBJECT_PHASES + 1];
+    /* 0x024 */ u32 listStartTimes[NUM_OBJ_LISTS];
+    /* 0x058 */ u32 listTimes[NUM_OBJ_LISTS];
+    /* 0x08C */ u16 listCounts[NUM_OBJ_LISTS];
+    /* 0x0A6 */ s16 numBehaviors;
+    // Objects whose behaviors didn't fit in behaviors[]
+    /* 0x0A8 */ u32 otherBehaviorsTime;
+    /* 0x0AC */ struct ProfilerBehaviorTime behaviors[OBJECT_PROFILER_NUM_BEHAVIORS];
+};
+
+extern struct ProfilerObjectFrame gObjectProfilerFrames[OBJECT_PROFILER_NUM_FRAMES];
+extern s16 gObjectProfilerFrameIndex;
+#endif
+
 void profiler_log_thread5_time(enum ProfilerGameEvent eventID);
 void profiler_log_thread4_time(void);
 void profiler_log_gfx_time(enum ProfilerGfxEvent eventID);
 void profiler_log_vblank_time(void);
+#ifdef OBJECT_PROFILER
+void profiler_begin_object_frame(OSTime startTime);
+void profiler_log_object_list_time(s32 listIndex, OSTime startTime, s32 count);
+void profiler_log_behavior_time(const BehaviorScript *behavior, s32 listIndex, OSTime startTime);
+void profiler_end_object_frame(s64 *cycleCounts);
+#endif
 void draw_profiler(void);
 
 #endif // PROFILER_H
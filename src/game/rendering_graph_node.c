@@ -6,6 +6,7 @@
 #include "gfx_dimensions.h"
 #include "main.h"
 #include "memory.h"
+#include "object_list_processor.h"
 #include "print.h"
 #include "rendering_graph_node.h"
 #include "shadow.h"
@@ -67,6 +68,48 @@ s16 *gCurrAnimData;
 
 struct AllocOnlyPool *gDisplayListHeap;
 
+#ifdef ANIMATION_POSE_CACHE
+// Each pose takes about 2.3 KB, so the cache takes about 37 KB of RAM
+#define ANIM_POSE_CACHE_SIZE 16
+#define ANIM_POSE_MAX_PARTS  32
+
+/**
+ * The decoded animation values of an animated part. rotation is the matrix
+ * mtxf_rotate_xyz_and_translate makes from them, without the translation.
+ */
+struct AnimPosePart {
+    Mat4 rotation;
+    s16 translation[3]; // only read for the first part
+    u8 isDecoded;
+};
+
+/**
+ * The parts of an animation at a frame, in the order geo_process_animated_part
+ * reaches them. They only depend on the animation and the frame, so objects
+ * that play the same animation at the same frame can share them.
+ */
+struct AnimPose {
+    struct Animation *anim;
+    s16 frame;
+    u32 timestamp;
+    struct AnimPosePart parts[ANIM_POSE_MAX_PARTS];
+};
+
+struct AnimPoseCacheStats gAnimPoseCacheStats;
+
+static struct AnimPose sAnimPoseCache[ANIM_POSE_CACHE_SIZE];
+// Poses are only valid in the frame they were made in
+static u32 sAnimPoseCacheTimestamp = 0;
+
+// The pose of the current animation, or NULL if it isn't cached, and the index
+// of the next animated part in it
+static struct AnimPose *sCurrAnimPose;
+static s32 sCurrAnimPart;
+
+// Where the values of a part that can't be cached are read to
+static struct AnimPosePart sUncachedAnimPart;
+#endif
+
 struct RenderModeContainer {
     u32 modes[8];
 };
@@ -129,6 +172,193 @@ u16 gAreaUpdateCounter = 0;
 LookAt lookAt;
 #endif
 
+#ifdef FRUSTUM_CULLING
+struct CullingStats gCullingStats;
+
+/**
+ * The sides of the view frustum of the current camera, in camera space. The
+ * camera looks down -z, so a point p is on the inside of the right side if
+ * p.x * hCos + p.z * hSin <= 0, and likewise for the top side with p.y.
+ * The frustum is symmetric, so the left and bottom sides are tested with -p.x
+ * and -p.y.
+ */
+struct ViewFrustum {
+    f32 hCos;
+    f32 hSin;
+    f32 vCos;
+    f32 vSin;
+    f32 near;
+    f32 far;
+};
+
+static struct ViewFrustum sViewFrustum;
+
+// Whether the subtree being processed is known to be entirely in view, so its
+// culling radius nodes don't need to be tested
+static s8 sSubtreeInView = FALSE;
+#endif
+
+#ifdef MASTER_LIST_SORTING
+#define DL_COLOR_CACHE_SIZE 256
+
+struct MasterListStats gMasterListStats;
+
+/**
+ * Whether a display list sets the env or prim color, remembered by its
+ * segmented address until the next area is loaded.
+ */
+struct DisplayListColorInfo {
+    void *displayList;
+    u8 setsColor;
+};
+
+static struct DisplayListColorInfo sDisplayListColorCache[DL_COLOR_CACHE_SIZE];
+
+/**
+ * Forget which display lists set a color, since the segments they're in may
+ * now hold other data.
+ */
+void reset_display_list_color_cache(void) {
+    bzero(sDisplayListColorCache, sizeof(sDisplayListColorCache));
+}
+
+/**
+ * Return whether a display list, or one it calls, sets the env or prim color.
+ * Display lists nested too deeply to check are assumed to.
+ */
+static s32 display_list_sets_color(void *displayList, s32 depth) {
+    Gfx *gfx = displayList;
+    u8 opcode;
+
+    if (depth > 4) {
+        return TRUE;
+    }
+    if ((uintptr_t) gfx < 0x80000000) {
+        gfx = segmented_to_virtual(gfx);
+    }
+
+    for (;; gfx++) {
+        opcode = gfx->words.w0 >> 24;
+        if (opcode == G_SETENVCOLOR || opcode == G_SETPRIMCOLOR) {
+            return TRUE;
+        }
+        if (opcode == (u8) G_DL) {
+            if (display_list_sets_color((void *) gfx->words.w1, depth + 1)) {
+                return TRUE;
+            }
+            if (((gfx->words.w0 >> 16) & 0xFF) == G_DL_NOPUSH) {
+                return FALSE;
+            }
+        } else if (opcode == (u8) G_ENDDL) {
+            return FALSE;
+        }
+    }
+}
+
+/**
+ * Return whether a node has to stay where it is in its layer. Generated
+ * display lists may set state for the ones after them (like an env color),
+ * and display lists that set a color (like bowser's, which resets the env
+ * color at its end) would change the color of the ones they're moved in
+ * front of.
+ */
+static s32 is_master_list_barrier(struct DisplayListNode *node) {
+    struct DisplayListColorInfo *info;
+
+    if (node->isGenerated) {
+        return TRUE;
+    }
+
+    info = &sDisplayListColorCache[((uintptr_t) node->displayList >> 3) % DL_COLOR_CACHE_SIZE];
+    if (info->displayList != node->displayList) {
+        info->displayList = node->displayList;
+        info->setsColor = display_list_sets_color(node->displayList, 0);
+    }
+    return info->setsColor;
+}
+
+/**
+ * Return whether node a should be drawn after node b. Nodes with the same
+ * display list end up next to each other, and so do nodes with the same
+ * transform among those.
+ */
+static s32 display_list_node_after(struct DisplayListNode *a, struct DisplayListNode *b) {
+    if (a->displayList != b->displayList) {
+        return (uintptr_t) a->displayList > (uintptr_t) b->displayList;
+    }
+    return (uintptr_t) a->transform > (uintptr_t) b->transform;
+}
+
+/**
+ * Merge sort a NULL-terminated list of display list nodes and return its new
+ * head. Nodes that are equal keep their order.
+ */
+static struct DisplayListNode *sort_display_list_nodes(struct DisplayListNode *list) {
+    struct DisplayListNode *half;
+    struct DisplayListNode *other;
+    struct DisplayListNode *head;
+    struct DisplayListNode **tail = &head;
+
+    if (list == NULL || list->next == NULL) {
+        return list;
+    }
+
+    half = list;
+    other = list->next;
+    while (other != NULL && other->next != NULL) {
+        half = half->next;
+        other = other->next->next;
+    }
+    other = half->next;
+    half->next = NULL;
+
+    list = sort_display_list_nodes(list);
+    other = sort_display_list_nodes(other);
+
+    while (list != NULL && other != NULL) {
+        if (display_list_node_after(list, other)) {
+            *tail = other;
+            other = other->next;
+        } else {
+            *tail = list;
+            list = list->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = (list != NULL) ? list : other;
+    return head;
+}
+
+/**
+ * Sort a layer of a master list. Only the runs of nodes between the ones that
+ * have to stay where they are are sorted.
+ */
+static void sort_master_list_layer(struct GraphNodeMasterList *node, s32 layer) {
+    struct DisplayListNode **link = &node->listHeads[layer];
+    struct DisplayListNode *runEnd;
+    struct DisplayListNode *rest;
+
+    while (*link != NULL) {
+        if (!is_master_list_barrier(*link)) {
+            runEnd = *link;
+            while (runEnd->next != NULL && !is_master_list_barrier(runEnd->next)) {
+                runEnd = runEnd->next;
+            }
+            rest = runEnd->next;
+            runEnd->next = NULL;
+
+            *link = sort_display_list_nodes(*link);
+            while ((*link)->next != NULL) {
+                link = &(*link)->next;
+            }
+            (*link)->next = rest;
+        }
+        node->listTails[layer] = *link;
+        link = &(*link)->next;
+    }
+}
+#endif
+
 /**
  * Process a master list node.
  */
@@ -138,6 +368,10 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
     s32 enableZBuffer = (node->node.flags & GRAPH_RENDER_Z_BUFFER) != 0;
     struct RenderModeContainer *modeList = &renderModeTable_1Cycle[enableZBuffer];
     struct RenderModeContainer *mode2List = &renderModeTable_2Cycle[enableZBuffer];
+#ifdef MASTER_LIST_SORTING
+    Mtx *currTransform = NULL;
+    Gfx *gfxStart = gDisplayListHead;
+#endif
 
     // @bug This is where the LookAt values should be calculated but aren't.
     // As a result, environment mapping is broken on Fast3DEX2 without the
@@ -154,11 +388,37 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
 
     for (i = 0; i < GFX_NUM_MASTER_LISTS; i++) {
         if ((currList = node->listHeads[i]) != NULL) {
+#ifdef MASTER_LIST_SORTING
+            // Draw order only matters for these layers if there's no z-buffer
+            if (enableZBuffer != 0 && (i == LAYER_OPAQUE || i == LAYER_ALPHA)) {
+                sort_master_list_layer(node, i);
+                currList = node->listHeads[i];
+            }
+            gMasterListStats.numCommandsBefore++;
+#endif
             gDPSetRenderMode(gDisplayListHead++, modeList->modes[i], mode2List->modes[i]);
             while (currList != NULL) {
+#ifdef MASTER_LIST_SORTING
+                // The render mode doesn't affect the modelview matrix, so the
+                // transform carries over between layers too
+                if (currList->transform != currTransform) {
+                    gSPMatrix(gDisplayListHead++, VIRTUAL_TO_PHYSICAL(currList->transform),
+                              G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH);
+                    currTransform = currList->transform;
+                    gMasterListStats.numMatrixLoads++;
+                }
+                gSPDisplayList(gDisplayListHead++, currList->displayList);
+                // Generated lists can load their own matrix (like the envfx particles)
+                if (currList->isGenerated) {
+                    currTransform = NULL;
+                }
+                gMasterListStats.numCommandsBefore += 2;
+                gMasterListStats.numDisplayLists++;
+#else
                 gSPMatrix(gDisplayListHead++, VIRTUAL_TO_PHYSICAL(currList->transform),
                           G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_NOPUSH);
                 gSPDisplayList(gDisplayListHead++, currList->displayList);
+#endif
                 currList = currList->next;
             }
         }
@@ -166,7 +426,13 @@ static void geo_process_master_list_sub(struct GraphNodeMasterList *node) {
     if (enableZBuffer != 0) {
         gDPPipeSync(gDisplayListHead++);
         gSPClearGeometryMode(gDisplayListHead++, G_ZBUFFER);
+#ifdef MASTER_LIST_SORTING
+        gMasterListStats.numCommandsBefore += 4;
+#endif
     }
+#ifdef MASTER_LIST_SORTING
+    gMasterListStats.numCommandsAfter += gDisplayListHead - gfxStart;
+#endif
 }
 
 /**
@@ -186,6 +452,9 @@ static void geo_append_display_list(void *displayList, s16 layer) {
         listNode->transform = gMatStackFixed[gMatStackIndex];
         listNode->displayList = displayList;
         listNode->next = 0;
+#ifdef MASTER_LIST_SORTING
+        listNode->isGenerated = FALSE;
+#endif
         if (gCurGraphNodeMasterList->listHeads[layer] == 0) {
             gCurGraphNodeMasterList->listHeads[layer] = listNode;
         } else {
@@ -195,6 +464,20 @@ static void geo_append_display_list(void *displayList, s16 layer) {
     }
 }
 
+/**
+ * Appends a display list made by a geo function. Unlike the display lists in
+ * geo layouts, these may rely on state set by the one before them or change
+ * the modelview matrix, so the master list is drawn with that in mind.
+ */
+static void geo_append_generated_display_list(void *displayList, s16 layer) {
+    geo_append_display_list(displayList, layer);
+#ifdef MASTER_LIST_SORTING
+    if (gCurGraphNodeMasterList != NULL) {
+        gCurGraphNodeMasterList->listTails[layer]->isGenerated = TRUE;
+    }
+#endif
+}
+
 /**
  * Process the master list node.
  */
@@ -305,6 +588,107 @@ static void geo_process_switch(struct GraphNodeSwitchCase *node) {
 /**
  * Process a camera node.
  */
+#ifdef FRUSTUM_CULLING
+/**
+ * Compute the sides of the view frustum of a perspective node, as seen by a
+ * camera with the given screen roll.
+ */
+static void update_view_frustum(struct GraphNodePerspective *persp, s16 rollScreen) {
+    // Half of the vertical fov in in-game angle units, with a degree to spare
+    s16 halfFov = (persp->fov / 2.0f + 1.0f) * 32768.0f / 180.0f + 0.5f;
+    f32 vTan = sins(halfFov) / coss(halfFov);
+    f32 hTan = vTan * ((f32) gCurGraphNodeRoot->width / (f32) gCurGraphNodeRoot->height);
+
+#ifdef WIDESCREEN
+    hTan *= GFX_DIMENSIONS_ASPECT_RATIO / (4.0f / 3.0f);
+#endif
+
+    // A rolled screen isn't lined up with the x and y axes anymore, so use the
+    // cone around it instead
+    if (rollScreen != 0) {
+        hTan = vTan = sqrtf(hTan * hTan + vTan * vTan);
+    }
+
+    sViewFrustum.hCos = 1.0f / sqrtf(1.0f + hTan * hTan);
+    sViewFrustum.hSin = hTan * sViewFrustum.hCos;
+    sViewFrustum.vCos = 1.0f / sqrtf(1.0f + vTan * vTan);
+    sViewFrustum.vSin = vTan * sViewFrustum.vCos;
+
+    // Objects closer than 100 units or further than 20000 units have always
+    // been culled. The perspective's far plane isn't used, since it's closer
+    // than that in most levels (see sphere_in_view_frustum).
+    sViewFrustum.near = 100.0f;
+    sViewFrustum.far = 20000.0f;
+}
+
+/**
+ * Test a sphere of the given radius at the origin of matrix, which is in
+ * camera space, against the view frustum. Scaling in the matrix scales the
+ * radius too. The top and bottom sides are only tested if testVertical is set.
+ * Returns CULL_OUTSIDE_VIEW, CULL_PARTLY_IN_VIEW or CULL_IN_VIEW, and counts
+ * the result in gCullingStats.
+ */
+static s32 sphere_in_view_frustum(Mat4 matrix, f32 radius, s32 testVertical) {
+    f32 x = (matrix[3][0] < 0.0f) ? -matrix[3][0] : matrix[3][0];
+    f32 y = (matrix[3][1] < 0.0f) ? -matrix[3][1] : matrix[3][1];
+    f32 z = matrix[3][2];
+    f32 scale = matrix[0][0] * matrix[0][0] + matrix[0][1] * matrix[0][1] + matrix[0][2] * matrix[0][2];
+    f32 axisScale;
+    f32 dist;
+    s32 result = CULL_IN_VIEW;
+    s32 i;
+
+    for (i = 1; i < 3; i++) {
+        axisScale = matrix[i][0] * matrix[i][0] + matrix[i][1] * matrix[i][1] + matrix[i][2] * matrix[i][2];
+        if (scale < axisScale) {
+            scale = axisScale;
+        }
+    }
+    radius *= sqrtf(scale);
+
+    //! This makes the HOLP not update when the camera is far away, and it
+    //  makes PU travel safe when the camera is locked on the main map.
+    //  If Mario were rendered with a depth over 65536 it would cause overflow
+    //  when converting the transformation matrix to a fixed point matrix.
+    if (z > -sViewFrustum.near + radius || z < -sViewFrustum.far - radius) {
+        gCullingStats.numCulled++;
+        return CULL_OUTSIDE_VIEW;
+    }
+    if (z > -sViewFrustum.near - radius || z < -sViewFrustum.far + radius) {
+        result = CULL_PARTLY_IN_VIEW;
+    }
+
+    dist = x * sViewFrustum.hCos + z * sViewFrustum.hSin;
+    if (dist > radius) {
+        gCullingStats.numCulled++;
+        return CULL_OUTSIDE_VIEW;
+    }
+    if (dist > -radius) {
+        result = CULL_PARTLY_IN_VIEW;
+    }
+
+    if (testVertical) {
+        dist = y * sViewFrustum.vCos + z * sViewFrustum.vSin;
+        if (dist > radius) {
+            gCullingStats.numCulled++;
+            return CULL_OUTSIDE_VIEW;
+        }
+        if (dist > -radius) {
+            result = CULL_PARTLY_IN_VIEW;
+        }
+    } else {
+        result = CULL_PARTLY_IN_VIEW;
+    }
+
+    if (result == CULL_IN_VIEW) {
+        gCullingStats.numInView++;
+    } else {
+        gCullingStats.numPartlyInView++;
+    }
+    return result;
+}
+#endif
+
 static void geo_process_camera(struct GraphNodeCamera *node) {
     Mat4 cameraTransform;
     Mtx *rollMtx = alloc_display_list(sizeof(*rollMtx));
@@ -320,6 +704,11 @@ static void geo_process_camera(struct GraphNodeCamera *node) {
 
     mtxf_lookat(cameraTransform, node->pos, node->focus, node->roll);
     mtxf_mul(gMatStack[gMatStackIndex + 1], cameraTransform, gMatStack[gMatStackIndex]);
+#ifdef FRUSTUM_CULLING
+    if (gCurGraphNodeCamFrustum != NULL) {
+        update_view_frustum(gCurGraphNodeCamFrustum, node->rollScreen);
+    }
+#endif
     gMatStackIndex++;
     mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
     gMatStackFixed[gMatStackIndex] = mtx;
@@ -490,7 +879,7 @@ static void geo_process_generated_list(struct GraphNodeGenerated *node) {
                                       (struct AllocOnlyPool *) gMatStack[gMatStackIndex]);
 
         if (list != NULL) {
-            geo_append_display_list((void *) VIRTUAL_TO_PHYSICAL(list), node->fnNode.node.flags >> 8);
+            geo_append_generated_display_list((void *) VIRTUAL_TO_PHYSICAL(list), node->fnNode.node.flags >> 8);
         }
     }
     if (node->fnNode.node.children != NULL) {
@@ -511,7 +900,7 @@ static void geo_process_background(struct GraphNodeBackground *node) {
                                  (struct AllocOnlyPool *) gMatStack[gMatStackIndex]);
     }
     if (list != NULL) {
-        geo_append_display_list((void *) VIRTUAL_TO_PHYSICAL(list), node->fnNode.node.flags >> 8);
+        geo_append_generated_display_list((void *) VIRTUAL_TO_PHYSICAL(list), node->fnNode.node.flags >> 8);
     } else if (gCurGraphNodeMasterList != NULL) {
 #ifndef F3DEX_GBI_2E
         Gfx *gfxStart = alloc_display_list(sizeof(Gfx) * 7);
@@ -536,6 +925,106 @@ static void geo_process_background(struct GraphNodeBackground *node) {
     }
 }
 
+#ifdef ANIMATION_POSE_CACHE
+/**
+ * Find the cached pose of anim at frame, or make an empty one. Returns NULL if
+ * the cache is full.
+ */
+static struct AnimPose *find_anim_pose(struct Animation *anim, s16 frame) {
+    u32 hash = ((uintptr_t) anim >> 2) ^ ((u32) frame * 0x9E3779B1);
+    struct AnimPose *pose;
+    s32 i;
+    s32 j;
+
+    for (i = 0; i < 8; i++) {
+        pose = &sAnimPoseCache[(hash + i) % ANIM_POSE_CACHE_SIZE];
+
+        if (pose->timestamp != sAnimPoseCacheTimestamp) {
+            for (j = 0; j < ANIM_POSE_MAX_PARTS; j++) {
+                pose->parts[j].isDecoded = FALSE;
+            }
+            pose->anim = anim;
+            pose->frame = frame;
+            pose->timestamp = sAnimPoseCacheTimestamp;
+            gAnimPoseCacheStats.numPoses++;
+            return pose;
+        }
+
+        if (pose->anim == anim && pose->frame == frame) {
+            return pose;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Read the animation values of the next animated part, the same way
+ * geo_process_animated_part does without the pose cache.
+ */
+static void read_anim_part(struct AnimPosePart *part) {
+    Vec3s rotation;
+
+    part->translation[0] = 0;
+    part->translation[1] = 0;
+    part->translation[2] = 0;
+
+    if (gCurrAnimType == ANIM_TYPE_TRANSLATION) {
+        part->translation[0] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        part->translation[1] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        part->translation[2] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurrAnimType == ANIM_TYPE_LATERAL_TRANSLATION) {
+        part->translation[0] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimAttribute += 2;
+        part->translation[2] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurrAnimType == ANIM_TYPE_VERTICAL_TRANSLATION) {
+        gCurrAnimAttribute += 2;
+        part->translation[1] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+        gCurrAnimAttribute += 2;
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    } else if (gCurrAnimType == ANIM_TYPE_NO_TRANSLATION) {
+        gCurrAnimAttribute += 6;
+        gCurrAnimType = ANIM_TYPE_ROTATION;
+    }
+
+    rotation[0] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    rotation[1] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    rotation[2] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
+    mtxf_rotate_xyz_and_translate(part->rotation, gVec3fZero, rotation);
+}
+
+/**
+ * Return the animation values of the next animated part, from the pose cache
+ * if another object has already read them this frame.
+ */
+static struct AnimPosePart *get_anim_part(void) {
+    struct AnimPosePart *part = &sUncachedAnimPart;
+
+    if (sCurrAnimPose != NULL && sCurrAnimPart < ANIM_POSE_MAX_PARTS) {
+        part = &sCurrAnimPose->parts[sCurrAnimPart];
+        if (part->isDecoded) {
+            // Skip the values as read_anim_part would have
+            if (gCurrAnimType != ANIM_TYPE_ROTATION) {
+                gCurrAnimAttribute += 6;
+                gCurrAnimType = ANIM_TYPE_ROTATION;
+            }
+            gCurrAnimAttribute += 6;
+            sCurrAnimPart++;
+            gAnimPoseCacheStats.numHits++;
+            return part;
+        }
+    }
+
+    read_anim_part(part);
+    part->isDecoded = TRUE;
+    sCurrAnimPart++;
+    gAnimPoseCacheStats.numMisses++;
+    return part;
+}
+#endif
+
 /**
  * Render an animated part. The current animation state is not part of the node
  * but set in global variables. If an animated part is skipped, everything afterwards desyncs.
@@ -548,6 +1037,28 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
 
     vec3s_copy(rotation, gVec3sZero);
     vec3f_set(translation, node->translation[0], node->translation[1], node->translation[2]);
+#ifdef ANIMATION_POSE_CACHE
+    if (gCurrAnimType != ANIM_TYPE_NONE) {
+        s32 animType = gCurrAnimType;
+        struct AnimPosePart *part = get_anim_part();
+
+        if (animType == ANIM_TYPE_TRANSLATION || animType == ANIM_TYPE_LATERAL_TRANSLATION) {
+            translation[0] += part->translation[0] * gCurrAnimTranslationMultiplier;
+        }
+        if (animType == ANIM_TYPE_TRANSLATION || animType == ANIM_TYPE_VERTICAL_TRANSLATION) {
+            translation[1] += part->translation[1] * gCurrAnimTranslationMultiplier;
+        }
+        if (animType == ANIM_TYPE_TRANSLATION || animType == ANIM_TYPE_LATERAL_TRANSLATION) {
+            translation[2] += part->translation[2] * gCurrAnimTranslationMultiplier;
+        }
+        mtxf_copy(matrix, part->rotation);
+        matrix[3][0] = translation[0];
+        matrix[3][1] = translation[1];
+        matrix[3][2] = translation[2];
+    } else {
+        mtxf_rotate_xyz_and_translate(matrix, translation, rotation);
+    }
+#else
     if (gCurrAnimType == ANIM_TYPE_TRANSLATION) {
         translation[0] += gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)]
                           * gCurrAnimTranslationMultiplier;
@@ -587,6 +1098,7 @@ static void geo_process_animated_part(struct GraphNodeAnimatedPart *node) {
         rotation[2] = gCurrAnimData[retrieve_animation_index(gCurrAnimFrame, &gCurrAnimAttribute)];
     }
     mtxf_rotate_xyz_and_translate(matrix, translation, rotation);
+#endif
     mtxf_mul(gMatStack[gMatStackIndex + 1], matrix, gMatStack[gMatStackIndex]);
     gMatStackIndex++;
     mtxf_to_mtx(matrixPtr, gMatStack[gMatStackIndex]);
@@ -625,6 +1137,10 @@ void geo_set_animation_globals(struct AnimInfo *node, s32 hasAnimation) {
     gCurrAnimEnabled = (anim->flags & ANIM_FLAG_5) == 0;
     gCurrAnimAttribute = segmented_to_virtual((void *) anim->index);
     gCurrAnimData = segmented_to_virtual((void *) anim->values);
+#ifdef ANIMATION_POSE_CACHE
+    sCurrAnimPose = find_anim_pose(anim, gCurrAnimFrame);
+    sCurrAnimPart = 0;
+#endif
 
     if (anim->animYTransDivisor == 0) {
         gCurrAnimTranslationMultiplier = 1.0f;
@@ -688,9 +1204,11 @@ static void geo_process_shadow(struct GraphNodeShadow *node) {
  * Check whether an object is in view to determine whether it should be drawn.
  * This is known as frustum culling.
  * It checks whether the object is far away, very close / behind the camera,
- * or horizontally out of view. It does not check whether it is vertically
- * out of view. It assumes a sphere of 300 units around the object's position
- * unless the object has a culling radius node that specifies otherwise.
+ * or horizontally out of view. With FRUSTUM_CULLING it also checks whether
+ * it is vertically out of view, except for Mario and objects holding another
+ * object, whose geo functions update the HOLP or the held object's position.
+ * It assumes a sphere of 300 units around the object's position unless the
+ * object has a culling radius node that specifies otherwise.
  *
  * The matrix parameter should be the top of the matrix stack, which is the
  * object's transformation matrix times the camera 'look-at' matrix. The math
@@ -715,6 +1233,26 @@ static void geo_process_shadow(struct GraphNodeShadow *node) {
  *
  * Since (0,0,0) is unaffected by rotation, columns 0, 1 and 2 are ignored.
  */
+#ifdef FRUSTUM_CULLING
+static s32 obj_is_in_view(struct GraphNodeObject *node, Mat4 matrix) {
+    struct GraphNode *geo = node->sharedChild;
+    f32 cullingRadius;
+
+    if (node->node.flags & GRAPH_RENDER_INVISIBLE) {
+        return CULL_OUTSIDE_VIEW;
+    }
+
+    if (geo != NULL && geo->type == GRAPH_NODE_TYPE_CULLING_RADIUS) {
+        cullingRadius = ((struct GraphNodeCullingRadius *) geo)->cullingRadius;
+    } else {
+        cullingRadius = 300.0f;
+    }
+
+    return sphere_in_view_frustum(matrix, cullingRadius,
+                                  (struct Object *) node != gMarioObject
+                                      && ((struct Object *) node)->prevObj == NULL);
+}
+#else
 static s32 obj_is_in_view(struct GraphNodeObject *node, Mat4 matrix) {
     s16 cullingRadius;
     s16 halfFov; // half of the fov in in-game angle units instead of degrees
@@ -772,6 +1310,7 @@ static s32 obj_is_in_view(struct GraphNodeObject *node, Mat4 matrix) {
     }
     return TRUE;
 }
+#endif
 
 /**
  * Process an object node.
@@ -779,6 +1318,10 @@ static s32 obj_is_in_view(struct GraphNodeObject *node, Mat4 matrix) {
 static void geo_process_object(struct Object *node) {
     Mat4 mtxf;
     s32 hasAnimation = (node->header.gfx.node.flags & GRAPH_RENDER_HAS_ANIMATION) != 0;
+#ifdef FRUSTUM_CULLING
+    s32 prevSubtreeInView = sSubtreeInView;
+    s32 inView;
+#endif
 
     if (node->header.gfx.areaIndex == gCurGraphNodeRoot->areaIndex) {
         if (node->header.gfx.throwMatrix != NULL) {
@@ -803,8 +1346,16 @@ static void geo_process_object(struct Object *node) {
         if (node->header.gfx.animInfo.curAnim != NULL) {
             geo_set_animation_globals(&node->header.gfx.animInfo, hasAnimation);
         }
+#ifdef FRUSTUM_CULLING
+        inView = obj_is_in_view(&node->header.gfx, gMatStack[gMatStackIndex]);
+        if (inView != CULL_OUTSIDE_VIEW) {
+            Mtx *mtx = alloc_display_list(sizeof(*mtx));
+
+            sSubtreeInView = (inView == CULL_IN_VIEW);
+#else
         if (obj_is_in_view(&node->header.gfx, gMatStack[gMatStackIndex])) {
             Mtx *mtx = alloc_display_list(sizeof(*mtx));
+#endif
 
             mtxf_to_mtx(mtx, gMatStack[gMatStackIndex]);
             gMatStackFixed[gMatStackIndex] = mtx;
@@ -818,6 +1369,9 @@ static void geo_process_object(struct Object *node) {
             if (node->header.gfx.node.children != NULL) {
                 geo_process_node_and_siblings(node->header.gfx.node.children);
             }
+#ifdef FRUSTUM_CULLING
+            sSubtreeInView = prevSubtreeInView;
+#endif
         }
 
         gMatStackIndex--;
@@ -826,6 +1380,29 @@ static void geo_process_object(struct Object *node) {
     }
 }
 
+#ifdef FRUSTUM_CULLING
+/**
+ * Process a culling radius node. The one at the root of an object's model was
+ * already tested by obj_is_in_view, but any other one (deeper in a model, or
+ * in a level's geo layout) skips its children if they're outside the view.
+ */
+static void geo_process_culling_radius(struct GraphNodeCullingRadius *node) {
+    s32 prevSubtreeInView = sSubtreeInView;
+    s32 inView = CULL_IN_VIEW;
+
+    if (!sSubtreeInView && gCurGraphNodeCamera != NULL && gCurGraphNodeCamFrustum != NULL
+        && (node->node.parent == NULL || node->node.parent->type != GRAPH_NODE_TYPE_OBJECT)) {
+        inView = sphere_in_view_frustum(gMatStack[gMatStackIndex], node->cullingRadius, TRUE);
+        sSubtreeInView = (inView == CULL_IN_VIEW);
+    }
+
+    if (inView != CULL_OUTSIDE_VIEW && node->node.children != NULL) {
+        geo_process_node_and_siblings(node->node.children);
+    }
+    sSubtreeInView = prevSubtreeInView;
+}
+#endif
+
 /**
  * Process an object parent node. Temporarily assigns itself as the parent of
  * the subtree rooted at 'sharedChild' and processes the subtree, after which the
@@ -859,6 +1436,10 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
     }
     if (node->objNode != NULL && node->objNode->header.gfx.sharedChild != NULL) {
         s32 hasAnimation = (node->objNode->header.gfx.node.flags & GRAPH_RENDER_HAS_ANIMATION) != 0;
+#ifdef ANIMATION_POSE_CACHE
+        struct AnimPose *prevAnimPose;
+        s32 prevAnimPart;
+#endif
 
         translation[0] = node->translation[0] / 4.0f;
         translation[1] = node->translation[1] / 4.0f;
@@ -885,6 +1466,10 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gGeoTempState.translationMultiplier = gCurrAnimTranslationMultiplier;
         gGeoTempState.attribute = gCurrAnimAttribute;
         gGeoTempState.data = gCurrAnimData;
+#ifdef ANIMATION_POSE_CACHE
+        prevAnimPose = sCurrAnimPose;
+        prevAnimPart = sCurrAnimPart;
+#endif
         gCurrAnimType = 0;
         gCurGraphNodeHeldObject = (void *) node;
         if (node->objNode->header.gfx.animInfo.curAnim != NULL) {
@@ -899,6 +1484,10 @@ void geo_process_held_object(struct GraphNodeHeldObject *node) {
         gCurrAnimTranslationMultiplier = gGeoTempState.translationMultiplier;
         gCurrAnimAttribute = gGeoTempState.attribute;
         gCurrAnimData = gGeoTempState.data;
+#ifdef ANIMATION_POSE_CACHE
+        sCurrAnimPose = prevAnimPose;
+        sCurrAnimPart = prevAnimPart;
+#endif
         gMatStackIndex--;
     }
 
@@ -996,6 +1585,11 @@ void geo_process_node_and_siblings(struct GraphNode *firstNode) {
                     case GRAPH_NODE_TYPE_HELD_OBJ:
                         geo_process_held_object((struct GraphNodeHeldObject *) curGraphNode);
                         break;
+#ifdef FRUSTUM_CULLING
+                    case GRAPH_NODE_TYPE_CULLING_RADIUS:
+                        geo_process_culling_radius((struct GraphNodeCullingRadius *) curGraphNode);
+                        break;
+#endif
                     default:
                         geo_try_process_children((struct GraphNode *) curGraphNode);
                         break;
@@ -1026,6 +1620,23 @@ void geo_process_root(struct GraphNodeRoot *node, Vp *b, Vp *c, s32 clearColor)
         initialMatrix = alloc_display_list(sizeof(*initialMatrix));
         gMatStackIndex = 0;
         gCurrAnimType = 0;
+#ifdef ANIMATION_POSE_CACHE
+        sAnimPoseCacheTimestamp++;
+        gAnimPoseCacheStats.numPoses = 0;
+        gAnimPoseCacheStats.numHits = 0;
+        gAnimPoseCacheStats.numMisses = 0;
+#endif
+#ifdef FRUSTUM_CULLING
+        gCullingStats.numInView = 0;
+        gCullingStats.numPartlyInView = 0;
+        gCullingStats.numCulled = 0;
+#endif
+#ifdef MASTER_LIST_SORTING
+        gMasterListStats.numCommandsBefore = 0;
+        gMasterListStats.numCommandsAfter = 0;
+        gMasterListStats.numDisplayLists = 0;
+        gMasterListStats.numMatrixLoads = 0;
+#endif
         vec3s_set(viewport->vp.vtrans, node->x * 4, node->y * 4, 511);
         vec3s_set(viewport->vp.vscale, node->width * 4, node->height * 4, 511);
         if (b != NULL) {
@@ -13,6 +13,56 @@ extern struct GraphNodeObject *gCurGraphNodeObject;
 extern struct GraphNodeHeldObject *gCurGraphNodeHeldObject;
 extern u16 gAreaUpdateCounter;
 
+#ifdef ANIMATION_POSE_CACHE
+/**
+ * How the animation pose cache did in the last frame. A hit is an animated part
+ * whose values were already read by another object in the same pose.
+ */
+struct AnimPoseCacheStats {
+    u16 numPoses;
+    u16 numHits;
+    u16 numMisses;
+};
+
+extern struct AnimPoseCacheStats gAnimPoseCacheStats;
+#endif
+
+#ifdef FRUSTUM_CULLING
+// Results of testing a culling sphere against the view frustum
+#define CULL_OUTSIDE_VIEW   0
+#define CULL_PARTLY_IN_VIEW 1
+#define CULL_IN_VIEW        2
+
+/**
+ * How the culling spheres of objects and culling radius nodes were found in
+ * the last frame. Nodes under a sphere that was entirely in view aren't tested.
+ */
+struct CullingStats {
+    u16 numInView;
+    u16 numPartlyInView;
+    u16 numCulled;
+};
+
+extern struct CullingStats gCullingStats;
+#endif
+
+#ifdef MASTER_LIST_SORTING
+/**
+ * What the master lists of the last frame were drawn with. numCommandsBefore
+ * is what they would have taken without sorting and matrix elision.
+ */
+struct MasterListStats {
+    u32 numCommandsBefore;
+    u32 numCommandsAfter;
+    u16 numDisplayLists;
+    u16 numMatrixLoads;
+};
+
+extern struct MasterListStats gMasterListStats;
+
+void reset_display_list_color_cache(void);
+#endif
+
 // after processing an object, the type is reset to this
 #define ANIM_TYPE_NONE                  0
 
@@ -32,6 +32,10 @@
 #define DYNOBJ_LIST_SIZE 3000
 /// Maximum number of verticies supported when adding vertices node to an `ObjShape`
 #define VTX_BUF_SIZE 3000
+#ifdef GODDARD_DYNOBJ_INDEX
+/// Number of buckets in the dynamic object name hash table (a power of two)
+#define DYNOBJ_HASH_SIZE 1024
+#endif
 
 // types
 /// Information about a dynamically created `GdObj`
@@ -40,6 +44,9 @@ struct DynObjInfo {
     struct GdObj *obj;
     s32 num;
     s32 unk;
+#ifdef GODDARD_DYNOBJ_INDEX
+    s16 hashNext; ///< index of the next object in the same hash bucket, or -1
+#endif
 };
 /// @name DynList Accessors
 /// Accessor marcos for easy interpretation of data in a `DynList` packet
@@ -77,6 +84,10 @@ static s32
     sUnnamedObjCount; // @ 801B9F28; used to print empty string ids (not NULL char *) to sDynNameSuffix
 static s32 sLoadedDynObjs;                 // @ 801B9F2C; total loaded dynobjs
 static struct DynObjInfo *sDynListCurInfo; // @ 801B9F30; info for most recently added object
+#ifdef GODDARD_DYNOBJ_INDEX
+static s16 sDynObjHashHeads[DYNOBJ_HASH_SIZE]; ///< first object in each hash bucket, or -1
+struct DynObjLookupStats gDynObjLookupStats;
+#endif
 static struct DynObjInfo
     *sParentObjInfo; ///< Information for `ObjNet` made by `d_add_net_with_subgroup()` or `ObjJoint`
                      ///< made by `d_attach_joint_to_net()`
@@ -151,6 +162,12 @@ void reset_dynlist(void) {
     sDynNetCount = 0;
     sUseIntegerNames = FALSE;
     gd_strcpy(sNullDynObjInfo.name, "NullObj");
+#ifdef GODDARD_DYNOBJ_INDEX
+    gDynObjLookupStats.lookups = 0;
+    gDynObjLookupStats.intLookups = 0;
+    gDynObjLookupStats.misses = 0;
+    gDynObjLookupStats.compares = 0;
+#endif
 }
 
 /**
@@ -393,6 +410,74 @@ static void unstash_name_suffix(void) {
     gd_strcpy(sDynNameSuffix, sStashedDynNameSuffix);
 }
 
+#ifdef GODDARD_DYNOBJ_INDEX
+/**
+ * Hash a dynamic object name (including its suffix) into a bucket index.
+ */
+static u32 dynobj_name_hash(const char *name) {
+    u32 hash = 0;
+
+    while (*name != '\0') {
+        hash = hash * 31 + (u8) *name++;
+    }
+    return hash & (DYNOBJ_HASH_SIZE - 1);
+}
+
+/**
+ * Write the name of integer id `id` ("N" followed by the id in decimal, as
+ * `sprintf(buf, "N%d", id)` would) into `buf`.
+ *
+ * @returns pointer to the terminating null character of `buf`
+ */
+static char *format_integer_name(char *buf, s32 id) {
+    char digits[12];
+    u32 value;
+    s32 len = 0;
+
+    *buf++ = 'N';
+    if (id < 0) {
+        *buf++ = '-';
+        value = -(u32) id;
+    } else {
+        value = id;
+    }
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    while (len > 0) {
+        *buf++ = digits[--len];
+    }
+    *buf = '\0';
+    return buf;
+}
+
+/**
+ * Empty every hash bucket, for a new `sGdDynObjList`.
+ */
+static void clear_dynobj_hash(void) {
+    s32 i;
+
+    for (i = 0; i < DYNOBJ_HASH_SIZE; i++) {
+        sDynObjHashHeads[i] = -1;
+    }
+}
+
+/**
+ * Add the object at `index` in `sGdDynObjList` to the end of its hash bucket,
+ * so that lookups still find the first object made with a name.
+ */
+static void add_to_dynobj_hash(s32 index) {
+    s16 *link = &sDynObjHashHeads[dynobj_name_hash(sGdDynObjList[index].name)];
+
+    while (*link >= 0) {
+        link = &sGdDynObjList[*link].hashNext;
+    }
+    sGdDynObjList[index].hashNext = -1;
+    *link = index;
+}
+#endif
+
 /**
  * Get the `DynObjInfo` struct for object `name`
  *
@@ -408,6 +493,28 @@ static struct DynObjInfo *get_dynobj_info(DynObjName name) {
         return NULL;
     }
 
+#ifdef GODDARD_DYNOBJ_INDEX
+    gDynObjLookupStats.lookups++;
+    if (sUseIntegerNames) {
+        gDynObjLookupStats.intLookups++;
+        gd_strcpy(format_integer_name(buf, DynNameAsInt(name)), sDynNameSuffix);
+    } else {
+        gd_strcpy(buf, DynNameAsStr(name));
+        gd_strcat(buf, sDynNameSuffix);
+    }
+
+    foundDynobj = NULL;
+    for (i = sDynObjHashHeads[dynobj_name_hash(buf)]; i >= 0; i = sGdDynObjList[i].hashNext) {
+        gDynObjLookupStats.compares++;
+        if (gd_str_not_equal(sGdDynObjList[i].name, buf) == 0) {
+            foundDynobj = &sGdDynObjList[i];
+            break;
+        }
+    }
+    if (foundDynobj == NULL) {
+        gDynObjLookupStats.misses++;
+    }
+#else
     if (sUseIntegerNames) {
         sprintf(buf, "N%d", DynNameAsInt(name));
     } else {
@@ -422,6 +529,7 @@ static struct DynObjInfo *get_dynobj_info(DynObjName name) {
             break;
         }
     }
+#endif
 
     return foundDynobj;
 }
@@ -541,12 +649,19 @@ void add_to_dynobj_list(struct GdObj *newobj, DynObjName name) {
         if (sGdDynObjList == NULL) {
             fatal_printf("dMakeObj(): Cant allocate dynlist memory");
         }
+#ifdef GODDARD_DYNOBJ_INDEX
+        clear_dynobj_hash();
+#endif
     }
 
     stop_memtracker("dynlist");
 
     if (sUseIntegerNames) {
+#ifdef GODDARD_DYNOBJ_INDEX
+        format_integer_name(idbuf, DynNameAsInt(name));
+#else
         sprintf(idbuf, "N%d", DynNameAsInt(name));
+#endif
         name = NULL;
     } else {
         sprintf(idbuf, "U%d", ((u32) sLoadedDynObjs) + 1);
@@ -566,6 +681,9 @@ void add_to_dynobj_list(struct GdObj *newobj, DynObjName name) {
     if (gd_strlen(sGdDynObjList[sLoadedDynObjs].name) > (DYNOBJ_NAME_SIZE - 1)) {
         fatal_printf("dyn list obj name too long '%s'", sGdDynObjList[sLoadedDynObjs].name);
     }
+#ifdef GODDARD_DYNOBJ_INDEX
+    add_to_dynobj_hash(sLoadedDynObjs);
+#endif
 
     sGdDynObjList[sLoadedDynObjs].num = sLoadedDynObjs;
     sDynListCurInfo = &sGdDynObjList[sLoadedDynObjs];
@@ -3,6 +3,7 @@
 
 #include <PR/ultratypes.h>
 
+#include "config.h"
 #include "gd_types.h"
 
 // types
@@ -19,6 +20,16 @@ typedef void *DynObjName;
 /// @}
 /// @}
 
+#ifdef GODDARD_DYNOBJ_INDEX
+/// Counts for `get_dynobj_info()` since the last `reset_dynlist()`
+struct DynObjLookupStats {
+    u32 lookups;    ///< names looked up
+    u32 intLookups; ///< lookups of integer names
+    u32 misses;     ///< lookups that didn't find an object
+    u32 compares;   ///< names compared against
+};
+#endif
+
 /// parameters types for `d_set_parm_ptr()`
 enum DParmPtr {
     PARM_PTR_OBJ_VTX = 1, ///< parameter is the index of a vertex to add to an `ObjFace`
@@ -56,6 +67,11 @@ enum DObjTypes {
     D_GROUP         = 18
 };
 
+// data
+#ifdef GODDARD_DYNOBJ_INDEX
+extern struct DynObjLookupStats gDynObjLookupStats;
+#endif
+
 // functions
 void d_stash_dynobj(void);
 void d_unstash_dynobj(void);
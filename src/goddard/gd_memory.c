@@ -2,6 +2,7 @@
 
 #include "debug_utils.h"
 #include "gd_memory.h"
+#include "platform_info.h"
 #include "renderer.h"
 
 /**
@@ -12,18 +13,68 @@
  * are `gd_malloc()`, `gd_malloc_perm()`, and `gd_malloc_temp()`, as
  * well as `gd_free()`. This file is for managing the underlying memory
  * block lists.
+ *
+ * With `GODDARD_SLAB_ALLOCATOR`, small requests are instead served from
+ * slabs: pages of heap memory, taken from the block lists, that are cut into
+ * equal slots of one size class. A slot costs no `GMemBlock` of its own,
+ * and handing one out or taking one back doesn't walk the block lists.
  */
 
+#ifdef GODDARD_SLAB_ALLOCATOR
+/// Bytes of heap memory to cut into slots at a time
+#define SLAB_PAGE_SIZE DOUBLE_SIZE_ON_64_BIT(0x1000)
+/// Largest request that is served from a slab
+#define SLAB_MAX_SIZE 768
+/// Most slab pages held at once; requests beyond that go to the block lists
+#define SLAB_MAX_PAGES 256
+/// Most permanence values that get slabs of their own
+#define SLAB_PERM_SETS 4
+
+/// A page of heap memory that is cut into slots of one size class
+struct GdSlabPage {
+    /* 0x00 */ u8 *base;
+    /* 0x04 */ u8 *freeSlot;          ///< first slot given back; each holds a pointer to the next
+    /* 0x08 */ u16 slotCount;
+    /* 0x0A */ u16 carved;            ///< slots handed out from the never used end of the page
+    /* 0x0C */ u16 used;              ///< slots in use
+    /* 0x0E */ u8 sizeClass;
+    /* 0x0F */ u8 permSet;            ///< index into `sSlabPermanence`
+    /* 0x10 */ struct GdSlabPage *next; ///< next page with free slots of the same class and
+                                        ///< permanence, or next unused page record
+};
+
+/// Slot sizes of the size classes; a request takes the first class it fits in
+static const u16 sSlabClassSizes[GD_SLAB_CLASS_COUNT] = {
+    8,   16,  24,  32,  40,  48,  56,  64,  72,  80,  88,  96,  104,
+    112, 120, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768,
+};
+#endif
+
 /* bss */
 static struct GMemBlock *sFreeBlockListHead;
 static struct GMemBlock *sUsedBlockListHead;
 static struct GMemBlock *sEmptyBlockListHead;
+#ifdef GODDARD_SLAB_ALLOCATOR
+struct GdMemStats gGdMemStats;
+static u8 sSlabClassOfSize[SLAB_MAX_SIZE / 8 + 1]; ///< size class of each size in eight byte units
+static u8 sSlabPermanence[SLAB_PERM_SETS];
+static s32 sSlabPermSetCount;
+/// Pages with free slots, for each permanence and size class
+static struct GdSlabPage *sSlabPartialPages[SLAB_PERM_SETS][GD_SLAB_CLASS_COUNT];
+static struct GdSlabPage sSlabPageRecords[SLAB_MAX_PAGES];
+static struct GdSlabPage *sUnusedSlabPages;
+/// Every page held, sorted by address, to find the page of a slot being freed
+static struct GdSlabPage *sSlabPagesByAddr[SLAB_MAX_PAGES];
+static s32 sSlabPageCount;
+#endif
 
 /* Forward Declarations */
 void empty_mem_block(struct GMemBlock *);
 struct GMemBlock *into_free_memblock(struct GMemBlock *);
 struct GMemBlock *make_mem_block(u32, u8);
 u32 print_list_stats(struct GMemBlock *, s32, s32);
+static u32 free_mem_block(void *ptr);
+static void *request_mem_block(u32 size, u8 permanence);
 
 /**
  * Empty a `GMemBlock` into a default state. This empty block
@@ -143,13 +194,13 @@ struct GMemBlock *make_mem_block(u32 blockType, u8 permFlag) {
 }
 
 /**
- * Free memory allocated on the goddard heap.
+ * Free memory allocated from the block lists.
  *
  * @param ptr pointer to heap allocated memory
  * @returns size of memory freed
  * @retval  0    `ptr` did not point to a valid memory block
  */
-u32 gd_free_mem(void *ptr) {
+static u32 free_mem_block(void *ptr) {
     register struct GMemBlock *curBlock;
     u32 bytesFreed;
     register u8 *targetBlock = ptr;
@@ -167,13 +218,13 @@ u32 gd_free_mem(void *ptr) {
 }
 
 /**
- * Request a pointer to goddard heap memory of at least `size` and
- * of the same `permanence`.
+ * Request memory of at least `size` and of the same `permanence` from the
+ * free block list.
  *
  * @return pointer to heap
  * @retval NULL could not fulfill the request
  */
-void *gd_request_mem(u32 size, u8 permanence) {
+static void *request_mem_block(u32 size, u8 permanence) {
     struct GMemBlock *foundBlock = NULL;
     struct GMemBlock *curBlock;
     struct GMemBlock *newBlock;
@@ -220,6 +271,278 @@ void *gd_request_mem(u32 size, u8 permanence) {
     return newBlock->ptr;
 }
 
+#ifdef GODDARD_SLAB_ALLOCATOR
+/**
+ * Return the index into `sSlabPermanence` of the slabs for `permanence`,
+ * adding it if there is room.
+ *
+ * @retval -1 there are slabs for too many other permanences already
+ */
+static s32 slab_perm_set(u8 permanence) {
+    s32 i;
+
+    for (i = 0; i < sSlabPermSetCount; i++) {
+        if (sSlabPermanence[i] == permanence) {
+            return i;
+        }
+    }
+    if (sSlabPermSetCount == SLAB_PERM_SETS) {
+        return -1;
+    }
+    sSlabPermanence[sSlabPermSetCount] = permanence;
+    return sSlabPermSetCount++;
+}
+
+/**
+ * Take a page for slots of `sizeClass` from the block lists, and make it the
+ * first page with free slots of its class.
+ *
+ * @retval NULL out of page records or heap memory
+ */
+static struct GdSlabPage *make_slab_page(s32 sizeClass, s32 permSet) {
+    struct GdSlabPage *page;
+    struct GdSlabClassStats *stats = &gGdMemStats.classes[sizeClass];
+    u32 slotSize = sSlabClassSizes[sizeClass];
+    u32 slotCount;
+    u8 *base;
+    s32 i;
+
+    // Many classes only ever have a few slots in use, so their first two pages
+    // are a quarter and a half of the size
+    if (stats->pages < 2) {
+        slotCount = (SLAB_PAGE_SIZE >> (2 - stats->pages)) / slotSize;
+    } else {
+        slotCount = SLAB_PAGE_SIZE / slotSize;
+    }
+
+    if ((page = sUnusedSlabPages) == NULL) {
+        return NULL;
+    }
+    if ((base = request_mem_block(slotCount * slotSize, sSlabPermanence[permSet])) == NULL) {
+        return NULL;
+    }
+    sUnusedSlabPages = page->next;
+
+    page->base = base;
+    page->freeSlot = NULL;
+    page->slotCount = slotCount;
+    page->carved = 0;
+    page->used = 0;
+    page->sizeClass = sizeClass;
+    page->permSet = permSet;
+    page->next = sSlabPartialPages[permSet][sizeClass];
+    sSlabPartialPages[permSet][sizeClass] = page;
+
+    for (i = sSlabPageCount; i > 0 && sSlabPagesByAddr[i - 1]->base > base; i--) {
+        sSlabPagesByAddr[i] = sSlabPagesByAddr[i - 1];
+    }
+    sSlabPagesByAddr[i] = page;
+    sSlabPageCount++;
+
+    stats->slots += slotCount;
+    if (++stats->pages > stats->peakPages) {
+        stats->peakPages = stats->pages;
+    }
+    gGdMemStats.slabBytes += slotCount * slotSize;
+    if (gGdMemStats.slabBytes > gGdMemStats.peakSlabBytes) {
+        gGdMemStats.peakSlabBytes = gGdMemStats.slabBytes;
+    }
+    return page;
+}
+
+/**
+ * Give an empty slab page's memory back to the block lists.
+ */
+static void free_slab_page(struct GdSlabPage *page) {
+    struct GdSlabPage **link = &sSlabPartialPages[page->permSet][page->sizeClass];
+    s32 i;
+
+    while (*link != page) {
+        link = &(*link)->next;
+    }
+    *link = page->next;
+
+    for (i = 0; sSlabPagesByAddr[i] != page; i++) {
+        ;
+    }
+    for (sSlabPageCount--; i < sSlabPageCount; i++) {
+        sSlabPagesByAddr[i] = sSlabPagesByAddr[i + 1];
+    }
+
+    gGdMemStats.classes[page->sizeClass].slots -= page->slotCount;
+    gGdMemStats.classes[page->sizeClass].pages--;
+    gGdMemStats.slabBytes -= free_mem_block(page->base);
+    page->next = sUnusedSlabPages;
+    sUnusedSlabPages = page;
+}
+
+/**
+ * Hand out a slot of the size class that `size` fits in.
+ *
+ * @retval NULL the request has to go to the block lists instead
+ */
+static void *slab_alloc(u32 size, u8 permanence) {
+    struct GdSlabPage *page;
+    struct GdSlabClassStats *stats;
+    s32 sizeClass = sSlabClassOfSize[(size + 7) / 8];
+    s32 permSet;
+    u8 *slot;
+
+    if ((permSet = slab_perm_set(permanence)) < 0) {
+        return NULL;
+    }
+    if ((page = sSlabPartialPages[permSet][sizeClass]) == NULL) {
+        if ((page = make_slab_page(sizeClass, permSet)) == NULL) {
+            return NULL;
+        }
+    }
+
+    if ((slot = page->freeSlot) != NULL) {
+        page->freeSlot = *(u8 **) slot;
+    } else {
+        slot = page->base + page->carved * sSlabClassSizes[sizeClass];
+        page->carved++;
+    }
+    if (++page->used == page->slotCount) {
+        sSlabPartialPages[permSet][sizeClass] = page->next;
+    }
+
+    stats = &gGdMemStats.classes[sizeClass];
+    stats->allocs++;
+    if (++stats->inUse > stats->peakInUse) {
+        stats->peakInUse = stats->inUse;
+    }
+    return slot;
+}
+
+/**
+ * Find the slab page that `ptr` is a slot of.
+ *
+ * @retval NULL `ptr` is not in a slab page
+ */
+static struct GdSlabPage *find_slab_page(u8 *ptr) {
+    struct GdSlabPage *page;
+    s32 lo = 0;
+    s32 hi = sSlabPageCount;
+    s32 mid;
+
+    // Find the last page that starts at or below `ptr`
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (sSlabPagesByAddr[mid]->base <= ptr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return NULL;
+    }
+    page = sSlabPagesByAddr[lo - 1];
+    if (ptr >= page->base + page->slotCount * sSlabClassSizes[page->sizeClass]) {
+        return NULL;
+    }
+    return page;
+}
+
+/**
+ * Give back the slot at `ptr` of `page`. Pages that become empty are given
+ * back to the block lists, except for the last one with free slots of its
+ * class, so that a class that is freed and allocated in turn doesn't keep
+ * taking and giving back a page.
+ *
+ * @returns size of the slot
+ */
+static u32 slab_free(struct GdSlabPage *page, u8 *ptr) {
+    struct GdSlabPage **partialHead = &sSlabPartialPages[page->permSet][page->sizeClass];
+    u32 slotSize = sSlabClassSizes[page->sizeClass];
+
+    if ((u32) (ptr - page->base) % slotSize != 0) {
+        fatal_printf("Free() Not a valid memory block");
+    }
+    if (page->used == page->slotCount) {
+        page->next = *partialHead;
+        *partialHead = page;
+    }
+    *(u8 **) ptr = page->freeSlot;
+    page->freeSlot = ptr;
+    page->used--;
+
+    gGdMemStats.classes[page->sizeClass].frees++;
+    gGdMemStats.classes[page->sizeClass].inUse--;
+
+    if (page->used == 0 && (*partialHead != page || page->next != NULL)) {
+        free_slab_page(page);
+    }
+    return slotSize;
+}
+
+/**
+ * Round `size` up to what `gd_request_mem()` will hand out for it, which is
+ * what `gd_free_mem()` returns when it is freed.
+ */
+u32 gd_mem_request_size(u32 size) {
+    if (size > SLAB_MAX_SIZE) {
+        return size;
+    }
+    return sSlabClassSizes[sSlabClassOfSize[(size + 7) / 8]];
+}
+#endif
+
+/**
+ * Free memory allocated on the goddard heap.
+ *
+ * @param ptr pointer to heap allocated memory
+ * @returns size of memory freed
+ * @retval  0    `ptr` did not point to a valid memory block
+ */
+u32 gd_free_mem(void *ptr) {
+#ifdef GODDARD_SLAB_ALLOCATOR
+    struct GdSlabPage *page;
+    u32 bytesFreed;
+
+    if ((page = find_slab_page(ptr)) != NULL) {
+        bytesFreed = slab_free(page, ptr);
+    } else {
+        bytesFreed = free_mem_block(ptr);
+    }
+    gGdMemStats.inUse -= bytesFreed;
+    return bytesFreed;
+#else
+    return free_mem_block(ptr);
+#endif
+}
+
+/**
+ * Request a pointer to goddard heap memory of at least `size` and
+ * of the same `permanence`.
+ *
+ * @return pointer to heap
+ * @retval NULL could not fulfill the request
+ */
+void *gd_request_mem(u32 size, u8 permanence) {
+#ifdef GODDARD_SLAB_ALLOCATOR
+    void *ptr = NULL;
+
+    if (size <= SLAB_MAX_SIZE) {
+        ptr = slab_alloc(size, permanence);
+    }
+    if (ptr == NULL) {
+        if ((ptr = request_mem_block(size, permanence)) == NULL) {
+            return NULL;
+        }
+        gGdMemStats.blockAllocs++;
+    }
+    gGdMemStats.inUse += size;
+    if (gGdMemStats.inUse > gGdMemStats.peak) {
+        gGdMemStats.peak = gGdMemStats.inUse;
+    }
+    return ptr;
+#else
+    return request_mem_block(size, permanence);
+#endif
+}
+
 /**
  * Add memory of `size` at `addr` to the goddard heap for later allocation.
  *
@@ -242,9 +565,52 @@ struct GMemBlock *gd_add_mem_to_heap(u32 size, void *addr, u8 permanence) {
  * NULL the various `GMemBlock` list heads
  */
 void init_mem_block_lists(void) {
+#ifdef GODDARD_SLAB_ALLOCATOR
+    struct GdSlabClassStats *stats;
+    s32 i;
+    s32 j;
+#endif
+
     sFreeBlockListHead = NULL;
     sUsedBlockListHead = NULL;
     sEmptyBlockListHead = NULL;
+
+#ifdef GODDARD_SLAB_ALLOCATOR
+    for (i = 0, j = 0; i <= SLAB_MAX_SIZE / 8; i++) {
+        if (i * 8 > sSlabClassSizes[j]) {
+            j++;
+        }
+        sSlabClassOfSize[i] = j;
+    }
+    for (i = 0; i < SLAB_PERM_SETS; i++) {
+        for (j = 0; j < GD_SLAB_CLASS_COUNT; j++) {
+            sSlabPartialPages[i][j] = NULL;
+        }
+    }
+    sSlabPermSetCount = 0;
+    sSlabPageCount = 0;
+    sUnusedSlabPages = NULL;
+    for (i = SLAB_MAX_PAGES - 1; i >= 0; i--) {
+        sSlabPageRecords[i].next = sUnusedSlabPages;
+        sUnusedSlabPages = &sSlabPageRecords[i];
+    }
+
+    gGdMemStats.inUse = 0;
+    gGdMemStats.peak = 0;
+    gGdMemStats.slabBytes = 0;
+    gGdMemStats.peakSlabBytes = 0;
+    gGdMemStats.blockAllocs = 0;
+    for (i = 0; i < GD_SLAB_CLASS_COUNT; i++) {
+        stats = &gGdMemStats.classes[i];
+        stats->allocs = 0;
+        stats->frees = 0;
+        stats->inUse = 0;
+        stats->peakInUse = 0;
+        stats->slots = 0;
+        stats->pages = 0;
+        stats->peakPages = 0;
+    }
+#endif
 }
 
 /**
@@ -311,4 +677,65 @@ void mem_stats(void) {
     gd_printf("Empty blocks:\n");
     list = sEmptyBlockListHead;
     print_list_stats(list, FALSE, PERM_G_MEM_BLOCK | TEMP_G_MEM_BLOCK);
+#ifdef GODDARD_SLAB_ALLOCATOR
+    gd_printf("\n");
+    slab_stats();
+#endif
+}
+
+#ifdef GODDARD_SLAB_ALLOCATOR
+/**
+ * Print the counts for every slab size class that has been used, and how
+ * fragmented the slabs and the free block list are: the free slots in the
+ * slab pages, and how much of the free perm and temp memory is in the
+ * largest free block.
+ */
+void slab_stats(void) {
+    struct GdSlabClassStats *stats;
+    struct GMemBlock *block;
+    u32 slotBytes;
+    u32 slabUsed = 0;
+    u32 freeBytes;
+    u32 largestFree;
+    s32 freeBlocks;
+    s32 permanence;
+    s32 i;
+
+    gd_printf("Slab size classes:\n");
+    for (i = 0; i < GD_SLAB_CLASS_COUNT; i++) {
+        stats = &gGdMemStats.classes[i];
+        if (stats->peakPages == 0) {
+            continue;
+        }
+        slotBytes = sSlabClassSizes[i];
+        gd_printf("  %d bytes: %d of %d slots used (peak %d) in %d pages (peak %d), %d allocs, %d frees\n",
+                  slotBytes, stats->inUse, stats->slots,
+                  stats->peakInUse, stats->pages, stats->peakPages, stats->allocs, stats->frees);
+        slabUsed += stats->inUse * slotBytes;
+    }
+    gd_printf("Slabs %6.2fk (peak %6.2fk), %6.2fk in free slots\n",
+              (f32) gGdMemStats.slabBytes / 1024.0, (f32) gGdMemStats.peakSlabBytes / 1024.0,
+              (f32) (gGdMemStats.slabBytes - slabUsed) / 1024.0);
+
+    for (i = 0; i < 2; i++) {
+        permanence = (i == 0) ? PERM_G_MEM_BLOCK : TEMP_G_MEM_BLOCK;
+        freeBytes = 0;
+        largestFree = 0;
+        freeBlocks = 0;
+        for (block = sFreeBlockListHead; block != NULL; block = block->next) {
+            if (block->permFlag & permanence) {
+                freeBlocks++;
+                freeBytes += block->size;
+                if (block->size > largestFree) {
+                    largestFree = block->size;
+                }
+            }
+        }
+        gd_printf("%s free blocks %6.2fk in %d entries, largest %6.2fk\n", i == 0 ? "Perm" : "Temp",
+                  (f32) freeBytes / 1024.0, freeBlocks, (f32) largestFree / 1024.0);
+    }
+    gd_printf("In use %6.2fk (peak %6.2fk), %d requests from the block lists\n",
+              (f32) gGdMemStats.inUse / 1024.0, (f32) gGdMemStats.peak / 1024.0,
+              gGdMemStats.blockAllocs);
 }
+#endif
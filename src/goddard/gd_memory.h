@@ -3,6 +3,8 @@
 
 #include <PR/ultratypes.h>
 
+#include "config.h"
+
 /// A structure that holds information about memory allocation on goddard's heap.
 struct GMemBlock {
     /* 0x00 */ u8 *ptr;
@@ -25,11 +27,46 @@ enum GMemBlockTypes {
 #define PERM_G_MEM_BLOCK 0xF0
 #define TEMP_G_MEM_BLOCK 0x0F
 
+#ifdef GODDARD_SLAB_ALLOCATOR
+/// Number of slab size classes; see `sSlabClassSizes` in gd_memory.c
+#define GD_SLAB_CLASS_COUNT 26
+
+/// Counts for one slab size class since the last `init_mem_block_lists()`
+struct GdSlabClassStats {
+    u32 allocs;    ///< slots handed out
+    u32 frees;     ///< slots given back
+    u32 inUse;     ///< slots in use now
+    u32 peakInUse; ///< most slots in use at once
+    u32 slots;     ///< slots in the pages held now
+    u32 pages;     ///< pages held now
+    u32 peakPages; ///< most pages held at once
+};
+
+/// Counts for `gd_request_mem()` and `gd_free_mem()` since the last `init_mem_block_lists()`
+struct GdMemStats {
+    u32 inUse;         ///< bytes handed out now
+    u32 peak;          ///< most bytes handed out at once
+    u32 slabBytes;     ///< heap bytes held by slab pages now
+    u32 peakSlabBytes; ///< most heap bytes held by slab pages at once
+    u32 blockAllocs;   ///< requests that were served from the block lists
+    struct GdSlabClassStats classes[GD_SLAB_CLASS_COUNT];
+};
+#endif
+
+// data
+#ifdef GODDARD_SLAB_ALLOCATOR
+extern struct GdMemStats gGdMemStats;
+#endif
+
 // functions
 extern u32 gd_free_mem(void *ptr);
 extern void *gd_request_mem(u32 size, u8 permanence);
 extern struct GMemBlock *gd_add_mem_to_heap(u32 size, void *addr, u8 permanence);
 extern void init_mem_block_lists(void);
 extern void mem_stats(void);
+#ifdef GODDARD_SLAB_ALLOCATOR
+extern u32 gd_mem_request_size(u32 size);
+extern void slab_stats(void);
+#endif
 
 #endif // GD_MEMORY_H
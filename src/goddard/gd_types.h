@@ -3,6 +3,8 @@
 
 #include <ultra64.h>
 
+#include "config.h"
+
 /* Vector Types */
 struct GdVec3f {
     f32 x, y, z;
@@ -349,6 +351,9 @@ struct ObjNet {
     /* 0x210 */ s32 ctrlType;     // has no purpose
     /* 0x214 */ u8  filler2[8];
     /* 0x21C */ struct ObjGroup *unk21C;
+#ifdef GODDARD_PACKED_SKIN
+               struct GdPackedSkin *packedSkin; // packed copy of the skin this net moves (see skin.c)
+#endif
 }; /* sizeof = 0x220 */
 
 struct ObjPlane {
@@ -154,6 +154,16 @@ UNUSED static u32 unref_801be948[13];
 static OSMesg sGdDMACompleteMsg; // msg buf for D_801BE8B0 queue
 static OSIoMesg sGdDMAReqMesg;
 static struct ObjView *D_801BE994; // store if View flag 0x40 set
+#ifdef GODDARD_HAND_DL_CACHE
+struct GdHandDlStats gHandDlStats;
+/// What the hand sprite display list for a frame buffer was last made from
+static struct {
+    s32 valid;
+    s32 x;
+    s32 y;
+    u16 *sprite;
+} sHandDlCache[2];
+#endif
 
 // data
 UNUSED static u32 unref_801a8670 = 0;
@@ -944,6 +954,10 @@ void *gd_allocblock(u32 size) {
 void *gd_malloc(u32 size, u8 perm) {
     void *ptr; // 1c
     size = ALIGN(size, 8);
+#ifdef GODDARD_SLAB_ALLOCATOR
+    // Count what gd_free will take away for it
+    size = gd_mem_request_size(size);
+#endif
     ptr = gd_request_mem(size, perm);
 
     if (ptr == NULL) {
@@ -2961,6 +2975,12 @@ void Unknown801A4B04(void) {
 
 /* 2533DC -> 253728; orig name: func_801A4C0C */
 void update_cursor(void) {
+#ifdef GODDARD_HAND_DL_CACHE
+    u16 *sprite;
+    s32 x;
+    s32 y;
+
+#endif
     if (sHandView == NULL)
         return;
 
@@ -2978,6 +2998,26 @@ void update_cursor(void) {
     sHandView->upperLeft.y = (f32) gGdCtrl.csrY;
 
     // Make hand display list
+#ifdef GODDARD_HAND_DL_CACHE
+    // unless the one for this frame buffer already shows the same hand in the same place
+    sprite = gGdCtrl.dragging ? (u16 *) gd_texture_hand_closed : (u16 *) gd_texture_hand_open;
+    x = sHandView->upperLeft.x;
+    y = sHandView->upperLeft.y;
+    gHandDlStats.dls++;
+    if (sHandDlCache[gGdFrameBufNum].valid && sHandDlCache[gGdFrameBufNum].sprite == sprite
+        && sHandDlCache[gGdFrameBufNum].x == x && sHandDlCache[gGdFrameBufNum].y == y) {
+        gHandDlStats.reused++;
+        sCurrentGdDl = sGdDLArray[sHandShape->dlNums[gGdFrameBufNum]];
+    } else {
+        sHandDlCache[gGdFrameBufNum].valid = TRUE;
+        sHandDlCache[gGdFrameBufNum].sprite = sprite;
+        sHandDlCache[gGdFrameBufNum].x = x;
+        sHandDlCache[gGdFrameBufNum].y = y;
+        begin_gddl(sHandShape->dlNums[gGdFrameBufNum]);
+        gd_put_sprite(sprite, x, y, 0x20, 0x20);
+        gd_enddlsplist_parent();
+    }
+#else
     begin_gddl(sHandShape->dlNums[gGdFrameBufNum]);
     if (gGdCtrl.dragging) {
         gd_put_sprite((u16 *) gd_texture_hand_closed, sHandView->upperLeft.x, sHandView->upperLeft.y,
@@ -2987,6 +3027,7 @@ void update_cursor(void) {
                       0x20, 0x20);
     }
     gd_enddlsplist_parent();
+#endif
 
     if (sHandView->upperLeft.x < sHandView->parent->upperLeft.x) {
         sHandView->upperLeft.x = sHandView->parent->upperLeft.x;
@@ -3123,7 +3164,7 @@ void gd_init(void) {
     s8 *data; // 2c
 
     imin("gd_init");
-    i = (u32) (sMemBlockPoolSize - DOUBLE_SIZE_ON_64_BIT(0x3E800));
+    i = (u32) (sMemBlockPoolSize - GD_MEMBLOCK_POOL_SIZE);
     data = gd_allocblock(i);
     gd_add_mem_to_heap(i, data, 0x10);
     sAlpha = (u16) 0xff;
@@ -3175,6 +3216,12 @@ void gd_init(void) {
         sViewDls[i][0] = create_child_gdl(1, sDynamicMainDls[0]);
         sViewDls[i][1] = create_child_gdl(1, sDynamicMainDls[1]);
     }
+#ifdef GODDARD_HAND_DL_CACHE
+    sHandDlCache[0].valid = FALSE;
+    sHandDlCache[1].valid = FALSE;
+    gHandDlStats.dls = 0;
+    gHandDlStats.reused = 0;
+#endif
 
     sScreenView =
         make_view("screenview2", (VIEW_2_COL_BUF | VIEW_UNK_1000 | VIEW_COLOUR_BUF | VIEW_Z_BUF), 0, 0,
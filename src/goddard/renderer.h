@@ -4,8 +4,10 @@
 #include <PR/ultratypes.h>
 #include <PR/os_cont.h>
 
+#include "config.h"
 #include "gd_types.h"
 #include "macros.h"
+#include "platform_info.h"
 
 // types
 /// Properties types used in [gd_setproperty](@ref gd_setproperty); most are stubbed out.
@@ -33,8 +35,29 @@ enum GdSceneId {
     GD_SCENE_CAR5  // destroy car?
 };
 
+/// Memory that `gd_init()` keeps back from the heap for the `GMemBlock`s that track it.
+/// Slab allocated memory needs one per page instead of one per allocation.
+#ifdef GODDARD_SLAB_ALLOCATOR
+#define GD_MEMBLOCK_POOL_SIZE DOUBLE_SIZE_ON_64_BIT(0x4000)
+#else
+#define GD_MEMBLOCK_POOL_SIZE DOUBLE_SIZE_ON_64_BIT(0x3E800)
+#endif
+/// Size of the memory to give to `gdm_init()`: the heap, and the pool for its `GMemBlock`s
+#define GD_HEAP_SIZE (DOUBLE_SIZE_ON_64_BIT(0xA2800) + GD_MEMBLOCK_POOL_SIZE)
+
+#ifdef GODDARD_HAND_DL_CACHE
+/// Counts for the reuse of the hand's display lists since the last `gdm_setup()`
+struct GdHandDlStats {
+    u32 dls;    ///< hand display lists made, or reused
+    u32 reused; ///< hand display lists reused
+};
+#endif
+
 // data
 extern s32 gGdFrameBufNum;
+#ifdef GODDARD_HAND_DL_CACHE
+extern struct GdHandDlStats gHandDlStats;
+#endif
 
 // functions
 u32 get_alloc_mem_amt(void);
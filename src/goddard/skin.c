@@ -18,6 +18,39 @@ struct ObjNet *gGdSkinNet; // @ 801BAAF0
 static s32 D_801BAAF4;
 static s32 sNetCount; // @ 801BAAF8
 
+#ifdef GODDARD_PACKED_SKIN
+/**
+ * Packed copy of the vertices that a skin net (`netType` 2) moves each frame, and
+ * of the weights that the bone nets (`netType` 4) on the same shape add to them.
+ * Weights are grouped by joint, in the order that `move_nets()` would apply them.
+ */
+struct GdPackedSkin {
+    s32 vtxCount;
+    s32 jointCount;
+    s32 weightCount;
+    struct ObjVertex **verts;  ///< the shape's `scaledVtxGroup`
+    f32 *baseX, *baseY, *baseZ; ///< positions that `scale_verts()` resets `verts` to
+    f32 *posX, *posY, *posZ;    ///< deformed positions
+    s32 *vtxLinkStart;         ///< start of each vertex's `Vtx` in `gbiVerts`; `vtxCount` + 1 entries
+    Vtx **gbiVerts;            ///< every `Vtx` of every vertex, in `gbiVerts` list order
+    struct ObjJoint **joints;  ///< joints with weights
+    s32 *jointWeightStart;     ///< start of each joint's weights; `jointCount` + 1 entries
+    s16 *weightVtx;            ///< index in `verts` that each weight moves
+    f32 *weightX, *weightY, *weightZ; ///< `ObjWeight.vec20`
+    f32 *weightVal;
+};
+
+static struct ObjNet **sPackNets; // nets in the group being packed, in `move_nets()` order
+static s32 sPackNetCount;
+static struct GdPackedSkin *sPackSkin; // skin being filled in, or NULL when counting
+static struct ObjVertex **sPackVerts;  // vertices of the skin being packed
+static s16 *sPackVtxIndex; // index in `sPackVerts` of each vertex in the skin shape, or -1
+static s32 sPackVtxIndexCount;
+static s32 sPackJointCount;
+static s32 sPackWeightCount;
+static s32 sPackFailed;
+#endif
+
 /* 2406E0 -> 240894 */
 void compute_net_bounding_box(struct ObjNet *net) {
     reset_bounding_box();
@@ -379,8 +412,97 @@ void convert_gd_verts_to_Vtx(struct ObjGroup *grp) {
     }
 }
 
+#ifdef GODDARD_PACKED_SKIN
+/**
+ * Move the vertices of `skin` as `scale_verts()` and the joints' `func_80181894()`
+ * would, and write them to their `ObjVertex` and `Vtx` like `convert_gd_verts_to_Vtx()`.
+ * The arithmetic is done in the same order, so the results are the same.
+ */
+static void deform_packed_skin(struct GdPackedSkin *skin) {
+    register f32 *posX = skin->posX;
+    register f32 *posY = skin->posY;
+    register f32 *posZ = skin->posZ;
+    register Mat4f *mtx;
+    register f32 x, y, z;
+    register f32 outX, outY, outZ;
+    register f32 scaleFactor;
+    register s32 i;
+    register s32 k;
+    s32 j;
+    s32 end;
+    s16 sx, sy, sz;
+    Vtx *vtx;
+    f32 m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32;
+
+    for (i = 0; i < skin->vtxCount; i++) {
+        posX[i] = skin->baseX[i];
+        posY[i] = skin->baseY[i];
+        posZ[i] = skin->baseZ[i];
+    }
+
+    for (j = 0; j < skin->jointCount; j++) {
+        mtx = &skin->joints[j]->matE8;
+        m00 = (*mtx)[0][0];
+        m01 = (*mtx)[0][1];
+        m02 = (*mtx)[0][2];
+        m10 = (*mtx)[1][0];
+        m11 = (*mtx)[1][1];
+        m12 = (*mtx)[1][2];
+        m20 = (*mtx)[2][0];
+        m21 = (*mtx)[2][1];
+        m22 = (*mtx)[2][2];
+        m30 = (*mtx)[3][0];
+        m31 = (*mtx)[3][1];
+        m32 = (*mtx)[3][2];
+
+        end = skin->jointWeightStart[j + 1];
+        for (k = skin->jointWeightStart[j]; k < end; k++) {
+            x = skin->weightX[k];
+            y = skin->weightY[k];
+            z = skin->weightZ[k];
+            // same as gd_rotate_and_translate_vec3f()
+            outX = m00 * x + m10 * y + m20 * z;
+            outY = m01 * x + m11 * y + m21 * z;
+            outZ = m02 * x + m12 * y + m22 * z;
+            outX += m30;
+            outY += m31;
+            outZ += m32;
+
+            scaleFactor = skin->weightVal[k];
+            i = skin->weightVtx[k];
+            posX[i] += outX * scaleFactor;
+            posY[i] += outY * scaleFactor;
+            posZ[i] += outZ * scaleFactor;
+        }
+    }
+
+    for (i = 0; i < skin->vtxCount; i++) {
+        skin->verts[i]->pos.x = posX[i];
+        skin->verts[i]->pos.y = posY[i];
+        skin->verts[i]->pos.z = posZ[i];
+        sx = (s16) posX[i];
+        sy = (s16) posY[i];
+        sz = (s16) posZ[i];
+
+        end = skin->vtxLinkStart[i + 1];
+        for (k = skin->vtxLinkStart[i]; k < end; k++) {
+            vtx = skin->gbiVerts[k];
+            vtx->v.ob[0] = sx;
+            vtx->v.ob[1] = sy;
+            vtx->v.ob[2] = sz;
+        }
+    }
+}
+#endif
+
 /* 241BCC -> 241CA0; orig name: Proc801933FC */
 void convert_net_verts(struct ObjNet *net) {
+#ifdef GODDARD_PACKED_SKIN
+    // The vertices have to be moved before their normals are converted
+    if (net->netType == 2 && net->packedSkin != NULL) {
+        deform_packed_skin(net->packedSkin);
+    }
+#endif
     if (net->shapePtr != NULL) {
         if (net->shapePtr->unk30) {
             convert_gd_verts_to_Vn(net->shapePtr->vtxGroup);
@@ -389,6 +511,11 @@ void convert_net_verts(struct ObjNet *net) {
 
     switch (net->netType) {
         case 2:
+#ifdef GODDARD_PACKED_SKIN
+            if (net->packedSkin != NULL) {
+                break;
+            }
+#endif
             if (net->shapePtr != NULL) {
                 convert_gd_verts_to_Vtx(net->shapePtr->scaledVtxGroup);
             }
@@ -429,11 +556,25 @@ void move_net(struct ObjNet *net) {
             break;
         case 4:
             restart_timer("move_bones");
+#ifdef GODDARD_PACKED_SKIN
+            // The weights are applied by convert_net_verts() on the skin net instead
+            if (net->packedSkin != NULL) {
+                gd_set_identity_mat4(&D_801B9DC8);
+                split_timer("move_bones");
+                break;
+            }
+#endif
             move_bonesnet(net);
             split_timer("move_bones");
             break;
         case 2:
             restart_timer("move_skin");
+#ifdef GODDARD_PACKED_SKIN
+            if (net->packedSkin != NULL) {
+                split_timer("move_skin");
+                break;
+            }
+#endif
             move_skin(net);
             split_timer("move_skin");
             break;
@@ -480,12 +621,286 @@ void func_8019373C(struct ObjNet *net) {
     }
 }
 
+#ifdef GODDARD_PACKED_SKIN
+/**
+ * Add `net` to `sPackNets`, or only count it if `sPackNets` hasn't been allocated.
+ */
+static void add_net_to_pack_list(struct ObjNet *net) {
+    if (sPackNets != NULL) {
+        sPackNets[sPackNetCount] = net;
+    }
+    sPackNetCount++;
+}
+
+/**
+ * Count the weights of `joint` that move vertices, checking that they move vertices
+ * of the skin being packed, or add them to `sPackSkin` once it has been allocated.
+ */
+static void add_joint_to_packed_skin(struct ObjJoint *joint) {
+    register struct ListNode *link;
+    struct ObjWeight *weight;
+    s32 vtxIndex;
+    s32 weightCount = 0;
+
+    if (joint->weightGrp == NULL) {
+        return;
+    }
+
+    for (link = joint->weightGrp->firstMember; link != NULL; link = link->next) {
+        weight = (struct ObjWeight *) link->obj;
+        // `func_80181894()` skips these every frame
+        if (!(weight->weightVal > 0.0)) {
+            continue;
+        }
+
+        vtxIndex = -1;
+        if (weight->vtxId >= 0 && weight->vtxId < sPackVtxIndexCount) {
+            vtxIndex = sPackVtxIndex[weight->vtxId];
+        }
+        if (vtxIndex < 0 || sPackVerts[vtxIndex] != weight->vtx) {
+            sPackFailed = TRUE;
+            return;
+        }
+
+        if (sPackSkin != NULL) {
+            sPackSkin->weightVtx[sPackWeightCount] = vtxIndex;
+            sPackSkin->weightX[sPackWeightCount] = weight->vec20.x;
+            sPackSkin->weightY[sPackWeightCount] = weight->vec20.y;
+            sPackSkin->weightZ[sPackWeightCount] = weight->vec20.z;
+            sPackSkin->weightVal[sPackWeightCount] = weight->weightVal;
+        }
+        sPackWeightCount++;
+        weightCount++;
+    }
+
+    if (weightCount != 0) {
+        if (sPackSkin != NULL) {
+            sPackSkin->joints[sPackJointCount] = joint;
+            sPackSkin->jointWeightStart[sPackJointCount + 1] = sPackWeightCount;
+        }
+        sPackJointCount++;
+    }
+}
+
+/**
+ * Add the joints of every bone net in `sPackNets` after `skinNet` that skins the same
+ * shape to `sPackSkin`, or count them if `sPackSkin` is NULL.
+ */
+static void add_bone_nets_to_packed_skin(s32 skinNet) {
+    struct ObjNet *net;
+    s32 i;
+
+    sPackJointCount = 0;
+    sPackWeightCount = 0;
+    for (i = skinNet + 1; i < sPackNetCount && !sPackFailed; i++) {
+        net = sPackNets[i];
+        if (net->netType == 4 && net->skinGrp == sPackNets[skinNet]->shapePtr->vtxGroup) {
+            apply_to_obj_types_in_group(OBJ_TYPE_JOINTS, (applyproc_t) add_joint_to_packed_skin,
+                                        net->unk1C8);
+        }
+    }
+}
+
+/**
+ * Make a `GdPackedSkin` for the skin net at `skinNet` in `sPackNets`, if it and the bone
+ * nets on its shape can be moved by `deform_packed_skin()` with the same results.
+ */
+static void pack_skin_net(s32 skinNet) {
+    struct ObjNet *net = sPackNets[skinNet];
+    struct ObjGroup *vtxGroup = net->shapePtr->vtxGroup;
+    struct GdPackedSkin *skin;
+    register struct ListNode *link;
+    register struct ListNode *scaledLink;
+    struct VtxLink *vtxlink;
+    struct ObjVertex *vtx;
+    f32 scaleFactor;
+    s32 vtxCount;
+    s32 linkCount;
+    u32 size;
+    u8 *mem;
+    s32 i;
+
+    // Another net that resets these vertices, or a bone net that moves them before
+    // this net resets them, would have to be applied in between
+    for (i = 0; i < sPackNetCount; i++) {
+        if (i != skinNet && sPackNets[i]->netType == 2 && sPackNets[i]->shapePtr != NULL
+            && sPackNets[i]->shapePtr->vtxGroup == vtxGroup) {
+            return;
+        }
+        if (i < skinNet && sPackNets[i]->netType == 4 && sPackNets[i]->skinGrp == vtxGroup) {
+            return;
+        }
+    }
+
+    // Weights find their vertex by its index among the vertices in `vtxGroup`, and
+    // `scaledVtxGroup` is the vertices of `vtxGroup` that weights move, in order
+    if (vtxGroup->linkType & 1) {
+        return;
+    }
+    vtxCount = 0;
+    linkCount = 0;
+    sPackVtxIndexCount = 0;
+    for (link = vtxGroup->firstMember; link != NULL; link = link->next) {
+        if (link->obj->type != OBJ_TYPE_VERTICES) {
+            return;
+        }
+        sPackVtxIndexCount++;
+    }
+    for (link = net->shapePtr->scaledVtxGroup->firstMember; link != NULL; link = link->next) {
+        for (vtxlink = ((struct ObjVertex *) link->obj)->gbiVerts; vtxlink != NULL; vtxlink = vtxlink->prev) {
+            linkCount++;
+        }
+        vtxCount++;
+    }
+    if (vtxCount == 0 || sPackVtxIndexCount > 0x7FFF) {
+        return;
+    }
+
+    sPackVtxIndex = gd_malloc_temp(sPackVtxIndexCount * sizeof(s16));
+    sPackVerts = gd_malloc_temp(vtxCount * sizeof(struct ObjVertex *));
+    if (sPackVtxIndex == NULL || sPackVerts == NULL) {
+        fatal_printf("pack_skin_net(): Cant allocate memory");
+    }
+
+    scaledLink = net->shapePtr->scaledVtxGroup->firstMember;
+    vtxCount = 0;
+    i = 0;
+    for (link = vtxGroup->firstMember; link != NULL; link = link->next) {
+        if (scaledLink != NULL && link->obj == scaledLink->obj) {
+            sPackVerts[vtxCount] = (struct ObjVertex *) link->obj;
+            sPackVtxIndex[i++] = vtxCount++;
+            scaledLink = scaledLink->next;
+        } else {
+            sPackVtxIndex[i++] = -1;
+        }
+    }
+    sPackFailed = scaledLink != NULL;
+
+    sPackSkin = NULL;
+    add_bone_nets_to_packed_skin(skinNet);
+    if (sPackFailed) {
+        gd_free(sPackVerts);
+        gd_free(sPackVtxIndex);
+        return;
+    }
+
+    // Pointers first, then 32-bit values, then 16-bit ones, to keep them aligned
+    size = sizeof(struct GdPackedSkin) + (vtxCount + linkCount + sPackJointCount) * sizeof(void *)
+           + (vtxCount * 7 + 1 + sPackJointCount + 1 + sPackWeightCount * 4) * sizeof(f32)
+           + sPackWeightCount * sizeof(s16);
+    skin = gd_malloc_perm(size);
+    if (skin == NULL) {
+        fatal_printf("pack_skin_net(): Cant allocate skin memory");
+    }
+
+    mem = (u8 *) (skin + 1);
+    skin->vtxCount = vtxCount;
+    skin->jointCount = sPackJointCount;
+    skin->weightCount = sPackWeightCount;
+    skin->verts = (struct ObjVertex **) mem;
+    mem += vtxCount * sizeof(struct ObjVertex *);
+    skin->gbiVerts = (Vtx **) mem;
+    mem += linkCount * sizeof(Vtx *);
+    skin->joints = (struct ObjJoint **) mem;
+    mem += sPackJointCount * sizeof(struct ObjJoint *);
+    skin->baseX = (f32 *) mem;
+    skin->baseY = skin->baseX + vtxCount;
+    skin->baseZ = skin->baseY + vtxCount;
+    skin->posX = skin->baseZ + vtxCount;
+    skin->posY = skin->posX + vtxCount;
+    skin->posZ = skin->posY + vtxCount;
+    skin->vtxLinkStart = (s32 *) (skin->posZ + vtxCount);
+    skin->jointWeightStart = skin->vtxLinkStart + vtxCount + 1;
+    skin->weightX = (f32 *) (skin->jointWeightStart + sPackJointCount + 1);
+    skin->weightY = skin->weightX + sPackWeightCount;
+    skin->weightZ = skin->weightY + sPackWeightCount;
+    skin->weightVal = skin->weightZ + sPackWeightCount;
+    skin->weightVtx = (s16 *) (skin->weightVal + sPackWeightCount);
+
+    linkCount = 0;
+    for (i = 0; i < vtxCount; i++) {
+        vtx = sPackVerts[i];
+        skin->verts[i] = vtx;
+        // same as scale_verts()
+        if ((scaleFactor = vtx->scaleFactor) != 0.0f) {
+            skin->baseX[i] = vtx->initPos.x * scaleFactor;
+            skin->baseY[i] = vtx->initPos.y * scaleFactor;
+            skin->baseZ[i] = vtx->initPos.z * scaleFactor;
+        } else {
+            skin->baseX[i] = skin->baseY[i] = skin->baseZ[i] = 0.0f;
+        }
+
+        skin->vtxLinkStart[i] = linkCount;
+        for (vtxlink = vtx->gbiVerts; vtxlink != NULL; vtxlink = vtxlink->prev) {
+            skin->gbiVerts[linkCount++] = vtxlink->data;
+        }
+    }
+    skin->vtxLinkStart[vtxCount] = linkCount;
+
+    sPackSkin = skin;
+    skin->jointWeightStart[0] = 0;
+    add_bone_nets_to_packed_skin(skinNet);
+    sPackSkin = NULL;
+
+    gd_free(sPackVerts);
+    gd_free(sPackVtxIndex);
+
+    net->packedSkin = skin;
+    for (i = skinNet + 1; i < sPackNetCount; i++) {
+        if (sPackNets[i]->netType == 4 && sPackNets[i]->skinGrp == vtxGroup) {
+            sPackNets[i]->packedSkin = skin;
+        }
+    }
+}
+
+/**
+ * Make a `GdPackedSkin` for each skin net in `group` that can use one.
+ */
+static void pack_skin_nets(struct ObjGroup *group) {
+    s32 i;
+
+    sPackNets = NULL;
+    sPackNetCount = 0;
+    apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) add_net_to_pack_list, group);
+    if (sPackNetCount == 0) {
+        return;
+    }
+    sPackNets = gd_malloc_temp(sPackNetCount * sizeof(struct ObjNet *));
+    if (sPackNets == NULL) {
+        fatal_printf("pack_skin_nets(): Cant allocate memory");
+    }
+    sPackNetCount = 0;
+    apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) add_net_to_pack_list, group);
+
+    // Free the skins of an earlier reset
+    for (i = 0; i < sPackNetCount; i++) {
+        if (sPackNets[i]->netType == 2 && sPackNets[i]->packedSkin != NULL) {
+            gd_free(sPackNets[i]->packedSkin);
+        }
+        sPackNets[i]->packedSkin = NULL;
+    }
+
+    for (i = 0; i < sPackNetCount; i++) {
+        if (sPackNets[i]->netType == 2 && sPackNets[i]->shapePtr != NULL
+            && sPackNets[i]->shapePtr->vtxGroup != NULL && sPackNets[i]->shapePtr->scaledVtxGroup != NULL) {
+            pack_skin_net(i);
+        }
+    }
+
+    gd_free(sPackNets);
+    sPackNets = NULL;
+}
+#endif
+
 /* 242018 -> 24208C */
 void func_80193848(struct ObjGroup *group) {
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) reset_net, group);
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) func_80192294, group);
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) func_801922FC, group);
     apply_to_obj_types_in_group(OBJ_TYPE_NETS, (applyproc_t) func_8019373C, group);
+#ifdef GODDARD_PACKED_SKIN
+    pack_skin_nets(group);
+#endif
 }
 
 /* 24208C -> 2422E0; not called; orig name: func_801938BC */
@@ -0,0 +1,232 @@
+/*
+ * audio_render: plays sequences with the game's sequence player and synthesis
+ * code in src/audio, and runs the audio command lists it makes with the host
+ * implementation of the microcode in rsp_audio.c. For each sequence it
+ * reports the seconds of audio rendered per CPU second, for the whole audio
+ * frame and for running the command lists alone, and a hash of the audio so
+ * that builds can be compared.
+ *
+ * Usage: audio_render [-t SECONDS] [-o DIR] [SEQUENCE...]
+ *
+ * Sequences are given by number and default to all of them except the sound
+ * effect player, sequence 0. Each one is played from a fresh audio_init()
+ * until it ends or SECONDS of audio (60 by default) have been rendered. With
+ * -o the audio is also written to DIR/NN.wav.
+ *
+ * audio_render uses the host's SSE2 or NEON instructions, and
+ * audio_render_scalar is the same program with rsp_audio.c built without them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "audio/data.h"
+#include "audio/external.h"
+#include "audio/load.h"
+#include "rsp_audio.h"
+#include "stubs.h"
+
+struct RenderResult {
+    s32 seqId;
+    s32 numFrames;
+    u32 numSamples;
+    u32 numCmds;
+    u32 hash;
+    double cpuSeconds;
+    double rspSeconds;
+};
+
+static double sMaxSeconds = 60.0;
+static const char *sOutputDir;
+
+static double cpu_time(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void write_u16_le(u8 *p, u32 v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void write_u32_le(u8 *p, u32 v) {
+    write_u16_le(p, v);
+    write_u16_le(p + 2, v >> 16);
+}
+
+static void write_wav_header(FILE *f, u32 numSamples, u32 frequency) {
+    u8 header[44];
+    u32 dataSize = numSamples * 4;
+
+    memcpy(header, "RIFF", 4);
+    write_u32_le(header + 4, 36 + dataSize);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    write_u32_le(header + 16, 16);
+    write_u16_le(header + 20, 1);
+    write_u16_le(header + 22, 2);
+    write_u32_le(header + 24, frequency);
+    write_u32_le(header + 28, frequency * 4);
+    write_u16_le(header + 32, 4);
+    write_u16_le(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    write_u32_le(header + 40, dataSize);
+    fseek(f, 0, SEEK_SET);
+    fwrite(header, sizeof(header), 1, f);
+}
+
+static void write_wav_samples(FILE *f, s16 *samples, u32 numSamples) {
+    u8 buf[4];
+    u32 i;
+
+    for (i = 0; i < numSamples; i++) {
+        write_u16_le(buf, samples[2 * i]);
+        write_u16_le(buf + 2, samples[2 * i + 1]);
+        fwrite(buf, sizeof(buf), 1, f);
+    }
+}
+
+// FNV-1a
+static u32 hash_bytes(u32 hash, const u8 *data, size_t size) {
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619;
+    }
+    return hash;
+}
+
+static void render_sequence(struct RenderResult *result, FILE *wav) {
+    struct SPTask *task;
+    s32 maxFrames = sMaxSeconds * FRAMES_PER_SECOND;
+    s32 length;
+    s32 numCmds;
+    double start;
+    double rspStart;
+
+    audio_init();
+    rsp_audio_init();
+    gAiSamplesQueued = 0;
+    load_sequence(SEQ_PLAYER_LEVEL, result->seqId, FALSE);
+    result->hash = 2166136261u;
+
+    start = cpu_time();
+    for (result->numFrames = 0; result->numFrames < maxFrames; result->numFrames++) {
+        if (result->numFrames != 0 && !level_sequence_playing()) {
+            break;
+        }
+
+        task = create_next_audio_frame_task();
+        if (task == NULL) {
+            continue;
+        }
+        numCmds = task->task.t.data_size / sizeof(u64);
+        rspStart = cpu_time();
+        rsp_audio_run(task->task.t.data_ptr, numCmds);
+        result->rspSeconds += cpu_time() - rspStart;
+        result->numCmds += numCmds;
+
+        length = gAiBufferLengths[gCurrAiBufferIndex];
+        result->numSamples += length;
+        result->hash = hash_bytes(result->hash, (u8 *) gAiBuffers[gCurrAiBufferIndex], length * 4);
+        if (wav != NULL) {
+            write_wav_samples(wav, gAiBuffers[gCurrAiBufferIndex], length);
+        }
+        ai_play_frame(result->numFrames);
+    }
+    result->cpuSeconds = cpu_time() - start;
+}
+
+static void print_result(const char *name, struct RenderResult *result) {
+    double seconds = (double) result->numSamples / gAiFrequency;
+
+    printf("%-5s %8.1f %8.3f %10.1f %8.3f %10.1f %9.1f  %08x\n", name, seconds,
+           result->cpuSeconds, seconds / result->cpuSeconds, result->rspSeconds,
+           seconds / result->rspSeconds, (double) result->numCmds / result->numFrames,
+           result->hash);
+}
+
+int main(int argc, char *argv[]) {
+    struct RenderResult *results;
+    struct RenderResult total;
+    s32 *seqIds;
+    s32 numSeqs = 0;
+    char path[1024];
+    char name[8];
+    FILE *wav = NULL;
+    s32 i;
+
+    seqIds = malloc(argc * sizeof(s32));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            sMaxSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            sOutputDir = argv[++i];
+        } else if (argv[i][0] != '-') {
+            seqIds[numSeqs++] = strtol(argv[i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [-t SECONDS] [-o DIR] [SEQUENCE...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    audio_init();
+    if (numSeqs == 0) {
+        seqIds = realloc(seqIds, gSequenceCount * sizeof(s32));
+        for (i = 1; i < gSequenceCount; i++) {
+            seqIds[numSeqs++] = i;
+        }
+    }
+    for (i = 0; i < numSeqs; i++) {
+        if (seqIds[i] < 0 || seqIds[i] >= gSequenceCount) {
+            fprintf(stderr, "There are only %d sequences\n", gSequenceCount);
+            return 1;
+        }
+    }
+
+    results = calloc(numSeqs, sizeof(struct RenderResult));
+    memset(&total, 0, sizeof(total));
+    total.hash = 2166136261u;
+    printf("%-5s %8s %8s %10s %8s %10s %9s  %-8s\n", "seq", "audio s", "cpu s", "audio/cpu",
+           "rsp s", "audio/rsp", "cmds/frm", "hash");
+    for (i = 0; i < numSeqs; i++) {
+        results[i].seqId = seqIds[i];
+        if (sOutputDir != NULL) {
+            snprintf(path, sizeof(path), "%s/%02X.wav", sOutputDir, seqIds[i]);
+            wav = fopen(path, "wb");
+            if (wav == NULL) {
+                perror(path);
+                return 1;
+            }
+            // Filled in once the length is known
+            write_wav_header(wav, 0, 0);
+        }
+
+        render_sequence(&results[i], wav);
+
+        if (wav != NULL) {
+            write_wav_header(wav, results[i].numSamples, gAiFrequency);
+            fclose(wav);
+        }
+        snprintf(name, sizeof(name), "%02X", seqIds[i]);
+        print_result(name, &results[i]);
+
+        total.numFrames += results[i].numFrames;
+        total.numSamples += results[i].numSamples;
+        total.numCmds += results[i].numCmds;
+        total.hash = hash_bytes(total.hash, (u8 *) &results[i].hash, sizeof(u32));
+        total.cpuSeconds += results[i].cpuSeconds;
+        total.rspSeconds += results[i].rspSeconds;
+    }
+    print_result("all", &total);
+
+    free(results);
+    free(seqIds);
+    return 0;
+}
@@ -0,0 +1,658 @@
+/*
+ * A host implementation of the audio microcode (rsp/audio.s), following the
+ * command descriptions in include/PR/abi.h. The commands work on a copy of
+ * DMEM like the microcode does, so synthesis.c's DMEM layout can be used
+ * unchanged. Samples in DMEM and DRAM are in host byte order.
+ *
+ * ADPCM decoding, resampling and mixing use SSE2 or NEON where available.
+ * The vector and scalar paths round and clamp the same way, so they give
+ * the same output bit for bit; build with RSP_AUDIO_NO_SIMD to get the
+ * scalar ones.
+ *
+ * Only the commands synthesis.c uses are implemented. A_POLEF, and A_OUT
+ * for A_RESAMPLE, are not used by the game and are ignored, and all
+ * addresses are taken to be in segment 0 (synthesis_execute starts each
+ * command list with aSegment(cmd, 0, 0)).
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <ultra64.h>
+
+#include "rsp_audio.h"
+
+#if defined(__SSE2__) && !defined(RSP_AUDIO_NO_SIMD)
+#include <emmintrin.h>
+#define RSP_AUDIO_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(RSP_AUDIO_NO_SIMD)
+#include <arm_neon.h>
+#define RSP_AUDIO_NEON
+#endif
+
+#define DMEM_SIZE 0x1000
+// Room on either side of DMEM, as resampling reads a few samples before its
+// input buffer and past the end of it
+#define DMEM_MARGIN 0x400
+
+#define DMEM_U8(addr) (sDmem.u8 + DMEM_MARGIN + (addr))
+#define DMEM_S16(addr) ((s16 *) DMEM_U8(addr))
+#define DRAM(addr) ((void *) (uintptr_t) (addr))
+
+#define ROUND_UP_8(v) (((v) + 7) & ~7)
+#define ROUND_UP_16(v) (((v) + 15) & ~15)
+#define ROUND_UP_32(v) (((v) + 31) & ~31)
+
+static union {
+    s16 s16[(DMEM_MARGIN + DMEM_SIZE + DMEM_MARGIN) / 2];
+    u8 u8[DMEM_MARGIN + DMEM_SIZE + DMEM_MARGIN];
+} sDmem __attribute__((aligned(16)));
+
+// Registers set by aSetBuffer, aSetVolume and aSetLoop
+static struct {
+    u16 in;
+    u16 out;
+    u16 count;
+    u16 dryRight;
+    u16 wetLeft;
+    u16 wetRight;
+    s16 vol[2];
+    s16 target[2];
+    s32 rate[2];
+    s16 volDry;
+    s16 volWet;
+    s16 *loopState;
+} sRsp;
+
+// ADPCM codebook loaded by aLoadADPCM: up to 16 predictors of order 2
+static s16 sAdpcmBook[16][2][8];
+
+/*
+ * Each predictor as a matrix from the two previous samples and eight scaled
+ * residuals to the eight decoded samples, so that a group of eight can be
+ * decoded with a few multiply-adds. For SSE2 the rows are interleaved in
+ * pairs for _mm_madd_epi16: sAdpcmMatrix[p][2 * q + h] holds rows 2 * q and
+ * 2 * q + 1 for output samples 4 * h to 4 * h + 3.
+ */
+#ifdef RSP_AUDIO_SSE2
+static __m128i sAdpcmMatrix[16][10];
+#else
+static s16 sAdpcmMatrix[16][10][8];
+#endif
+
+// Filter taps for resampling by fractional position, from the microcode's data
+static const u16 sResampleTable[64][4] __attribute__((aligned(16))) = {
+    { 0x0c39, 0x66ad, 0x0d46, 0xffdf }, { 0x0b39, 0x6696, 0x0e5f, 0xffd8 },
+    { 0x0a44, 0x6669, 0x0f83, 0xffd0 }, { 0x095a, 0x6626, 0x10b4, 0xffc8 },
+    { 0x087d, 0x65cd, 0x11f0, 0xffbf }, { 0x07ab, 0x655e, 0x1338, 0xffb6 },
+    { 0x06e4, 0x64d9, 0x148c, 0xffac }, { 0x0628, 0x643f, 0x15eb, 0xffa1 },
+    { 0x0577, 0x638f, 0x1756, 0xff96 }, { 0x04d1, 0x62cb, 0x18cb, 0xff8a },
+    { 0x0435, 0x61f3, 0x1a4c, 0xff7e }, { 0x03a4, 0x6106, 0x1bd7, 0xff71 },
+    { 0x031c, 0x6007, 0x1d6c, 0xff64 }, { 0x029f, 0x5ef5, 0x1f0b, 0xff56 },
+    { 0x022a, 0x5dd0, 0x20b3, 0xff48 }, { 0x01be, 0x5c9a, 0x2264, 0xff3a },
+    { 0x015b, 0x5b53, 0x241e, 0xff2c }, { 0x0101, 0x59fc, 0x25e0, 0xff1e },
+    { 0x00ae, 0x5896, 0x27a9, 0xff10 }, { 0x0063, 0x5720, 0x297a, 0xff02 },
+    { 0x001f, 0x559d, 0x2b50, 0xfef4 }, { 0xffe2, 0x540d, 0x2d2c, 0xfee8 },
+    { 0xffac, 0x5270, 0x2f0d, 0xfedb }, { 0xff7c, 0x50c7, 0x30f3, 0xfed0 },
+    { 0xff53, 0x4f14, 0x32dc, 0xfec6 }, { 0xff2e, 0x4d57, 0x34c8, 0xfebd },
+    { 0xff0f, 0x4b91, 0x36b6, 0xfeb6 }, { 0xfef5, 0x49c2, 0x38a5, 0xfeb0 },
+    { 0xfedf, 0x47ed, 0x3a95, 0xfeac }, { 0xfece, 0x4611, 0x3c85, 0xfeab },
+    { 0xfec0, 0x4430, 0x3e74, 0xfeac }, { 0xfeb6, 0x424a, 0x4060, 0xfeaf },
+    { 0xfeaf, 0x4060, 0x424a, 0xfeb6 }, { 0xfeac, 0x3e74, 0x4430, 0xfec0 },
+    { 0xfeab, 0x3c85, 0x4611, 0xfece }, { 0xfeac, 0x3a95, 0x47ed, 0xfedf },
+    { 0xfeb0, 0x38a5, 0x49c2, 0xfef5 }, { 0xfeb6, 0x36b6, 0x4b91, 0xff0f },
+    { 0xfebd, 0x34c8, 0x4d57, 0xff2e }, { 0xfec6, 0x32dc, 0x4f14, 0xff53 },
+    { 0xfed0, 0x30f3, 0x50c7, 0xff7c }, { 0xfedb, 0x2f0d, 0x5270, 0xffac },
+    { 0xfee8, 0x2d2c, 0x540d, 0xffe2 }, { 0xfef4, 0x2b50, 0x559d, 0x001f },
+    { 0xff02, 0x297a, 0x5720, 0x0063 }, { 0xff10, 0x27a9, 0x5896, 0x00ae },
+    { 0xff1e, 0x25e0, 0x59fc, 0x0101 }, { 0xff2c, 0x241e, 0x5b53, 0x015b },
+    { 0xff3a, 0x2264, 0x5c9a, 0x01be }, { 0xff48, 0x20b3, 0x5dd0, 0x022a },
+    { 0xff56, 0x1f0b, 0x5ef5, 0x029f }, { 0xff64, 0x1d6c, 0x6007, 0x031c },
+    { 0xff71, 0x1bd7, 0x6106, 0x03a4 }, { 0xff7e, 0x1a4c, 0x61f3, 0x0435 },
+    { 0xff8a, 0x18cb, 0x62cb, 0x04d1 }, { 0xff96, 0x1756, 0x638f, 0x0577 },
+    { 0xffa1, 0x15eb, 0x643f, 0x0628 }, { 0xffac, 0x148c, 0x64d9, 0x06e4 },
+    { 0xffb6, 0x1338, 0x655e, 0x07ab }, { 0xffbf, 0x11f0, 0x65cd, 0x087d },
+    { 0xffc8, 0x10b4, 0x6626, 0x095a }, { 0xffd0, 0x0f83, 0x6669, 0x0a44 },
+    { 0xffd8, 0x0e5f, 0x6696, 0x0b39 }, { 0xffdf, 0x0d46, 0x66ad, 0x0c39 },
+};
+
+static s16 clamp16(s32 v) {
+    if (v < -0x8000) {
+        return -0x8000;
+    }
+    if (v > 0x7fff) {
+        return 0x7fff;
+    }
+    return v;
+}
+
+static s32 clamp32(s64 v) {
+    if (v < -0x7fffffffLL - 1) {
+        return -0x7fffffff - 1;
+    }
+    if (v > 0x7fffffffLL) {
+        return 0x7fffffff;
+    }
+    return v;
+}
+
+static void adpcm_build_matrices(s32 numPredictors) {
+    s16 m[10][8];
+    s32 p, j, k;
+
+    for (p = 0; p < numPredictors; p++) {
+        for (j = 0; j < 8; j++) {
+            m[0][j] = sAdpcmBook[p][0][j];
+            m[1][j] = sAdpcmBook[p][1][j];
+            for (k = 0; k < 8; k++) {
+                if (k == j) {
+                    m[2 + k][j] = 1 << 11;
+                } else if (k < j) {
+                    m[2 + k][j] = sAdpcmBook[p][1][j - k - 1];
+                } else {
+                    m[2 + k][j] = 0;
+                }
+            }
+        }
+#ifdef RSP_AUDIO_SSE2
+        for (k = 0; k < 5; k++) {
+            for (j = 0; j < 2; j++) {
+                sAdpcmMatrix[p][2 * k + j] = _mm_setr_epi16(
+                    m[2 * k][4 * j + 0], m[2 * k + 1][4 * j + 0], m[2 * k][4 * j + 1],
+                    m[2 * k + 1][4 * j + 1], m[2 * k][4 * j + 2], m[2 * k + 1][4 * j + 2],
+                    m[2 * k][4 * j + 3], m[2 * k + 1][4 * j + 3]);
+            }
+        }
+#else
+        memcpy(sAdpcmMatrix[p], m, sizeof(m));
+#endif
+    }
+}
+
+/*
+ * Decode eight samples to out from the residuals in x[2..9], with the two
+ * previous samples in x[0] and x[1]. Sums that overflow wrap around the
+ * same way in every path.
+ */
+static void adpcm_predict_8(s16 *out, const s16 *x, s32 pred) {
+#if defined(RSP_AUDIO_SSE2)
+    __m128i *m = sAdpcmMatrix[pred];
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    __m128i pair;
+    s32 xy;
+    s32 q;
+
+    for (q = 0; q < 5; q++) {
+        memcpy(&xy, &x[2 * q], sizeof(xy));
+        pair = _mm_set1_epi32(xy);
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(pair, m[2 * q]));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(pair, m[2 * q + 1]));
+    }
+    lo = _mm_srai_epi32(lo, 11);
+    hi = _mm_srai_epi32(hi, 11);
+    _mm_storeu_si128((__m128i *) out, _mm_packs_epi32(lo, hi));
+#elif defined(RSP_AUDIO_NEON)
+    s16(*m)[8] = sAdpcmMatrix[pred];
+    int32x4_t lo = vmull_n_s16(vld1_s16(&m[0][0]), x[0]);
+    int32x4_t hi = vmull_n_s16(vld1_s16(&m[0][4]), x[0]);
+    s32 r;
+
+    for (r = 1; r < 10; r++) {
+        lo = vmlal_n_s16(lo, vld1_s16(&m[r][0]), x[r]);
+        hi = vmlal_n_s16(hi, vld1_s16(&m[r][4]), x[r]);
+    }
+    vst1q_s16(out, vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 11)), vqmovn_s32(vshrq_n_s32(hi, 11))));
+#else
+    s16(*m)[8] = sAdpcmMatrix[pred];
+    u32 acc;
+    s32 j, r;
+
+    for (j = 0; j < 8; j++) {
+        acc = 0;
+        for (r = 0; r < 10; r++) {
+            acc += (u32) (m[r][j] * x[r]);
+        }
+        out[j] = clamp16((s32) acc >> 11);
+    }
+#endif
+}
+
+static void cmd_adpcm(u32 flags, s16 *state) {
+    u8 *in = DMEM_U8(sRsp.in);
+    s16 *out = DMEM_S16(sRsp.out);
+    s32 count = ROUND_UP_32(sRsp.count);
+    s16 x[10];
+    s32 scale, pred;
+    s32 half, j;
+
+    if (flags & A_INIT) {
+        memset(out, 0, 16 * sizeof(s16));
+    } else if (flags & A_LOOP) {
+        memcpy(out, sRsp.loopState, 16 * sizeof(s16));
+    } else {
+        memcpy(out, state, 16 * sizeof(s16));
+    }
+    out += 16;
+
+    // Each frame of 16 samples is a header byte and 16 4-bit residuals
+    while (count > 0) {
+        scale = 1 << (*in >> 4);
+        pred = *in & 0xf;
+        in++;
+        for (half = 0; half < 2; half++) {
+            x[0] = out[-2];
+            x[1] = out[-1];
+            for (j = 0; j < 4; j++) {
+                x[2 + 2 * j] = (((s32) ((u32) in[j] << 24) >> 28) * scale);
+                x[3 + 2 * j] = (((s32) ((u32) in[j] << 28) >> 28) * scale);
+            }
+            in += 4;
+            adpcm_predict_8(out, x, pred);
+            out += 8;
+        }
+        count -= 16 * sizeof(s16);
+    }
+    memcpy(state, out - 16, 16 * sizeof(s16));
+}
+
+/*
+ * Eight output samples from four taps each, at the input positions and
+ * filter rows given. Each tap's product is rounded on its own.
+ */
+static void resample_8(s16 *out, const s16 *in, const s32 *pos, const s32 *row) {
+#if defined(RSP_AUDIO_SSE2)
+    __m128i round = _mm_set1_epi32(0x4000);
+    __m128i sums[2];
+    __m128i p[4];
+    __m128i taps, coefs, lo, hi;
+    s32 i, j;
+
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 4; j += 2) {
+            taps = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i *) &in[pos[4 * i + j]]),
+                                      _mm_loadl_epi64((__m128i *) &in[pos[4 * i + j + 1]]));
+            coefs = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i *) sResampleTable[row[4 * i + j]]),
+                                       _mm_loadl_epi64((__m128i *) sResampleTable[row[4 * i + j + 1]]));
+            lo = _mm_mullo_epi16(taps, coefs);
+            hi = _mm_mulhi_epi16(taps, coefs);
+            p[j] = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 15);
+            p[j + 1] = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 15);
+        }
+        // Sum the four taps of each of the four outputs
+        lo = _mm_add_epi32(_mm_unpacklo_epi32(p[0], p[1]), _mm_unpackhi_epi32(p[0], p[1]));
+        hi = _mm_add_epi32(_mm_unpacklo_epi32(p[2], p[3]), _mm_unpackhi_epi32(p[2], p[3]));
+        sums[i] = _mm_add_epi32(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+    }
+    _mm_storeu_si128((__m128i *) out, _mm_packs_epi32(sums[0], sums[1]));
+#elif defined(RSP_AUDIO_NEON)
+    int32x4_t p[8];
+    int32x4_t sums[2];
+    s32 i;
+
+    for (i = 0; i < 8; i++) {
+        p[i] = vrshrq_n_s32(
+            vmull_s16(vld1_s16(&in[pos[i]]), vreinterpret_s16_u16(vld1_u16(sResampleTable[row[i]]))),
+            15);
+    }
+    for (i = 0; i < 2; i++) {
+        sums[i] = vpaddq_s32(vpaddq_s32(p[4 * i], p[4 * i + 1]), vpaddq_s32(p[4 * i + 2], p[4 * i + 3]));
+    }
+    vst1q_s16(out, vcombine_s16(vqmovn_s32(sums[0]), vqmovn_s32(sums[1])));
+#else
+    const s16 *taps;
+    const u16 *coefs;
+    s32 sample;
+    s32 i, j;
+
+    for (i = 0; i < 8; i++) {
+        taps = &in[pos[i]];
+        coefs = sResampleTable[row[i]];
+        sample = 0;
+        for (j = 0; j < 4; j++) {
+            sample += (taps[j] * (s16) coefs[j] + 0x4000) >> 15;
+        }
+        out[i] = clamp16(sample);
+    }
+#endif
+}
+
+static void cmd_resample(u32 flags, u16 pitch, s16 *state) {
+    s16 *in = DMEM_S16(sRsp.in);
+    s16 *out = DMEM_S16(sRsp.out);
+    s32 count = ROUND_UP_16(sRsp.count);
+    u32 pitchAcc;
+    s32 inPos = 0;
+    s32 pos[8];
+    s32 row[8];
+    s32 i;
+
+    // The four samples before the input, and the fractional position
+    in -= 4;
+    if (flags & A_INIT) {
+        memset(in, 0, 4 * sizeof(s16));
+        pitchAcc = 0;
+    } else {
+        memcpy(in, state, 4 * sizeof(s16));
+        pitchAcc = (u16) state[4];
+    }
+
+    while (count > 0) {
+        for (i = 0; i < 8; i++) {
+            pos[i] = inPos;
+            row[i] = pitchAcc >> 10;
+            pitchAcc += pitch << 1;
+            inPos += pitchAcc >> 16;
+            pitchAcc &= 0xffff;
+        }
+        resample_8(out, in, pos, row);
+        out += 8;
+        count -= 8 * sizeof(s16);
+    }
+
+    memcpy(state, &in[inPos], 4 * sizeof(s16));
+    state[4] = pitchAcc;
+}
+
+/*
+ * dst = clamp(dst * 0x7fff + in * gain) with the product rounded to 16 bits,
+ * for eight samples. Every gain has to fit in an s16.
+ */
+static void mix_8(s16 *dst, const s16 *in, const s32 *gains) {
+#if defined(RSP_AUDIO_SSE2)
+    __m128i d = _mm_loadu_si128((__m128i *) dst);
+    __m128i s = _mm_loadu_si128((__m128i *) in);
+    __m128i g = _mm_packs_epi32(_mm_loadu_si128((__m128i *) gains), _mm_loadu_si128((__m128i *) &gains[4]));
+    __m128i k = _mm_set1_epi16(0x7fff);
+    __m128i round = _mm_set1_epi32(0x4000);
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(d, s), _mm_unpacklo_epi16(k, g));
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(d, s), _mm_unpackhi_epi16(k, g));
+
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 15);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 15);
+    _mm_storeu_si128((__m128i *) dst, _mm_packs_epi32(lo, hi));
+#elif defined(RSP_AUDIO_NEON)
+    int16x8_t d = vld1q_s16(dst);
+    int16x8_t s = vld1q_s16(in);
+    int16x8_t g = vcombine_s16(vmovn_s32(vld1q_s32(gains)), vmovn_s32(vld1q_s32(&gains[4])));
+    int32x4_t lo = vmull_n_s16(vget_low_s16(d), 0x7fff);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(d), 0x7fff);
+
+    lo = vmlal_s16(lo, vget_low_s16(s), vget_low_s16(g));
+    hi = vmlal_s16(hi, vget_high_s16(s), vget_high_s16(g));
+    lo = vshrq_n_s32(vaddq_s32(lo, vdupq_n_s32(0x4000)), 15);
+    hi = vshrq_n_s32(vaddq_s32(hi, vdupq_n_s32(0x4000)), 15);
+    vst1q_s16(dst, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+#else
+    s32 i;
+
+    for (i = 0; i < 8; i++) {
+        dst[i] = clamp16((dst[i] * 0x7fff + in[i] * gains[i] + 0x4000) >> 15);
+    }
+#endif
+}
+
+// mix_8 for gains that may be 0x8000, which only the scalar code can handle
+static void mix_8_wide(s16 *dst, const s16 *in, const s32 *gains) {
+    s32 i;
+
+    for (i = 0; i < 8; i++) {
+        dst[i] = clamp16((dst[i] * 0x7fff + in[i] * gains[i] + 0x4000) >> 15);
+    }
+}
+
+/*
+ * Mix the input into the dry left and right channels, and with A_AUX the wet
+ * ones too, ramping each channel's volume towards its target. Each of the
+ * eight samples in a group has its own volume, and every group multiplies
+ * it by the rate.
+ */
+static void cmd_envmixer(u32 flags, s16 *state) {
+    s16 *in = DMEM_S16(sRsp.in);
+    s16 *dry[2];
+    s16 *wet[2];
+    s32 count = ROUND_UP_16(sRsp.count);
+    s32 vols[2][8];
+    s32 dryGains[8];
+    s32 wetGains[8];
+    s16 target[2];
+    s32 rate[2];
+    s16 volDry;
+    s16 volWet;
+    s32 step;
+    s32 wide;
+    s32 c, i;
+
+    dry[0] = DMEM_S16(sRsp.out);
+    dry[1] = DMEM_S16(sRsp.dryRight);
+    wet[0] = DMEM_S16(sRsp.wetLeft);
+    wet[1] = DMEM_S16(sRsp.wetRight);
+
+    if (flags & A_INIT) {
+        for (c = 0; c < 2; c++) {
+            target[c] = sRsp.target[c];
+            rate[c] = sRsp.rate[c];
+            step = (s64) sRsp.vol[c] * (rate[c] - 0x10000) / 8;
+            for (i = 0; i < 8; i++) {
+                vols[c][i] = clamp32((s64) sRsp.vol[c] * 0x10000 + (s64) step * (i + 1));
+            }
+        }
+        volDry = sRsp.volDry;
+        volWet = sRsp.volWet;
+    } else {
+        memcpy(vols, state, sizeof(vols));
+        target[0] = state[32];
+        rate[0] = (s32) ((u32) (u16) state[33] << 16 | (u16) state[34]);
+        target[1] = state[35];
+        rate[1] = (s32) ((u32) (u16) state[36] << 16 | (u16) state[37]);
+        volDry = state[38];
+        volWet = state[39];
+    }
+
+    do {
+        for (c = 0; c < 2; c++) {
+            wide = FALSE;
+            for (i = 0; i < 8; i++) {
+                if ((rate[c] >> 16) > 0) {
+                    // Increasing volume
+                    if ((vols[c][i] >> 16) > target[c]) {
+                        vols[c][i] = target[c] * 0x10000;
+                    }
+                } else {
+                    // Decreasing volume
+                    if ((vols[c][i] >> 16) < target[c]) {
+                        vols[c][i] = target[c] * 0x10000;
+                    }
+                }
+                dryGains[i] = ((vols[c][i] >> 16) * volDry + 0x4000) >> 15;
+                wetGains[i] = ((vols[c][i] >> 16) * volWet + 0x4000) >> 15;
+                if (dryGains[i] > 0x7fff || wetGains[i] > 0x7fff) {
+                    wide = TRUE;
+                }
+                vols[c][i] = clamp32((s64) vols[c][i] * rate[c] >> 16);
+            }
+
+            if (wide) {
+                mix_8_wide(dry[c], in, dryGains);
+            } else {
+                mix_8(dry[c], in, dryGains);
+            }
+            dry[c] += 8;
+            if (flags & A_AUX) {
+                if (wide) {
+                    mix_8_wide(wet[c], in, wetGains);
+                } else {
+                    mix_8(wet[c], in, wetGains);
+                }
+                wet[c] += 8;
+            }
+        }
+        in += 8;
+        count -= 8 * sizeof(s16);
+    } while (count > 0);
+
+    memcpy(state, vols, sizeof(vols));
+    state[32] = target[0];
+    state[33] = rate[0] >> 16;
+    state[34] = rate[0];
+    state[35] = target[1];
+    state[36] = rate[1] >> 16;
+    state[37] = rate[1];
+    state[38] = volDry;
+    state[39] = volWet;
+}
+
+static void cmd_mixer(s16 gain, u16 inAddr, u16 outAddr) {
+    s16 *in = DMEM_S16(inAddr);
+    s16 *out = DMEM_S16(outAddr);
+    s32 count = ROUND_UP_32(sRsp.count);
+    s32 gains[8];
+    s32 i;
+
+    for (i = 0; i < 8; i++) {
+        gains[i] = gain;
+    }
+    while (count > 0) {
+        mix_8(out, in, gains);
+        in += 8;
+        out += 8;
+        count -= 8 * sizeof(s16);
+    }
+}
+
+static void cmd_interleave(u16 leftAddr, u16 rightAddr) {
+    s16 *left = DMEM_S16(leftAddr);
+    s16 *right = DMEM_S16(rightAddr);
+    s16 *out = DMEM_S16(sRsp.out);
+    s32 count = ROUND_UP_16(sRsp.count) / sizeof(s16);
+
+    // Groups of eight, as out overlaps the left channel's buffer
+    for (; count > 0; count -= 8) {
+#if defined(RSP_AUDIO_SSE2)
+        __m128i l = _mm_loadu_si128((__m128i *) left);
+        __m128i r = _mm_loadu_si128((__m128i *) right);
+
+        _mm_storeu_si128((__m128i *) out, _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128((__m128i *) &out[8], _mm_unpackhi_epi16(l, r));
+#elif defined(RSP_AUDIO_NEON)
+        int16x8x2_t lr;
+
+        lr.val[0] = vld1q_s16(left);
+        lr.val[1] = vld1q_s16(right);
+        vst2q_s16(out, lr);
+#else
+        s16 l[8];
+        s16 r[8];
+        s32 i;
+
+        memcpy(l, left, sizeof(l));
+        memcpy(r, right, sizeof(r));
+        for (i = 0; i < 8; i++) {
+            out[2 * i] = l[i];
+            out[2 * i + 1] = r[i];
+        }
+#endif
+        left += 8;
+        right += 8;
+        out += 16;
+    }
+}
+
+static void cmd_setvol(u32 flags, s16 v, u32 w1) {
+    if (flags & A_AUX) {
+        sRsp.volDry = v;
+        sRsp.volWet = w1;
+    } else if (flags & A_VOL) {
+        sRsp.vol[(flags & A_LEFT) ? 0 : 1] = v;
+    } else {
+        sRsp.target[(flags & A_LEFT) ? 0 : 1] = v;
+        sRsp.rate[(flags & A_LEFT) ? 0 : 1] = w1;
+    }
+}
+
+void rsp_audio_init(void) {
+    memset(&sDmem, 0, sizeof(sDmem));
+    memset(&sRsp, 0, sizeof(sRsp));
+    memset(sAdpcmBook, 0, sizeof(sAdpcmBook));
+    adpcm_build_matrices(16);
+}
+
+void rsp_audio_run(u64 *cmds, s32 numCmds) {
+    Acmd *cmd = (Acmd *) cmds;
+    u32 w0;
+    u32 w1;
+    u32 size;
+
+    for (; numCmds > 0; numCmds--, cmd++) {
+        w0 = cmd->words.w0;
+        w1 = cmd->words.w1;
+        switch (w0 >> 24) {
+            case A_ADPCM:
+                cmd_adpcm((w0 >> 16) & 0xff, DRAM(w1));
+                break;
+
+            case A_CLEARBUFF:
+                memset(DMEM_U8(w0 & 0xffffff), 0, ROUND_UP_16(w1));
+                break;
+
+            case A_ENVMIXER:
+                cmd_envmixer((w0 >> 16) & 0xff, DRAM(w1));
+                break;
+
+            case A_LOADBUFF:
+                memcpy(DMEM_U8(sRsp.in), DRAM(w1), ROUND_UP_8(sRsp.count));
+                break;
+
+            case A_RESAMPLE:
+                cmd_resample((w0 >> 16) & 0xff, w0 & 0xffff, DRAM(w1));
+                break;
+
+            case A_SAVEBUFF:
+                memcpy(DRAM(w1), DMEM_U8(sRsp.out), ROUND_UP_8(sRsp.count));
+                break;
+
+            case A_SETBUFF:
+                if ((w0 >> 16) & A_AUX) {
+                    sRsp.dryRight = w0;
+                    sRsp.wetLeft = w1 >> 16;
+                    sRsp.wetRight = w1;
+                } else {
+                    sRsp.in = w0;
+                    sRsp.out = w1 >> 16;
+                    sRsp.count = w1;
+                }
+                break;
+
+            case A_SETVOL:
+                cmd_setvol((w0 >> 16) & 0xff, w0, w1);
+                break;
+
+            case A_DMEMMOVE:
+                memmove(DMEM_U8(w1 >> 16), DMEM_U8(w0 & 0xffffff), ROUND_UP_16(w1 & 0xffff));
+                break;
+
+            case A_LOADADPCM:
+                size = w0 & 0xffffff;
+                if (size > sizeof(sAdpcmBook)) {
+                    size = sizeof(sAdpcmBook);
+                }
+                memcpy(sAdpcmBook, DRAM(w1), size);
+                adpcm_build_matrices((size + sizeof(sAdpcmBook[0]) - 1) / sizeof(sAdpcmBook[0]));
+                break;
+
+            case A_MIXER:
+                cmd_mixer(w0, w1 >> 16, w1);
+                break;
+
+            case A_INTERLEAVE:
+                cmd_interleave(w1 >> 16, w1);
+                break;
+
+            case A_SETLOOP:
+                sRsp.loopState = DRAM(w1);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
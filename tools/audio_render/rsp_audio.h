@@ -0,0 +1,19 @@
+#ifndef RSP_AUDIO_H
+#define RSP_AUDIO_H
+
+#include <PR/ultratypes.h>
+
+/*
+ * A host implementation of the audio microcode commands in include/PR/abi.h,
+ * for running the command lists made by synthesis_execute without an RSP.
+ * DRAM addresses in the commands are used as host pointers, so everything
+ * they point to has to be below 4 GB (see Awords in abi.h).
+ */
+
+// Forget the DMEM contents and loaded ADPCM book, as after loading the microcode
+void rsp_audio_init(void);
+
+// Run numCmds commands, as the audio task does with its data_ptr and data_size
+void rsp_audio_run(u64 *cmds, s32 numCmds);
+
+#endif // RSP_AUDIO_H
@@ -0,0 +1,387 @@
+/*
+ * sequence_report: plays sequences with the game's sequence player and
+ * synthesis code in src/audio, without running the command lists, and
+ * reports what each one costs: the notes it keeps active, the notes it steals
+ * from lower priority layers, the sample DMAs it starts and the audio commands
+ * it makes, from gAudioUpdateStats after every audio update. With
+ * SAMPLE_DMA_CACHE it also lists how the sample DMA buffers did.
+ *
+ * Usage: sequence_report [-t SECONDS] [-o DIR] [-g FILE [-u]] [SEQUENCE...]
+ *
+ * Sequences are picked and played as in audio_render. With -o the stats of
+ * every update are also written to DIR/NN.csv.
+ *
+ * With -g the command lists are checked against the hashes in FILE, and the
+ * program fails if any differ. DRAM addresses in the audio heap are hashed as
+ * offsets into it, so the hashes don't depend on where the heap is linked.
+ * -u writes the hashes to FILE instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "audio/data.h"
+#include "audio/external.h"
+#include "audio/heap.h"
+#include "audio/load.h"
+#include "audio/synthesis.h"
+#include "stubs.h"
+
+#ifndef AUDIO_PROFILER
+#error "sequence_report has to be built with -DAUDIO_PROFILER"
+#endif
+
+struct SequenceReport {
+    s32 seqId;
+    s32 numFrames;
+    u32 numSamples;
+    u32 numUpdates;
+    u32 activeNotes; // totals over all updates
+    u32 noteSteals;
+    u32 dmaRequests;
+    u32 numCmds;
+    u16 maxActiveNotes; // of any one update
+    u16 maxDmaRequests;
+    u16 maxCmds;
+    u32 cmdHash;
+    double cpuSeconds;
+#ifdef SAMPLE_DMA_CACHE
+    struct SampleDmaCacheStats dmaCache;
+#endif
+};
+
+struct GoldenHash {
+    s32 seqId;
+    s32 numFrames;
+    u32 cmdHash;
+};
+
+static double sMaxSeconds = 60.0;
+static const char *sOutputDir;
+static const char *sGoldenPath;
+static s32 sUpdateGolden = FALSE;
+
+static double cpu_time(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FNV-1a, a word at a time
+static u32 hash_u32(u32 hash, u32 value) {
+    s32 i;
+
+    for (i = 0; i < 4; i++) {
+        hash = (hash ^ (value & 0xFF)) * 16777619;
+        value >>= 8;
+    }
+    return hash;
+}
+
+static u32 hash_cmds(u32 hash, u64 *cmds, s32 numCmds) {
+    Acmd *cmd = (Acmd *) cmds;
+    u32 w0;
+    u32 w1;
+    s32 i;
+
+    for (i = 0; i < numCmds; i++, cmd++) {
+        w0 = cmd->words.w0;
+        w1 = cmd->words.w1;
+        switch (w0 >> 24) {
+            case A_ADPCM:
+            case A_RESAMPLE:
+            case A_ENVMIXER:
+            case A_LOADBUFF:
+            case A_SAVEBUFF:
+            case A_LOADADPCM:
+            case A_SETLOOP:
+            case A_POLEF:
+                if (w1 - (u32) (uintptr_t) gAudioHeap < (u32) gAudioHeapSize) {
+                    w1 -= (u32) (uintptr_t) gAudioHeap;
+                }
+                break;
+        }
+        hash = hash_u32(hash_u32(hash, w0), w1);
+    }
+    return hash;
+}
+
+static void record_updates(struct SequenceReport *report, FILE *csv) {
+    struct AudioUpdateStats *stats;
+    s32 i;
+
+    for (i = 0; i < gAudioUpdatesPerFrame && i < MAX_UPDATES_PER_FRAME; i++) {
+        stats = &gAudioUpdateStats[i];
+        report->numUpdates++;
+        report->activeNotes += stats->activeNotes;
+        report->noteSteals += stats->noteSteals;
+        report->dmaRequests += stats->dmaRequests;
+        report->numCmds += stats->numCmds;
+        if (report->maxActiveNotes < stats->activeNotes) {
+            report->maxActiveNotes = stats->activeNotes;
+        }
+        if (report->maxDmaRequests < stats->dmaRequests) {
+            report->maxDmaRequests = stats->dmaRequests;
+        }
+        if (report->maxCmds < stats->numCmds) {
+            report->maxCmds = stats->numCmds;
+        }
+        if (csv != NULL) {
+            fprintf(csv, "%d,%d,%d,%d,%d,%d\n", report->numFrames, i, stats->activeNotes,
+                    stats->noteSteals, stats->dmaRequests, stats->numCmds);
+        }
+    }
+}
+
+static void play_sequence(struct SequenceReport *report, FILE *csv) {
+    struct SPTask *task;
+    s32 maxFrames = sMaxSeconds * FRAMES_PER_SECOND;
+    double start;
+
+    audio_init();
+    gAiSamplesQueued = 0;
+    load_sequence(SEQ_PLAYER_LEVEL, report->seqId, FALSE);
+    report->cmdHash = 2166136261u;
+
+    for (report->numFrames = 0; report->numFrames < maxFrames; report->numFrames++) {
+        if (report->numFrames != 0 && !level_sequence_playing()) {
+            break;
+        }
+
+        start = cpu_time();
+        task = create_next_audio_frame_task();
+        report->cpuSeconds += cpu_time() - start;
+        if (task != NULL) {
+            record_updates(report, csv);
+            report->cmdHash = hash_cmds(report->cmdHash, task->task.t.data_ptr,
+                                        task->task.t.data_size / sizeof(u64));
+            report->numSamples += gAiBufferLengths[gCurrAiBufferIndex];
+        }
+        ai_play_frame(report->numFrames);
+    }
+#ifdef SAMPLE_DMA_CACHE
+    report->dmaCache = gSampleDmaCacheStats;
+#endif
+}
+
+static void print_report(const char *name, struct SequenceReport *report) {
+    double seconds = (double) report->numSamples / gAiFrequency;
+    u32 numUpdates = report->numUpdates != 0 ? report->numUpdates : 1;
+
+    printf("%-5s %7.1f %7u %6.2f %5u %7u %7u %5u %7.1f %5u %8.2f  %08x\n", name, seconds,
+           report->numUpdates, (double) report->activeNotes / numUpdates, report->maxActiveNotes,
+           report->noteSteals, report->dmaRequests, report->maxDmaRequests,
+           (double) report->numCmds / numUpdates, report->maxCmds,
+           seconds != 0.0 ? report->cpuSeconds * 1000.0 / seconds : 0.0, report->cmdHash);
+}
+
+#ifdef SAMPLE_DMA_CACHE
+static void print_dma_cache(const char *name, struct SampleDmaCacheStats *stats) {
+    u32 numReads = stats->hits + stats->misses;
+
+    printf("%-5s %7u %8u %7u %6.1f %9u %10u %7.1f %8u %10u\n", name, stats->numBuffers, stats->hits,
+           stats->misses, numReads != 0 ? stats->hits * 100.0 / numReads : 0.0, stats->evictions,
+           stats->prefetches,
+           stats->prefetches != 0 ? stats->prefetchHits * 100.0 / stats->prefetches : 0.0,
+           stats->overruns, stats->queueFull);
+}
+
+static void print_dma_caches(struct SequenceReport *reports, s32 numReports) {
+    struct SampleDmaCacheStats total;
+    char name[8];
+    s32 i;
+
+    memset(&total, 0, sizeof(total));
+    printf("\n%-5s %7s %8s %7s %6s %9s %10s %7s %8s %10s\n", "seq", "buffers", "hits", "misses",
+           "hit %", "evictions", "prefetches", "used %", "overruns", "queue full");
+    for (i = 0; i < numReports; i++) {
+        snprintf(name, sizeof(name), "%02X", reports[i].seqId);
+        print_dma_cache(name, &reports[i].dmaCache);
+        total.numBuffers = reports[i].dmaCache.numBuffers;
+        total.hits += reports[i].dmaCache.hits;
+        total.misses += reports[i].dmaCache.misses;
+        total.evictions += reports[i].dmaCache.evictions;
+        total.prefetches += reports[i].dmaCache.prefetches;
+        total.prefetchHits += reports[i].dmaCache.prefetchHits;
+        total.overruns += reports[i].dmaCache.overruns;
+        total.queueFull += reports[i].dmaCache.queueFull;
+    }
+    print_dma_cache("all", &total);
+}
+#endif
+
+static s32 read_golden(const char *path, struct GoldenHash *golden, s32 capacity) {
+    FILE *f = fopen(path, "r");
+    char line[128];
+    s32 count = 0;
+
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+    while (count < capacity && fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%x %d %x", &golden[count].seqId, &golden[count].numFrames,
+                   &golden[count].cmdHash) == 3) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+static void write_golden(const char *path, struct SequenceReport *reports, s32 numReports) {
+    FILE *f = fopen(path, "w");
+    s32 i;
+
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "# Written by sequence_report -u with -t %g: sequence, frames, command list hash\n",
+            sMaxSeconds);
+    for (i = 0; i < numReports; i++) {
+        fprintf(f, "%02X %d %08x\n", reports[i].seqId, reports[i].numFrames, reports[i].cmdHash);
+    }
+    fclose(f);
+}
+
+// Returns the number of sequences that don't match
+static s32 check_golden(const char *path, struct SequenceReport *reports, s32 numReports) {
+    struct GoldenHash golden[256];
+    s32 numGolden = read_golden(path, golden, ARRAY_COUNT(golden));
+    s32 numFailed = 0;
+    s32 i, j;
+
+    for (i = 0; i < numReports; i++) {
+        for (j = 0; j < numGolden; j++) {
+            if (golden[j].seqId == reports[i].seqId) {
+                break;
+            }
+        }
+        if (j == numGolden) {
+            printf("%02X: no hash in %s\n", reports[i].seqId, path);
+            numFailed++;
+        } else if (golden[j].numFrames != reports[i].numFrames
+                   || golden[j].cmdHash != reports[i].cmdHash) {
+            printf("%02X: %d frames, hash %08x, expected %d frames, hash %08x\n", reports[i].seqId,
+                   reports[i].numFrames, reports[i].cmdHash, golden[j].numFrames, golden[j].cmdHash);
+            numFailed++;
+        }
+    }
+    return numFailed;
+}
+
+int main(int argc, char *argv[]) {
+    struct SequenceReport *reports;
+    struct SequenceReport total;
+    s32 *seqIds;
+    s32 numSeqs = 0;
+    s32 numFailed;
+    char path[1024];
+    char name[8];
+    FILE *csv = NULL;
+    s32 i;
+
+    seqIds = malloc(argc * sizeof(s32));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            sMaxSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            sOutputDir = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            sGoldenPath = argv[++i];
+        } else if (strcmp(argv[i], "-u") == 0) {
+            sUpdateGolden = TRUE;
+        } else if (argv[i][0] != '-') {
+            seqIds[numSeqs++] = strtol(argv[i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [-t SECONDS] [-o DIR] [-g FILE [-u]] [SEQUENCE...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    audio_init();
+    if (numSeqs == 0) {
+        seqIds = realloc(seqIds, gSequenceCount * sizeof(s32));
+        for (i = 1; i < gSequenceCount; i++) {
+            seqIds[numSeqs++] = i;
+        }
+    }
+    for (i = 0; i < numSeqs; i++) {
+        if (seqIds[i] < 0 || seqIds[i] >= gSequenceCount) {
+            fprintf(stderr, "There are only %d sequences\n", gSequenceCount);
+            return 1;
+        }
+    }
+
+    reports = calloc(numSeqs, sizeof(struct SequenceReport));
+    memset(&total, 0, sizeof(total));
+    total.cmdHash = 2166136261u;
+    printf("%-5s %7s %7s %6s %5s %7s %7s %5s %7s %5s %8s  %-8s\n", "seq", "audio s", "updates",
+           "notes", "max", "steals", "dmas", "max", "cmds", "max", "cpu ms/s", "cmd hash");
+    for (i = 0; i < numSeqs; i++) {
+        reports[i].seqId = seqIds[i];
+        if (sOutputDir != NULL) {
+            snprintf(path, sizeof(path), "%s/%02X.csv", sOutputDir, seqIds[i]);
+            csv = fopen(path, "w");
+            if (csv == NULL) {
+                perror(path);
+                return 1;
+            }
+            fprintf(csv, "frame,update,active_notes,note_steals,dma_requests,cmds\n");
+        }
+
+        play_sequence(&reports[i], csv);
+
+        if (csv != NULL) {
+            fclose(csv);
+        }
+        snprintf(name, sizeof(name), "%02X", seqIds[i]);
+        print_report(name, &reports[i]);
+
+        total.numFrames += reports[i].numFrames;
+        total.numSamples += reports[i].numSamples;
+        total.numUpdates += reports[i].numUpdates;
+        total.activeNotes += reports[i].activeNotes;
+        total.noteSteals += reports[i].noteSteals;
+        total.dmaRequests += reports[i].dmaRequests;
+        total.numCmds += reports[i].numCmds;
+        if (total.maxActiveNotes < reports[i].maxActiveNotes) {
+            total.maxActiveNotes = reports[i].maxActiveNotes;
+        }
+        if (total.maxDmaRequests < reports[i].maxDmaRequests) {
+            total.maxDmaRequests = reports[i].maxDmaRequests;
+        }
+        if (total.maxCmds < reports[i].maxCmds) {
+            total.maxCmds = reports[i].maxCmds;
+        }
+        total.cmdHash = hash_u32(total.cmdHash, reports[i].cmdHash);
+        total.cpuSeconds += reports[i].cpuSeconds;
+    }
+    print_report("all", &total);
+#ifdef SAMPLE_DMA_CACHE
+    print_dma_caches(reports, numSeqs);
+#endif
+
+    numFailed = 0;
+    if (sGoldenPath != NULL && sUpdateGolden) {
+        write_golden(sGoldenPath, reports, numSeqs);
+    } else if (sGoldenPath != NULL) {
+        numFailed = check_golden(sGoldenPath, reports, numSeqs);
+        printf("%d of %d sequences match %s\n", numSeqs - numFailed, numSeqs, sGoldenPath);
+    }
+
+    free(reports);
+    free(seqIds);
+    return numFailed != 0;
+}
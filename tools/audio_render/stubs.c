@@ -0,0 +1,123 @@
+/*
+ * Stand-ins for what the audio code links against. DMAs are copies that
+ * complete at once, and the audio interface only counts the samples it has
+ * been given, which ai_play_frame takes away as they would be played.
+ */
+#include <string.h>
+
+#include <ultra64.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "buffers/buffers.h"
+#include "game/area.h"
+#include "game/level_update.h"
+#include "game/object_list_processor.h"
+#include "audio/external.h"
+#include "audio/load.h"
+#include "stubs.h"
+
+ALIGNED16 u8 gAudioHeap[DOUBLE_SIZE_ON_64_BIT(0x31200)];
+ALIGNED8 u8 gAudioSPTaskYieldBuffer[OS_YIELD_AUDIO_SIZE];
+
+// Only used for the level music dynamics and sound distances, which the
+// renderer doesn't use
+s16 gCurrLevelNum;
+s16 gCurrAreaIndex;
+s16 gMarioCurrentRoom;
+struct MarioState gMarioStates[1];
+
+// The microcode isn't run, only pointed to by the audio task
+u64 rspF3DBootStart[1];
+u64 rspF3DBootEnd[1];
+u64 rspAspMainStart[1];
+u64 rspAspMainDataStart[1];
+u64 rspAspMainDataEnd[1];
+
+u32 gAiSamplesQueued;
+
+void osCreateMesgQueue(OSMesgQueue *mq, OSMesg *msg, s32 count) {
+    mq->mtqueue = NULL;
+    mq->fullqueue = NULL;
+    mq->validCount = 0;
+    mq->first = 0;
+    mq->msgCount = count;
+    mq->msg = msg;
+}
+
+static s32 send_mesg(OSMesgQueue *mq, OSMesg msg) {
+    if (mq->validCount >= mq->msgCount) {
+        return -1;
+    }
+    mq->msg[(mq->first + mq->validCount) % mq->msgCount] = msg;
+    mq->validCount++;
+    return 0;
+}
+
+/*
+ * Every DMA has finished by the time anything waits for it, so an empty
+ * queue can't block.
+ */
+s32 osRecvMesg(OSMesgQueue *mq, OSMesg *msg, UNUSED s32 flag) {
+    if (mq->validCount == 0) {
+        return -1;
+    }
+    if (msg != NULL) {
+        *msg = mq->msg[mq->first];
+    }
+    mq->first = (mq->first + 1) % mq->msgCount;
+    mq->validCount--;
+    return 0;
+}
+
+s32 osPiStartDma(OSIoMesg *mb, UNUSED s32 priority, UNUSED s32 direction, uintptr_t devAddr,
+                 void *vAddr, size_t nbytes, OSMesgQueue *mq) {
+    memcpy(vAddr, (void *) devAddr, nbytes);
+    if (mq != NULL) {
+        send_mesg(mq, mb);
+    }
+    return 0;
+}
+
+void osInvalDCache(UNUSED void *vaddr, UNUSED size_t nbytes) {
+}
+
+void osWritebackDCache(UNUSED void *vaddr, UNUSED size_t nbytes) {
+}
+
+void osWritebackDCacheAll(void) {
+}
+
+s32 osAiSetFrequency(u32 frequency) {
+    return frequency;
+}
+
+u32 osAiGetLength(void) {
+    return gAiSamplesQueued * 4;
+}
+
+s32 osAiSetNextBuffer(UNUSED void *buf, u32 size) {
+    gAiSamplesQueued += size / 4;
+    return 0;
+}
+
+void ai_play_frame(s32 frame) {
+    u32 length = (u32) gAiFrequency * (frame + 1) / FRAMES_PER_SECOND
+                 - (u32) gAiFrequency * frame / FRAMES_PER_SECOND;
+
+    gAiSamplesQueued -= (gAiSamplesQueued < length) ? gAiSamplesQueued : length;
+}
+
+s32 level_sequence_playing(void) {
+    s32 i;
+
+    if (gSequencePlayers[SEQ_PLAYER_LEVEL].enabled) {
+        return TRUE;
+    }
+    for (i = 0; i < gMaxSimultaneousNotes; i++) {
+        if (gNotes[i].enabled) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
@@ -0,0 +1,20 @@
+#ifndef STUBS_H
+#define STUBS_H
+
+#include <PR/ultratypes.h>
+
+#define FRAMES_PER_SECOND 60
+
+// load.c
+extern u16 gSequenceCount;
+
+// Samples given to the audio interface that it hasn't played yet
+extern u32 gAiSamplesQueued;
+
+// Take away the samples the audio interface plays between the given frame and the next
+void ai_play_frame(s32 frame);
+
+// Whether the level sequence or any of its notes are still playing
+s32 level_sequence_playing(void);
+
+#endif // STUBS_H
@@ -0,0 +1,637 @@
+/*
+ * collision_bench: replays find_floor, find_ceil, find_wall_collisions and
+ * find_water_level queries against a level's static collision, loaded through
+ * load_area_terrain. For each query it reports throughput, p50/p99 latency and
+ * a histogram of how many surfaces were tested. The checksum covers every
+ * result, so two builds of the engine code can be checked for identical
+ * behavior.
+ *
+ * Probe traces are text files with one "x y z" position per line ('#' starts a
+ * comment). Without a trace, probes are generated at random heights above
+ * random points on the level's floors; -o saves them for replaying later.
+ *
+ * With -d, frames of moving platforms are replayed instead. Each frame loads
+ * the platforms' surfaces between floor and ceiling queries, as the game does
+ * when surface objects update, so the query cache and incremental dynamic
+ * surfaces can be compared against builds without them.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "surface_terrains.h"
+#include "level_misc_macros.h"
+#include "special_presets.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+#include "game/object_list_processor.h"
+
+#include "levels/bowser_1/areas/1/collision.inc.c"
+#include "levels/castle_courtyard/areas/1/collision.inc.c"
+#include "levels/castle_grounds/areas/1/collision.inc.c"
+#include "levels/castle_inside/areas/1/collision.inc.c"
+#include "levels/castle_inside/areas/1/room.inc.c"
+#include "levels/ccm/areas/1/collision.inc.c"
+#include "levels/ccm/areas/2/collision.inc.c"
+#include "levels/ccm/areas/3/collision.inc.c"
+#include "levels/ccm/areas/4/collision.inc.c"
+#include "levels/ddd/areas/1/collision.inc.c"
+#include "levels/ddd/areas/2/collision.inc.c"
+#include "levels/lll/areas/1/collision.inc.c"
+#include "levels/wf/areas/1/collision.inc.c"
+#include "levels/wf/rotating_platform/collision.inc.c"
+
+struct LevelTerrain {
+    const char *name;
+    const Collision *collision;
+    const u8 *rooms;
+};
+
+static const struct LevelTerrain sLevels[] = {
+    { "bowser_1", bowser_1_collision, NULL },
+    { "castle_courtyard", courtyard_collision, NULL },
+    { "castle_grounds", castle_grounds_collision, NULL },
+    { "castle_inside", castle_inside_collision, castle_inside_collision_rooms },
+    { "ccm_1", snow_slider_collision, NULL },
+    { "ccm_2", ccm_seg7_area_2_collision, NULL },
+    { "ccm_3", ccm_seg7_area_3_collision, NULL },
+    { "ccm_4", ccm_seg7_area_4_collision, NULL },
+    { "ddd_1", water_land_area_1_collision, NULL },
+    { "ddd_2", water_land_area_2_collision, NULL },
+    { "lll_1", fire_bubble_collision, NULL },
+    { "wf_1", mountain_collision, NULL },
+};
+
+#define NUM_LEVELS (sizeof(sLevels) / sizeof(sLevels[0]))
+
+struct Probe {
+    f32 x, y, z;
+};
+
+struct ProbeList {
+    struct Probe *probes;
+    int count;
+};
+
+static unsigned int sRandState = 1;
+static volatile unsigned int sQuerySink;
+
+static unsigned int random_u32(void) {
+    sRandState = sRandState * 1103515245 + 12345;
+    return sRandState >> 8;
+}
+
+static f32 random_unit(void) {
+    return (random_u32() & 0xFFFF) / 65536.0f;
+}
+
+static void usage(const char *progname) {
+    unsigned int i;
+
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Options:\n"
+            "  -l LEVEL  only run LEVEL (default: all levels)\n"
+            "  -t FILE   replay the probes in FILE (requires -l)\n"
+            "  -o FILE   write the probes used to FILE (requires -l)\n"
+            "  -n COUNT  number of probes to generate (default: 100000)\n"
+            "  -r COUNT  number of times to replay the probes (default: 10)\n"
+            "  -s SEED   random seed for generated probes (default: 1)\n"
+            "  -d COUNT  replay COUNT frames of moving platforms instead\n"
+            "\n"
+            "Levels:",
+            progname);
+    for (i = 0; i < NUM_LEVELS; i++) {
+        fprintf(stderr, " %s", sLevels[i].name);
+    }
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void add_probe(struct ProbeList *list, f32 x, f32 y, f32 z) {
+    if ((list->count & (list->count - 1)) == 0) {
+        list->probes =
+            realloc(list->probes, (list->count ? list->count * 2 : 1) * sizeof(struct Probe));
+        if (list->probes == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+
+    list->probes[list->count].x = x;
+    list->probes[list->count].y = y;
+    list->probes[list->count].z = z;
+    list->count++;
+}
+
+static void read_probes(struct ProbeList *list, const char *path) {
+    char line[256];
+    f32 x, y, z;
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%f %f %f", &x, &y, &z) == 3) {
+            add_probe(list, x, y, z);
+        }
+    }
+
+    fclose(f);
+}
+
+static void write_probes(const struct ProbeList *list, const char *path) {
+    int i;
+    FILE *f = fopen(path, "w");
+
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+
+    fprintf(f, "# x y z\n");
+    for (i = 0; i < list->count; i++) {
+        fprintf(f, "%.9g %.9g %.9g\n", list->probes[i].x, list->probes[i].y, list->probes[i].z);
+    }
+
+    fclose(f);
+}
+
+/**
+ * Generate probes up to 500 units above random points on the loaded level's floors.
+ */
+static void generate_probes(struct ProbeList *list, int count) {
+    struct Surface *floors[4096];
+    struct Surface *surf;
+    int numFloors = 0;
+    f32 a, b, x, y, z;
+    int i;
+
+    for (i = 0; i < gNumStaticSurfaces && numFloors < 4096; i++) {
+        if (sSurfacePool[i].normal.y > 0.01f) {
+            floors[numFloors++] = &sSurfacePool[i];
+        }
+    }
+
+    if (numFloors == 0) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        surf = floors[random_u32() % numFloors];
+        a = random_unit();
+        b = random_unit();
+        if (a + b > 1.0f) {
+            a = 1.0f - a;
+            b = 1.0f - b;
+        }
+
+        x = surf->vertex1[0] + a * (surf->vertex2[0] - surf->vertex1[0])
+            + b * (surf->vertex3[0] - surf->vertex1[0]);
+        z = surf->vertex1[2] + a * (surf->vertex2[2] - surf->vertex1[2])
+            + b * (surf->vertex3[2] - surf->vertex1[2]);
+
+        y = -(x * surf->normal.x + z * surf->normal.z + surf->originOffset) / surf->normal.y;
+
+        add_probe(list, x, y + random_unit() * 500.0f, z);
+    }
+}
+
+static unsigned int checksum_add(unsigned int hash, const void *data, size_t size) {
+    const u8 *bytes = data;
+
+    while (size--) {
+        hash = (hash ^ *bytes++) * 16777619u;
+    }
+
+    return hash;
+}
+
+static unsigned int checksum_surface(unsigned int hash, struct Surface *surf, f32 height) {
+    s32 index = (surf != NULL) ? (s32) (surf - sSurfacePool) : -1;
+
+    hash = checksum_add(hash, &index, sizeof(index));
+    return checksum_add(hash, &height, sizeof(height));
+}
+
+/**
+ * Each query runs once for the given probe, folds its result into the
+ * checksum, and returns it, so the compiler can't drop the call.
+ */
+static unsigned int query_floor(const struct Probe *p, unsigned int hash) {
+    struct Surface *surf;
+    f32 height = find_floor(p->x, p->y, p->z, &surf);
+
+    return checksum_surface(hash, surf, height);
+}
+
+static unsigned int query_ceil(const struct Probe *p, unsigned int hash) {
+    struct Surface *surf;
+    f32 height = find_ceil(p->x, p->y, p->z, &surf);
+
+    return checksum_surface(hash, surf, height);
+}
+
+/**
+ * Same parameters as Mario's lower wall check in perform_ground_step.
+ */
+static unsigned int query_wall(const struct Probe *p, unsigned int hash) {
+    struct WallCollisionData colData;
+    s32 i;
+
+    colData.x = p->x;
+    colData.y = p->y;
+    colData.z = p->z;
+    colData.offsetY = 30.0f;
+    colData.radius = 24.0f;
+
+    find_wall_collisions(&colData);
+
+    hash = checksum_add(hash, &colData.numWalls, sizeof(colData.numWalls));
+    for (i = 0; i < colData.numWalls; i++) {
+        hash = checksum_surface(hash, colData.walls[i], 0.0f);
+    }
+    hash = checksum_add(hash, &colData.x, sizeof(colData.x));
+    return checksum_add(hash, &colData.z, sizeof(colData.z));
+}
+
+static unsigned int query_water(const struct Probe *p, unsigned int hash) {
+    f32 height = find_water_level(p->x, p->z);
+
+    return checksum_add(hash, &height, sizeof(height));
+}
+
+struct QueryType {
+    const char *name;
+    unsigned int (*run)(const struct Probe *p, unsigned int hash);
+    s32 *visited; // NULL if the query doesn't walk surface lists
+};
+
+static const struct QueryType sQueryTypes[] = {
+    { "floor", query_floor, &gNumSurfacesVisited.floor },
+    { "ceil", query_ceil, &gNumSurfacesVisited.ceil },
+    { "wall", query_wall, &gNumSurfacesVisited.wall },
+    { "water", query_water, NULL },
+};
+
+#define NUM_QUERY_TYPES (sizeof(sQueryTypes) / sizeof(sQueryTypes[0]))
+
+// Histogram buckets for surfaces visited per query: 0, 1, 2, 3-4, 5-8, ..., 65+
+#define NUM_VISITED_BUCKETS 9
+
+static const char *sVisitedBucketNames[NUM_VISITED_BUCKETS] = {
+    "0", "1", "2", "3-4", "5-8", "9-16", "17-32", "33-64", "65+",
+};
+
+static int visited_bucket(s32 visited) {
+    int bucket = 0;
+
+    while (visited > (1 << bucket) && bucket < NUM_VISITED_BUCKETS - 2) {
+        bucket++;
+    }
+
+    return (visited == 0) ? 0 : (visited > 64) ? NUM_VISITED_BUCKETS - 1 : bucket + 1;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Estimate what timing an empty region costs, so it can be taken out of the
+ * per-query latencies.
+ */
+static double timer_overhead(void) {
+    double samples[1001];
+    double start;
+    int i;
+
+    for (i = 0; i < 1001; i++) {
+        start = now_seconds();
+        samples[i] = now_seconds() - start;
+    }
+
+    qsort(samples, 1001, sizeof(double), compare_doubles);
+    return samples[500];
+}
+
+static void run_query(const struct QueryType *query, const struct ProbeList *list, int repeat,
+                      double overhead) {
+    unsigned int hash = 2166136261u;
+    unsigned int sink = 0;
+    int histogram[NUM_VISITED_BUCKETS];
+    double *latencies;
+    double start, total, latency;
+    s32 prevVisited;
+    int i, r;
+
+    memset(histogram, 0, sizeof(histogram));
+    latencies = malloc(list->count * sizeof(double));
+    if (latencies == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    // Results only need to be checksummed once. This pass also times each
+    // query on its own and counts the surfaces it visits.
+    for (i = 0; i < list->count; i++) {
+        prevVisited = (query->visited != NULL) ? *query->visited : 0;
+
+        start = now_seconds();
+        hash = query->run(&list->probes[i], hash);
+        latency = now_seconds() - start - overhead;
+
+        latencies[i] = (latency > 0.0) ? latency : 0.0;
+        if (query->visited != NULL) {
+            histogram[visited_bucket(*query->visited - prevVisited)]++;
+        }
+    }
+
+    // Throughput is measured without the timer calls in the loop.
+    start = now_seconds();
+    for (r = 0; r < repeat; r++) {
+        for (i = 0; i < list->count; i++) {
+            sink = query->run(&list->probes[i], sink);
+        }
+    }
+    total = now_seconds() - start;
+
+    qsort(latencies, list->count, sizeof(double), compare_doubles);
+
+    printf("  %-6s %8.0fk/s %7.0f %7.0f  ", query->name,
+           (double) list->count * repeat / total / 1000.0, latencies[list->count / 2] * 1e9,
+           latencies[(int) (list->count * 0.99)] * 1e9);
+    if (query->visited != NULL) {
+        for (i = 0; i < NUM_VISITED_BUCKETS; i++) {
+            printf(" %5.1f", histogram[i] * 100.0 / list->count);
+        }
+    } else {
+        for (i = 0; i < NUM_VISITED_BUCKETS; i++) {
+            printf(" %5s", "-");
+        }
+    }
+    printf("  %08x\n", hash);
+
+    // Keep the timed results alive.
+    sQuerySink = sink;
+
+    free(latencies);
+}
+
+static void run_level(const struct LevelTerrain *level, const char *tracePath, const char *outPath,
+                      int numProbes, int repeat, double overhead) {
+    struct ProbeList list = { NULL, 0 };
+    unsigned int i;
+
+    load_area_terrain(0, (TerrainData *) level->collision, (RoomData *) level->rooms, NULL);
+
+    if (tracePath != NULL) {
+        read_probes(&list, tracePath);
+    } else {
+        generate_probes(&list, numProbes);
+    }
+
+    if (outPath != NULL) {
+        write_probes(&list, outPath);
+    }
+
+    if (list.count == 0) {
+        printf("%s: no probes\n", level->name);
+        return;
+    }
+
+    printf("%s: %d surfaces, %d probes\n", level->name, gNumStaticSurfaces, list.count);
+    printf("  %-6s %11s %7s %7s  ", "query", "throughput", "p50 ns", "p99 ns");
+    for (i = 0; i < NUM_VISITED_BUCKETS; i++) {
+        printf(" %5s", sVisitedBucketNames[i]);
+    }
+    printf("  checksum\n");
+
+    for (i = 0; i < NUM_QUERY_TYPES; i++) {
+        run_query(&sQueryTypes[i], &list, repeat, overhead);
+    }
+
+    free(list.probes);
+}
+
+#define NUM_PLATFORMS 8
+#define NUM_ACTORS     16
+#define ACTOR_QUERIES  4 // Queries by each actor while each platform updates
+
+/**
+ * Move a platform to (x, y, z), turned by yaw.
+ */
+static void place_platform(struct Object *obj, f32 x, f32 y, f32 z, f32 yaw) {
+    f32 c = cosf(yaw);
+    f32 s = sinf(yaw);
+
+    memset(obj->transform, 0, sizeof(Mat4));
+    obj->transform[0][0] = c;
+    obj->transform[0][2] = -s;
+    obj->transform[1][1] = 1.0f;
+    obj->transform[2][0] = s;
+    obj->transform[2][2] = c;
+    obj->transform[3][0] = x;
+    obj->transform[3][1] = y;
+    obj->transform[3][2] = z;
+    obj->transform[3][3] = 1.0f;
+}
+
+/**
+ * Replay frames where platforms placed on the level's floors move, turn or
+ * stay still, while actors next to them query the floor and ceiling under
+ * themselves. Half the platforms stay still, so incremental dynamic surfaces
+ * keep theirs. The checksum covers every query result.
+ */
+static void run_dynamic(const struct LevelTerrain *level, int numFrames) {
+    struct ProbeList list = { NULL, 0 };
+    struct Probe actors[NUM_ACTORS];
+    struct Object *obj;
+    struct Surface *surf;
+    unsigned int hash = 2166136261u;
+    double start, total;
+    f32 height;
+    int frame, i, j, k;
+#ifdef SURFACE_QUERY_CACHE
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+#endif
+
+    load_area_terrain(0, (TerrainData *) level->collision, (RoomData *) level->rooms, NULL);
+    generate_probes(&list, NUM_PLATFORMS + NUM_ACTORS);
+    if (list.count == 0) {
+        printf("%s: no probes\n", level->name);
+        return;
+    }
+
+    memset(gObjectPool, 0, OBJECT_POOL_CAPACITY * sizeof(struct Object));
+    gMarioObject = &gObjectPool[0];
+
+    for (i = 1; i <= NUM_PLATFORMS; i++) {
+        obj = &gObjectPool[i];
+        obj->activeFlags = ACTIVE_FLAG_ACTIVE;
+        obj->collisionData = (void *) wf_seg7_collision_rotating_platform;
+        obj->oCollisionDistance = 100000.0f;
+        obj->header.gfx.throwMatrix = &obj->transform;
+        place_platform(obj, list.probes[i - 1].x, list.probes[i - 1].y, list.probes[i - 1].z, 0.0f);
+    }
+
+    start = now_seconds();
+    for (frame = 0; frame < numFrames; frame++) {
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+        begin_dynamic_surface_update();
+#else
+        clear_dynamic_surfaces();
+#endif
+
+        // Actors stay still for a few frames at a time, like enemies waiting around.
+        for (j = 0; j < NUM_ACTORS; j++) {
+            if (frame == 0 || random_u32() % 8 == 0) {
+                actors[j] = list.probes[(NUM_PLATFORMS + j) % list.count];
+                actors[j].x += (random_unit() - 0.5f) * 400.0f;
+                actors[j].z += (random_unit() - 0.5f) * 400.0f;
+            }
+        }
+
+        for (i = 1; i <= NUM_PLATFORMS; i++) {
+            obj = &gObjectPool[i];
+            if (i % 2 == 0) {
+                place_platform(obj, obj->transform[3][0] + (random_unit() - 0.5f) * 20.0f,
+                               obj->transform[3][1] + (random_unit() - 0.5f) * 10.0f,
+                               obj->transform[3][2] + (random_unit() - 0.5f) * 20.0f,
+                               frame * 0.01f);
+            }
+
+            gCurrentObject = obj;
+            load_object_collision_model();
+
+            for (j = 0; j < NUM_ACTORS; j++) {
+                for (k = 0; k < ACTOR_QUERIES; k++) {
+                    gCheckingSurfaceCollisionsForCamera = (k == ACTOR_QUERIES - 1);
+                    if (k % 2 == 0) {
+                        height = find_floor(actors[j].x, actors[j].y, actors[j].z, &surf);
+                    } else {
+                        height = find_ceil(actors[j].x, actors[j].y, actors[j].z, &surf);
+                    }
+                    hash = checksum_surface(hash, surf, height);
+                }
+            }
+            gCheckingSurfaceCollisionsForCamera = FALSE;
+        }
+
+#ifdef INCREMENTAL_DYNAMIC_SURFACES
+        unload_stale_dynamic_surfaces();
+#endif
+#ifdef SURFACE_QUERY_CACHE
+        hits += gSurfaceQueryCacheStats.hits;
+        misses += gSurfaceQueryCacheStats.misses;
+#endif
+    }
+    total = now_seconds() - start;
+
+    printf("%s: %d frames, %.0f us/frame, checksum %08x\n", level->name, numFrames,
+           total * 1e6 / numFrames, hash);
+#ifdef SURFACE_QUERY_CACHE
+    printf("  query cache: %u hits, %u misses\n", hits, misses);
+#endif
+
+    free(list.probes);
+}
+
+int main(int argc, char *argv[]) {
+    const char *levelName = NULL;
+    const char *tracePath = NULL;
+    const char *outPath = NULL;
+    int numProbes = 100000;
+    double overhead;
+    int repeat = 10;
+    int numFrames = 0;
+    unsigned int i;
+    int found = FALSE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:t:o:n:r:s:d:")) != -1) {
+        switch (opt) {
+            case 'l':
+                levelName = optarg;
+                break;
+            case 't':
+                tracePath = optarg;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            case 'n':
+                numProbes = atoi(optarg);
+                break;
+            case 'r':
+                repeat = atoi(optarg);
+                break;
+            case 's':
+                sRandState = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                numFrames = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+
+    if ((tracePath != NULL || outPath != NULL) && levelName == NULL) {
+        usage(argv[0]);
+    }
+
+    if (repeat < 1) {
+        repeat = 1;
+    }
+
+    alloc_surface_pools();
+    overhead = timer_overhead();
+
+    if (numFrames <= 0) {
+        printf("Surfaces visited per query are given as a percentage of queries in each bucket.\n\n");
+    }
+
+    for (i = 0; i < NUM_LEVELS; i++) {
+        if (levelName == NULL || strcmp(levelName, sLevels[i].name) == 0) {
+            if (numFrames > 0) {
+                run_dynamic(&sLevels[i], numFrames);
+            } else {
+                run_level(&sLevels[i], tracePath, outPath, numProbes, repeat, overhead);
+            }
+            found = TRUE;
+        }
+    }
+
+    if (!found) {
+        usage(argv[0]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Stand-ins for the game state and functions that surface_load.c and
+ * surface_collision.c link against. Only what level terrain and the
+ * platforms in collision_bench.c need is implemented; objects are never
+ * spawned.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "model_ids.h"
+#include "behavior_data.h"
+#include "engine/surface_collision.h"
+#include "engine/surface_load.h"
+#include "game/object_list_processor.h"
+#include "special_presets.inc.c"
+
+s32 gSurfaceNodesAllocated;
+s32 gSurfacesAllocated;
+s32 gNumStaticSurfaceNodes;
+s32 gNumStaticSurfaces;
+
+u32 gTimeStopState;
+struct Object *gCurrentObject;
+struct Object gObjectPool[OBJECT_POOL_CAPACITY];
+struct Object *gMarioObject;
+
+s16 gCheckingSurfaceCollisionsForCamera;
+s16 gFindFloorIncludeSurfaceIntangible;
+TerrainData *gEnvironmentRegions;
+s32 gEnvironmentLevels[20];
+
+s32 gNumFindFloorMisses;
+struct NumTimesCalled gNumCalls;
+
+#ifdef MEMORY_TRACKER
+const char *gMemoryTag;
+#endif
+
+// In parentheses so that MEMORY_TRACKER's tagging macro isn't expanded here
+void *(main_pool_alloc)(u32 size, UNUSED u32 side) {
+    return calloc(1, size);
+}
+
+/**
+ * Skip over the special objects in a collision list without spawning them.
+ */
+void spawn_special_objects(UNUSED s16 areaIndex, TerrainData **specialObjList) {
+    s32 numOfSpecialObjects = *(*specialObjList)++;
+    s32 offset;
+    s32 i;
+    u8 presetID;
+
+    for (i = 0; i < numOfSpecialObjects; i++) {
+        presetID = (u8) *(*specialObjList)++;
+        *specialObjList += 3;
+
+        for (offset = 0; sSpecialObjectPresets[offset].presetID != presetID; offset++) {
+        }
+
+        switch (sSpecialObjectPresets[offset].type) {
+            case SPTYPE_YROT_NO_PARAMS:
+            case SPTYPE_DEF_PARAM_AND_YROT:
+                *specialObjList += 1;
+                break;
+            case SPTYPE_PARAMS_AND_YROT:
+                *specialObjList += 2;
+                break;
+            case SPTYPE_UNKNOWN:
+                *specialObjList += 3;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void spawn_macro_objects(UNUSED s16 areaIndex, UNUSED s16 *macroObjList) {
+}
+
+void spawn_macro_objects_hardcoded(UNUSED s16 areaIndex, UNUSED s16 *macroObjList) {
+}
+
+void obj_build_transform_from_pos_and_angle(UNUSED struct Object *obj, UNUSED s16 posIndex,
+                                            UNUSED s16 angleIndex) {
+}
+
+/**
+ * Platforms aren't scaled, so their transform is used as is.
+ */
+void obj_apply_scale_to_matrix(UNUSED struct Object *obj, Mat4 dst, Mat4 src) {
+    memcpy(dst, src, sizeof(Mat4));
+}
+
+f32 dist_between_objects(UNUSED struct Object *obj1, UNUSED struct Object *obj2) {
+    return 0.0f;
+}
+
+void print_debug_top_down_mapinfo(UNUSED const char *str, UNUSED s32 number) {
+}
+
+void set_text_array_x_y(UNUSED s32 xOffset, UNUSED s32 yOffset) {
+}
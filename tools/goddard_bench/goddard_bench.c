@@ -0,0 +1,234 @@
+/*
+ * goddard_bench: loads the Mario head from its dynlists the way the title
+ * screen does, and then runs it for a number of frames. It reports the time
+ * taken by gdm_maketestdl (which calls load_mario_head) and by each frame's
+ * gdm_gettestdl and gd_vblank (not counting the hashing), and a hash of every frame's display list, so
+ * that two builds of the goddard code can be checked for identical output.
+ *
+ * Usage: goddard_bench [-l LOADS] [-f FRAMES] [-i [-p]] [-m]
+ *
+ * The head is loaded LOADS times (10 by default) from a fresh gdm_init, and
+ * the last one is run for FRAMES frames (600 by default). Without -i the
+ * controller is left alone, as on the title screen when nobody is playing;
+ * with -i the cursor is moved around the face with A held down, to grab and
+ * pull it. With -p as well, the stick is let go every other second, so that
+ * the cursor keeps still for a while.
+ *
+ * The hash covers the commands of the display list and of every display list
+ * it calls, and the vertices, matrices and lights they load, but not their
+ * addresses.
+ *
+ * With GODDARD_DYNOBJ_INDEX, the name lookups made by the last load are
+ * reported too. With GODDARD_SLAB_ALLOCATOR, so is the goddard heap use at
+ * the end, and -m prints slab_stats' report of it to stderr. With
+ * GODDARD_HAND_DL_CACHE, so is how many of the frames' hand display lists
+ * were reused.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ultra64.h>
+
+#include "macros.h"
+#include "platform_info.h"
+#include "goddard/dynlist_proc.h"
+#include "goddard/gd_memory.h"
+#include "goddard/renderer.h"
+
+#define MARIO_HEAD_SCENE 2
+
+// Same size as the level script gives it
+static ALIGNED8 u8 sGoddardHeap[GD_HEAP_SIZE];
+// Stand-ins for the z-buffer and frame buffers, which the level script lends
+// to goddard as temporary memory
+static ALIGNED8 u8 sZBuffer[0x25800];
+static ALIGNED8 u8 sFramebuffers[0x70800];
+
+static s32 sNumLoads = 10;
+static s32 sNumFrames = 600;
+static s32 sInteract = FALSE;
+static s32 sPause = FALSE;
+static s32 sPrintMemStats = FALSE;
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+static double cpu_time(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FNV-1a
+static u32 hash_bytes(u32 hash, const void *data, size_t size) {
+    const u8 *bytes = data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619;
+    }
+    return hash;
+}
+
+static u32 hash_display_list(u32 hash, Gfx *gfx, s32 depth) {
+    u32 w0;
+    u8 opcode;
+
+    if (depth > 10) {
+        fprintf(stderr, "Display lists nested too deeply\n");
+        exit(1);
+    }
+
+    for (;; gfx++) {
+        w0 = gfx->words.w0;
+        opcode = w0 >> 24;
+        hash = hash_bytes(hash, &w0, sizeof(w0));
+
+        switch (opcode) {
+            case (u8) G_DL:
+                hash = hash_display_list(hash, (Gfx *) gfx->words.w1, depth + 1);
+                if (((w0 >> 16) & 0xFF) == G_DL_NOPUSH) {
+                    return hash;
+                }
+                break;
+            case (u8) G_VTX:
+            case (u8) G_MTX:
+            case (u8) G_MOVEMEM:
+                hash = hash_bytes(hash, (void *) gfx->words.w1, w0 & 0xFFFF);
+                break;
+            case (u8) G_SETTIMG:
+            case (u8) G_SETCIMG:
+            case (u8) G_SETZIMG:
+                break;
+            case (u8) G_ENDDL:
+                return hash;
+            default:
+                hash = hash_bytes(hash, &gfx->words.w1, sizeof(u32));
+                break;
+        }
+    }
+}
+
+/*
+ * Circle the cursor around the middle of the screen, holding A for the
+ * second half of every 4 seconds. With -p the stick is let go for every
+ * other second.
+ */
+static void scripted_input(OSContPad *pad, s32 frame) {
+    static const s8 sStick[8][2] = {
+        { 40, 0 }, { 28, 28 }, { 0, 40 }, { -28, 28 }, { -40, 0 }, { -28, -28 }, { 0, -40 }, { 28, -28 },
+    };
+
+    memset(pad, 0, sizeof(*pad));
+    if (!sInteract) {
+        return;
+    }
+    if (!sPause || (frame / 30) % 2 == 0) {
+        pad->stick_x = sStick[(frame / 8) % 8][0];
+        pad->stick_y = sStick[(frame / 8) % 8][1];
+    }
+    if (frame % 120 >= 60) {
+        pad->button |= A_BUTTON;
+    }
+}
+
+static void load_head(double *loadSeconds) {
+    double start;
+
+    gdm_init(sGoddardHeap, sizeof(sGoddardHeap));
+    gd_add_to_heap(sZBuffer, sizeof(sZBuffer));
+    gd_add_to_heap(sFramebuffers, sizeof(sFramebuffers));
+    gdm_setup();
+    start = cpu_time();
+    gdm_maketestdl(MARIO_HEAD_SCENE);
+    *loadSeconds = cpu_time() - start;
+}
+
+int main(int argc, char *argv[]) {
+    OSContPad pad;
+    Gfx *gfx;
+    double seconds;
+    double minLoad = 0.0;
+    double totalLoad = 0.0;
+    double start;
+    double frameSeconds = 0.0;
+    double *frameTimes;
+    u32 hash = 2166136261u;
+    s32 i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            sNumLoads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            sNumFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0) {
+            sInteract = TRUE;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            sPause = TRUE;
+        } else if (strcmp(argv[i], "-m") == 0) {
+            sPrintMemStats = TRUE;
+        } else {
+            fprintf(stderr, "Usage: %s [-l LOADS] [-f FRAMES] [-i [-p]] [-m]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sNumLoads < 1) {
+        sNumLoads = 1;
+    }
+
+    for (i = 0; i < sNumLoads; i++) {
+        load_head(&seconds);
+        totalLoad += seconds;
+        if (i == 0 || seconds < minLoad) {
+            minLoad = seconds;
+        }
+    }
+    printf("load_mario_head: %.3f ms average, %.3f ms best of %d\n", totalLoad / sNumLoads * 1000.0,
+           minLoad * 1000.0, sNumLoads);
+#ifdef GODDARD_DYNOBJ_INDEX
+    printf("dynobj lookups: %u (%u integer names), %u misses, %.2f names compared per lookup\n",
+           gDynObjLookupStats.lookups, gDynObjLookupStats.intLookups, gDynObjLookupStats.misses,
+           gDynObjLookupStats.lookups != 0
+               ? (double) gDynObjLookupStats.compares / gDynObjLookupStats.lookups
+               : 0.0);
+#endif
+
+    frameTimes = malloc((sNumFrames + 1) * sizeof(double));
+    for (i = 0; i < sNumFrames; i++) {
+        scripted_input(&pad, i);
+        gd_copy_p1_contpad(&pad);
+        start = cpu_time();
+        gfx = gdm_gettestdl(MARIO_HEAD_SCENE);
+        seconds = cpu_time() - start;
+        hash = hash_display_list(hash, gfx, 0);
+        start = cpu_time();
+        gd_vblank();
+        frameTimes[i] = seconds + (cpu_time() - start);
+        frameSeconds += frameTimes[i];
+    }
+    if (sNumFrames > 0) {
+        qsort(frameTimes, sNumFrames, sizeof(double), compare_doubles);
+        printf("frames: %d, %.4f ms per frame on average, %.4f ms median\n", sNumFrames,
+               frameSeconds / sNumFrames * 1000.0, frameTimes[sNumFrames / 2] * 1000.0);
+    }
+    free(frameTimes);
+#ifdef GODDARD_SLAB_ALLOCATOR
+    printf("goddard heap: %u bytes in use, %u in slab pages, %u requests from the block lists\n",
+           gGdMemStats.inUse, gGdMemStats.slabBytes, gGdMemStats.blockAllocs);
+    if (sPrintMemStats) {
+        slab_stats();
+    }
+#endif
+#ifdef GODDARD_HAND_DL_CACHE
+    printf("hand display lists: %u reused of %u\n", gHandDlStats.reused, gHandDlStats.dls);
+#endif
+    printf("display list hash: %08x\n", hash);
+    return 0;
+}
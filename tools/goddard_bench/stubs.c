@@ -0,0 +1,77 @@
+/*
+ * Stand-ins for the libultra functions the goddard code links against. There
+ * is no controller, video or RSP: controller reads are left to
+ * goddard_bench.c, which copies its scripted input in with
+ * gd_copy_p1_contpad as the game does, and physical addresses are the host
+ * addresses.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ultra64.h>
+
+#include "macros.h"
+
+void osCreateMesgQueue(OSMesgQueue *mq, OSMesg *msg, s32 count) {
+    mq->mtqueue = NULL;
+    mq->fullqueue = NULL;
+    mq->validCount = 0;
+    mq->first = 0;
+    mq->msgCount = count;
+    mq->msg = msg;
+}
+
+// Only called by goddard's unused DMA and buffer swapping code
+s32 osRecvMesg(UNUSED OSMesgQueue *mq, UNUSED OSMesg *msg, UNUSED s32 flag) {
+    return 0;
+}
+
+void osSetEventMesg(UNUSED OSEvent event, UNUSED OSMesgQueue *mq, UNUSED OSMesg msg) {
+}
+
+s32 osContInit(UNUSED OSMesgQueue *mq, u8 *bitpattern, UNUSED OSContStatus *status) {
+    *bitpattern = 1;
+    return 0;
+}
+
+s32 osContStartReadData(UNUSED OSMesgQueue *mq) {
+    return 0;
+}
+
+void osViSetSpecialFeatures(UNUSED u32 func) {
+}
+
+void osViSwapBuffer(UNUSED void *frameBufPtr) {
+}
+
+uintptr_t osVirtualToPhysical(void *addr) {
+    return (uintptr_t) addr;
+}
+
+/*
+ * gd_rand_float mixes the time into its seed, so time moves on by the same
+ * amount on every call instead, to make the display lists the same on every
+ * run. Goddard's own timers are meaningless as a result; goddard_bench times
+ * things itself.
+ */
+OSTime osGetTime(void) {
+    static OSTime sTime;
+
+    sTime += 1000;
+    return sTime;
+}
+
+// Only replaces the calls from outside renderer.c, which include fatal_printf's
+void __wrap_gd_printf(const char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void __wrap_gd_exit(s32 code) {
+    fprintf(stderr, "goddard called gd_exit(%d)\n", code);
+    exit(1);
+}
@@ -0,0 +1,117 @@
+/*
+ * Batched versions of mtxf_mul (src/engine/math_util.c) and
+ * linear_mtxf_mul_vec3f (src/game/object_helpers.c), for hosts only. They
+ * transform n matrices or vectors per call, kept as structure-of-arrays buffers
+ * (see MTXF_BATCH in math_batch.h), so that hosts with SSE or NEON can work on
+ * four at a time. Each one computes the same operations in the same order as
+ * the function it batches, so the results are bit for bit the same as calling
+ * it n times, as long as the compiler doesn't fuse multiplies and adds
+ * (-ffp-contract=off). Without SIMD, or with MATH_BATCH_NO_SIMD defined, they're
+ * plain loops.
+ */
+#include <PR/ultratypes.h>
+
+#include "types.h"
+#include "math_batch.h"
+
+#if defined(__SSE2__) && !defined(MATH_BATCH_NO_SIMD)
+#include <emmintrin.h>
+#define MATH_BATCH_SIMD
+typedef __m128 v4f;
+#define v4f_load(p) _mm_loadu_ps(p)
+#define v4f_store(p, v) _mm_storeu_ps(p, v)
+#define v4f_set1(x) _mm_set1_ps(x)
+#define v4f_add(a, b) _mm_add_ps(a, b)
+#define v4f_mul(a, b) _mm_mul_ps(a, b)
+#elif defined(__ARM_NEON) && !defined(MATH_BATCH_NO_SIMD)
+#include <arm_neon.h>
+#define MATH_BATCH_SIMD
+typedef float32x4_t v4f;
+#define v4f_load(p) vld1q_f32(p)
+#define v4f_store(p, v) vst1q_f32(p, v)
+#define v4f_set1(x) vdupq_n_f32(x)
+#define v4f_add(a, b) vaddq_f32(a, b)
+#define v4f_mul(a, b) vmulq_f32(a, b)
+#endif
+
+/**
+ * Batched mtxf_mul: multiply each matrix in 'a' by 'b'. As in a scene graph,
+ * 'b' is usually the parent transform shared by every matrix in the batch.
+ * 'dest' may be the same buffer as 'a'.
+ */
+void mtxf_mul_batch(f32 *dest, f32 *a, Mat4 b, s32 n) {
+    s32 i;
+    s32 j;
+    s32 k = 0;
+    f32 entry0;
+    f32 entry1;
+    f32 entry2;
+
+#ifdef MATH_BATCH_SIMD
+    for (; k + 4 <= n; k += 4) {
+        for (i = 0; i < 4; i++) {
+            v4f e0 = v4f_load(&MTXF_BATCH(a, n, i, 0, k));
+            v4f e1 = v4f_load(&MTXF_BATCH(a, n, i, 1, k));
+            v4f e2 = v4f_load(&MTXF_BATCH(a, n, i, 2, k));
+
+            for (j = 0; j < 3; j++) {
+                v4f r = v4f_add(v4f_add(v4f_mul(e0, v4f_set1(b[0][j])), v4f_mul(e1, v4f_set1(b[1][j]))),
+                                v4f_mul(e2, v4f_set1(b[2][j])));
+                if (i == 3) {
+                    r = v4f_add(r, v4f_set1(b[3][j]));
+                }
+                v4f_store(&MTXF_BATCH(dest, n, i, j, k), r);
+            }
+            v4f_store(&MTXF_BATCH(dest, n, i, 3, k), v4f_set1(i == 3 ? 1.0f : 0.0f));
+        }
+    }
+#endif
+
+    for (; k < n; k++) {
+        for (i = 0; i < 4; i++) {
+            entry0 = MTXF_BATCH(a, n, i, 0, k);
+            entry1 = MTXF_BATCH(a, n, i, 1, k);
+            entry2 = MTXF_BATCH(a, n, i, 2, k);
+            for (j = 0; j < 3; j++) {
+                MTXF_BATCH(dest, n, i, j, k) = entry0 * b[0][j] + entry1 * b[1][j] + entry2 * b[2][j];
+                if (i == 3) {
+                    MTXF_BATCH(dest, n, i, j, k) += b[3][j];
+                }
+            }
+            MTXF_BATCH(dest, n, i, 3, k) = (i == 3) ? 1.0f : 0.0f;
+        }
+    }
+}
+
+/**
+ * Batched linear_mtxf_mul_vec3f: multiply each vector in 'v' by the linear
+ * part of 'm'. 'dst' may be the same buffer as 'v'.
+ */
+void linear_mtxf_mul_vec3f_batch(Mat4 m, f32 *dst, f32 *v, s32 n) {
+    s32 k = 0;
+    s32 i;
+    f32 x, y, z;
+
+#ifdef MATH_BATCH_SIMD
+    for (; k + 4 <= n; k += 4) {
+        v4f vx = v4f_load(&VEC3_BATCH(v, n, 0, k));
+        v4f vy = v4f_load(&VEC3_BATCH(v, n, 1, k));
+        v4f vz = v4f_load(&VEC3_BATCH(v, n, 2, k));
+
+        for (i = 0; i < 3; i++) {
+            v4f_store(&VEC3_BATCH(dst, n, i, k),
+                      v4f_add(v4f_add(v4f_mul(v4f_set1(m[0][i]), vx), v4f_mul(v4f_set1(m[1][i]), vy)),
+                              v4f_mul(v4f_set1(m[2][i]), vz)));
+        }
+    }
+#endif
+
+    for (; k < n; k++) {
+        x = VEC3_BATCH(v, n, 0, k);
+        y = VEC3_BATCH(v, n, 1, k);
+        z = VEC3_BATCH(v, n, 2, k);
+        for (i = 0; i < 3; i++) {
+            VEC3_BATCH(dst, n, i, k) = m[0][i] * x + m[1][i] * y + m[2][i] * z;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef MATH_BATCH_H
+#define MATH_BATCH_H
+
+#include <PR/ultratypes.h>
+
+#include "types.h"
+
+/*
+ * Element [i][j] of matrix k, in a batch of n matrices stored as 16 arrays of n
+ * floats, one for each element, and component i of vector k in a batch of n
+ * vectors stored as 3 arrays of n. Avoid n being a multiple of 1024: the arrays
+ * would then be 4 KB apart and compete for the same cache sets.
+ */
+#define MTXF_BATCH(buf, n, i, j, k) ((buf)[((i) * 4 + (j)) * (n) + (k)])
+#define VEC3_BATCH(buf, n, i, k) ((buf)[(i) * (n) + (k)])
+
+void mtxf_mul_batch(f32 *dest, f32 *a, Mat4 b, s32 n);
+void linear_mtxf_mul_vec3f_batch(Mat4 m, f32 *dst, f32 *v, s32 n);
+
+#endif // MATH_BATCH_H
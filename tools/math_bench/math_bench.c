@@ -0,0 +1,248 @@
+/*
+ * math_bench: times the batched matrix functions in math_batch.c against
+ * calling the functions they batch once per matrix, and checks that both give
+ * the same results. For each function it reports millions of matrices (or
+ * vectors) per second, the speedup, and the number of results that differ with
+ * the largest difference in ULPs. It exits with 1 if any result differs.
+ *
+ * Usage: math_bench [-n BATCH] [-r REPEAT] [-s SEED]
+ *
+ * math_bench uses the host's SSE or NEON instructions, and math_bench_scalar
+ * is the same program with the batched functions built without them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "engine/math_util.h"
+#include "math_batch.h"
+
+struct BenchResult {
+    const char *name;
+    double perCallSeconds;
+    double batchSeconds;
+    long numDiffs;
+    u32 maxDiff;
+};
+
+// Not a multiple of 1024, see MTXF_BATCH
+static s32 sBatchSize = 1000;
+static s32 sRepeat = 2000;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static f32 random_f32(f32 range) {
+    return ((f32) rand() / RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+/*
+ * Copied from src/game/object_helpers.c, which can't be built without most of
+ * the game.
+ */
+static void linear_mtxf_mul_vec3f(Mat4 m, Vec3f dst, Vec3f v) {
+    s32 i;
+    for (i = 0; i < 3; i++) {
+        dst[i] = m[0][i] * v[0] + m[1][i] * v[1] + m[2][i] * v[2];
+    }
+}
+
+/*
+ * Distance between two floats in ULPs, as integers ordered like the floats.
+ */
+static u32 ulp_diff(f32 a, f32 b) {
+    s32 ia;
+    s32 ib;
+
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+    if (ia < 0) {
+        ia = (s32) 0x80000000 - ia;
+    }
+    if (ib < 0) {
+        ib = (s32) 0x80000000 - ib;
+    }
+    return (ia > ib) ? (u32) ia - (u32) ib : (u32) ib - (u32) ia;
+}
+
+static void compare_f32(struct BenchResult *result, f32 expected, f32 actual) {
+    u32 diff = ulp_diff(expected, actual);
+
+    if (diff != 0) {
+        result->numDiffs++;
+        if (result->maxDiff < diff) {
+            result->maxDiff = diff;
+        }
+    }
+}
+
+/*
+ * A transform like the ones the scene graph makes: a rotation, a scale and a
+ * translation within a level.
+ */
+static void random_transform(Mat4 dest) {
+    Vec3f translation;
+    Vec3s rotation;
+    Vec3f scale;
+
+    vec3f_set(translation, random_f32(8192.0f), random_f32(8192.0f), random_f32(8192.0f));
+    vec3s_set(rotation, rand(), rand(), rand());
+    vec3f_set(scale, 0.5f + random_f32(0.4f), 0.5f + random_f32(0.4f), 0.5f + random_f32(0.4f));
+    mtxf_rotate_xyz_and_translate(dest, translation, rotation);
+    mtxf_scale_vec3f(dest, dest, scale);
+}
+
+static void mtxf_to_batch(f32 *dest, Mat4 *src, s32 n) {
+    s32 i, j, k;
+
+    for (k = 0; k < n; k++) {
+        for (i = 0; i < 4; i++) {
+            for (j = 0; j < 4; j++) {
+                MTXF_BATCH(dest, n, i, j, k) = src[k][i][j];
+            }
+        }
+    }
+}
+
+static void bench_mtxf_mul(struct BenchResult *result) {
+    s32 n = sBatchSize;
+    Mat4 *a = malloc(n * sizeof(Mat4));
+    Mat4 *expected = malloc(n * sizeof(Mat4));
+    f32 *aBatch = malloc(n * sizeof(Mat4));
+    f32 *destBatch = malloc(n * sizeof(Mat4));
+    Mat4 b;
+    double start;
+    s32 i, j, k, r;
+
+    random_transform(b);
+    for (k = 0; k < n; k++) {
+        random_transform(a[k]);
+    }
+    mtxf_to_batch(aBatch, a, n);
+
+    start = now();
+    for (r = 0; r < sRepeat; r++) {
+        for (k = 0; k < n; k++) {
+            mtxf_mul(expected[k], a[k], b);
+        }
+    }
+    result->perCallSeconds = now() - start;
+
+    start = now();
+    for (r = 0; r < sRepeat; r++) {
+        mtxf_mul_batch(destBatch, aBatch, b, n);
+    }
+    result->batchSeconds = now() - start;
+
+    for (k = 0; k < n; k++) {
+        for (i = 0; i < 4; i++) {
+            for (j = 0; j < 4; j++) {
+                compare_f32(result, expected[k][i][j], MTXF_BATCH(destBatch, n, i, j, k));
+            }
+        }
+    }
+
+    free(a);
+    free(expected);
+    free(aBatch);
+    free(destBatch);
+}
+
+static void bench_linear_mtxf_mul_vec3f(struct BenchResult *result) {
+    s32 n = sBatchSize;
+    Vec3f *v = malloc(n * sizeof(Vec3f));
+    Vec3f *expected = malloc(n * sizeof(Vec3f));
+    f32 *vBatch = malloc(n * sizeof(Vec3f));
+    f32 *destBatch = malloc(n * sizeof(Vec3f));
+    Mat4 m;
+    double start;
+    s32 i, k, r;
+
+    random_transform(m);
+    for (k = 0; k < n; k++) {
+        for (i = 0; i < 3; i++) {
+            v[k][i] = VEC3_BATCH(vBatch, n, i, k) = random_f32(8192.0f);
+        }
+    }
+
+    start = now();
+    for (r = 0; r < sRepeat; r++) {
+        for (k = 0; k < n; k++) {
+            linear_mtxf_mul_vec3f(m, expected[k], v[k]);
+        }
+    }
+    result->perCallSeconds = now() - start;
+
+    start = now();
+    for (r = 0; r < sRepeat; r++) {
+        linear_mtxf_mul_vec3f_batch(m, destBatch, vBatch, n);
+    }
+    result->batchSeconds = now() - start;
+
+    for (k = 0; k < n; k++) {
+        for (i = 0; i < 3; i++) {
+            compare_f32(result, expected[k][i], VEC3_BATCH(destBatch, n, i, k));
+        }
+    }
+
+    free(v);
+    free(expected);
+    free(vBatch);
+    free(destBatch);
+}
+
+int main(int argc, char *argv[]) {
+    struct BenchResult results[2];
+    unsigned int seed = 1;
+    double items;
+    s32 failed = FALSE;
+    s32 i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            sBatchSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            sRepeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [-n BATCH] [-r REPEAT] [-s SEED]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sBatchSize < 1 || sRepeat < 1) {
+        fprintf(stderr, "BATCH and REPEAT must be positive\n");
+        return 1;
+    }
+
+    srand(seed);
+    memset(results, 0, sizeof(results));
+    results[0].name = "mtxf_mul";
+    bench_mtxf_mul(&results[0]);
+    results[1].name = "linear_mtxf_mul_vec3f";
+    bench_linear_mtxf_mul_vec3f(&results[1]);
+
+    items = (double) sBatchSize * sRepeat / 1e6;
+    printf("batches of %d, %d times\n\n", sBatchSize, sRepeat);
+    printf("%-30s %10s %10s %8s %8s %8s\n", "function", "M/s", "batch M/s", "speedup", "diffs", "max diff");
+    for (i = 0; i < 2; i++) {
+        printf("%-30s %10.1f %10.1f %7.2fx %8ld %8u\n", results[i].name,
+               items / results[i].perCallSeconds, items / results[i].batchSeconds,
+               results[i].perCallSeconds / results[i].batchSeconds, results[i].numDiffs,
+               results[i].maxDiff);
+        if (results[i].numDiffs != 0) {
+            failed = TRUE;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,16 @@
+/*
+ * Stand-ins for what math_util.c links against. Only mtxf_align_terrain_triangle
+ * uses find_floor, and the benchmark doesn't call it.
+ */
+#include <PR/ultratypes.h>
+
+#include "sm64.h"
+#include "types.h"
+#include "engine/surface_collision.h"
+
+Vec3f gVec3fZero = { 0.0f, 0.0f, 0.0f };
+
+f32 find_floor(UNUSED f32 xPos, UNUSED f32 yPos, UNUSED f32 zPos, struct Surface **pfloor) {
+    *pfloor = NULL;
+    return FLOOR_LOWER_LIMIT;
+}
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Print what the main pool is being used for.
+
+Builds with MEMORY_TRACKER record every main pool block with the file and line
+that allocated it, the memory pools made from them, and a snapshot at each
+main_pool_push_state/main_pool_pop_state into gMemoryTracker (see memory.c).
+This reads it out of a dump of RDRAM taken from an emulator.
+
+Usage: memory_report.py [--word-swap] sm64.us.map rdram.bin
+
+The map file is used to find gMemoryTracker, so it has to come from the same
+build as the dump.
+"""
+import argparse
+import struct
+import sys
+
+from object_profile import Rdram, read_map
+
+# Must match memory.h
+MAX_BLOCKS = 128
+MAX_POOLS = 16
+MAX_SNAPSHOTS = 16
+BLOCK = struct.Struct(">III")
+POOL = struct.Struct(">IIIIIIII")
+SNAPSHOT = struct.Struct(">IBBBBIII")
+TRACKER_COUNTS = struct.Struct(">iiIIIIIiiI")
+TRACKER_COUNTS_OFFSET = 2 * MAX_BLOCKS * BLOCK.size + MAX_POOLS * POOL.size + MAX_SNAPSHOTS * SNAPSHOT.size
+
+SIDE_NAMES = ["left", "right"]
+
+
+def read_tag(rdram, addr):
+    if addr == 0:
+        return "(untagged)"
+    tag = bytearray()
+    while len(tag) < 256:
+        c = rdram.read(addr + len(tag), 1)[0]
+        if c == 0:
+            break
+        tag.append(c)
+    return tag.decode("ascii", "replace")
+
+
+def read_tracker(rdram, symbols):
+    if "gMemoryTracker" not in symbols:
+        sys.exit("gMemoryTracker not found in the map file (was the build made with MEMORY_TRACKER?)")
+    base = symbols["gMemoryTracker"]
+
+    counts = TRACKER_COUNTS.unpack(rdram.read(base + TRACKER_COUNTS_OFFSET, TRACKER_COUNTS.size))
+    tracker = {
+        "numBlocks": counts[0:2],
+        "usedSpace": counts[2:4],
+        "maxUsedSpace": counts[4:6],
+        "minFreeSpace": counts[6],
+        "numPools": counts[7],
+        "numSnapshots": counts[8],
+        "numUntrackedBlocks": counts[9],
+    }
+
+    tracker["blocks"] = []
+    for side in range(2):
+        blocks = []
+        for i in range(min(tracker["numBlocks"][side], MAX_BLOCKS)):
+            addr = base + (side * MAX_BLOCKS + i) * BLOCK.size
+            tag, block_addr, size = BLOCK.unpack(rdram.read(addr, BLOCK.size))
+            blocks.append((read_tag(rdram, tag), block_addr, size))
+        tracker["blocks"].append(blocks)
+
+    tracker["pools"] = []
+    for i in range(min(tracker["numPools"], MAX_POOLS)):
+        addr = base + 2 * MAX_BLOCKS * BLOCK.size + i * POOL.size
+        fields = POOL.unpack(rdram.read(addr, POOL.size))
+        tracker["pools"].append((read_tag(rdram, fields[0]),) + fields[1:])
+
+    # Oldest first
+    tracker["snapshots"] = []
+    first = max(0, tracker["numSnapshots"] - MAX_SNAPSHOTS)
+    for i in range(first, tracker["numSnapshots"]):
+        addr = base + 2 * MAX_BLOCKS * BLOCK.size + MAX_POOLS * POOL.size + (i % MAX_SNAPSHOTS) * SNAPSHOT.size
+        fields = SNAPSHOT.unpack(rdram.read(addr, SNAPSHOT.size))
+        tracker["snapshots"].append((read_tag(rdram, fields[0]),) + fields[1:])
+
+    return tracker
+
+
+def print_report(tracker, f):
+    f.write("Main pool\n")
+    for side in range(2):
+        f.write(
+            "  {:<5} {:8} bytes used, {:8} at most\n".format(
+                SIDE_NAMES[side], tracker["usedSpace"][side], tracker["maxUsedSpace"][side]
+            )
+        )
+    f.write("  least free space: {} bytes\n".format(tracker["minFreeSpace"]))
+    if tracker["numUntrackedBlocks"] != 0:
+        f.write("  {} blocks were not tracked, the block table was full\n".format(tracker["numUntrackedBlocks"]))
+
+    for side in range(2):
+        f.write("\nLive blocks on the {} side, oldest first\n".format(SIDE_NAMES[side]))
+        for tag, addr, size in tracker["blocks"][side]:
+            f.write("  0x{:08X} {:8}  {}\n".format(addr, size, tag))
+
+    f.write("\nPools\n")
+    f.write("  {:<40} {:>5} {:>8} {:>8} {:>8} {:>6} {:>8}\n".format(
+        "created at", "inits", "size", "used", "max used", "frees", "largest"))
+    for tag, pool, num_inits, total, used, max_used, num_free, largest in tracker["pools"]:
+        f.write(
+            "  {:<40} {:5} {:8} {:8} {:8} {:6} {:8}{}\n".format(
+                tag, num_inits, total, used, max_used, num_free, largest, "" if pool != 0 else "  (freed)"
+            )
+        )
+
+    f.write("\nLast pushes and pops of the main pool state\n")
+    f.write("  {:<40} {:>4} {:>5} {:>8} {:>8} {:>8}\n".format("at", "", "depth", "left", "right", "free"))
+    for tag, is_pop, depth, num_blocks_l, num_blocks_r, used_l, used_r, free in tracker["snapshots"]:
+        f.write(
+            "  {:<40} {:>4} {:5} {:8} {:8} {:8}\n".format(
+                tag, "pop" if is_pop else "push", depth, used_l, used_r, free
+            )
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Print the main pool usage recorded by the memory tracker.")
+    parser.add_argument("map", help="linker map file of the build")
+    parser.add_argument("rdram", help="RDRAM dump (big-endian unless --word-swap is given)")
+    parser.add_argument(
+        "--word-swap",
+        action="store_true",
+        help="the dump stores each 32-bit word little-endian, as Project64 does",
+    )
+    args = parser.parse_args()
+
+    symbols = read_map(args.map)
+    rdram = Rdram(args.rdram, args.word_swap)
+    print_report(read_tracker(rdram, symbols), sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
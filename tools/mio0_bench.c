@@ -0,0 +1,172 @@
+/*
+ * mio0_bench: times the MIO0 encoder in sm64tools/libmio0.c on a set of files,
+ * and checks that what it writes decodes back to the input.
+ *
+ * Usage: mio0_bench [-s] [-n REPEAT] FILE...
+ *
+ * With -s, the optimal parse (mio0 -s) is timed as well. If FILE has a .bin
+ * extension and a .mio0 file with the same name exists next to it, as the
+ * Makefile leaves them in the build directory, the encoder's output is also
+ * compared with that file. `make mio0-bench` runs this on every .mio0 input of
+ * the last build.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sm64tools/libmio0.h"
+
+struct EncodeStats {
+    double seconds;
+    unsigned long inSize;
+    unsigned long outSize;
+};
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned char *read_file(const char *path, long *size) {
+    FILE *f = fopen(path, "rb");
+    unsigned char *buf;
+
+    if (f == NULL) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(*size + 1);
+    if (fread(buf, 1, *size, f) != (size_t) *size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+// Encode in repeat times, and check the result. Returns 0 if it didn't decode back to in.
+static int bench_encoder(int (*encode)(const unsigned char *, unsigned int, unsigned char *),
+                         const unsigned char *in, long size, int repeat, unsigned char *out,
+                         unsigned char *decoded, struct EncodeStats *stats, int *outSize) {
+    double start = now();
+    int i;
+
+    for (i = 0; i < repeat; i++) {
+        *outSize = encode(in, size, out);
+    }
+
+    stats->seconds += now() - start;
+    stats->inSize += (unsigned long) size * repeat;
+    stats->outSize += (unsigned long) *outSize * repeat;
+
+    return mio0_decode(out, decoded, NULL) == size && memcmp(decoded, in, size) == 0;
+}
+
+static void print_stats(const char *name, const struct EncodeStats *stats) {
+    printf("%-8s %10.2f MB/s  %6.2f%% of input size\n", name,
+           stats->inSize / stats->seconds / 1e6, stats->outSize * 100.0 / stats->inSize);
+}
+
+int main(int argc, char *argv[]) {
+    struct EncodeStats greedy = { 0 };
+    struct EncodeStats optimal = { 0 };
+    int withOptimal = 0;
+    int repeat = 1;
+    int numFiles = 0;
+    int numCompared = 0;
+    int failed = 0;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-s") == 0) {
+            withOptimal = 1;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            break;
+        }
+    }
+
+    if (i == argc || repeat < 1) {
+        fprintf(stderr, "Usage: %s [-s] [-n REPEAT] FILE...\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-40s %8s %8s %8s\n", "file", "size", "greedy", withOptimal ? "optimal" : "");
+
+    for (; i < argc; i++) {
+        const char *path = argv[i];
+        size_t pathLen = strlen(path);
+        unsigned char *in, *out, *decoded, *expected;
+        long size, expectedSize;
+        int outSize;
+        char *expectedPath;
+
+        in = read_file(path, &size);
+        if (in == NULL || size == 0) {
+            fprintf(stderr, "%s: can't read file\n", path);
+            free(in);
+            failed = 1;
+            continue;
+        }
+
+        // worst case: every byte uncompressed, and padding before the compressed data
+        out = malloc(MIO0_HEADER_LENGTH + (size + 7) / 8 + 3 + size);
+        decoded = malloc(size);
+
+        if (!bench_encoder(mio0_encode, in, size, repeat, out, decoded, &greedy, &outSize)) {
+            fprintf(stderr, "%s: greedy output doesn't decode to the input\n", path);
+            failed = 1;
+        }
+        printf("%-40s %8ld %8d", path, size, outSize);
+
+        // compare with the file the build made
+        if (pathLen > 4 && strcmp(path + pathLen - 4, ".bin") == 0) {
+            expectedPath = malloc(pathLen + 2);
+            sprintf(expectedPath, "%.*s.mio0", (int) (pathLen - 4), path);
+            expected = read_file(expectedPath, &expectedSize);
+            if (expected != NULL) {
+                if (expectedSize != outSize || memcmp(expected, out, outSize) != 0) {
+                    fprintf(stderr, "%s: greedy output differs from %s\n", path, expectedPath);
+                    failed = 1;
+                }
+                numCompared++;
+                free(expected);
+            }
+            free(expectedPath);
+        }
+
+        if (withOptimal) {
+            if (!bench_encoder(mio0_encode_optimal, in, size, repeat, out, decoded, &optimal, &outSize)) {
+                fprintf(stderr, "%s: optimal output doesn't decode to the input\n", path);
+                failed = 1;
+            }
+            printf(" %8d", outSize);
+        }
+        printf("\n");
+
+        numFiles++;
+        free(in);
+        free(out);
+        free(decoded);
+    }
+
+    if (numFiles == 0) {
+        return 1;
+    }
+
+    printf("\n%d files, %lu bytes, %d compared with existing .mio0 files\n", numFiles,
+           greedy.inSize / repeat, numCompared);
+    print_stats("greedy", &greedy);
+    if (withOptimal) {
+        print_stats("optimal", &optimal);
+    }
+
+    return failed;
+}
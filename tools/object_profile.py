@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""Convert the object profiler's ring buffer into a Chrome trace.
+
+Builds with OBJECT_PROFILER record the update_objects phases, object lists and
+behaviors of the last frames into gObjectProfilerFrames (see profiler.c). This
+reads the buffer out of a dump of RDRAM taken from an emulator, and writes it
+as JSON that chrome://tracing or https://ui.perfetto.dev can open.
+
+Usage: object_profile.py [-o trace.json] [--word-swap] sm64.us.map rdram.bin
+
+With --top N, it instead prints the N behaviors that have taken the most time
+according to the behavior profiler (BEHAVIOR_PROFILER, gBehaviorCosts in
+behavior_script.c), which totals them across the frames since the level was
+loaded.
+
+The map file is used to find the buffer and to name behaviors, so it has to
+come from the same build as the dump.
+"""
+import argparse
+import json
+import re
+import struct
+import sys
+
+# Must match profiler.h
+NUM_FRAMES = 16
+NUM_BEHAVIORS = 48
+NUM_PHASES = 6
+NUM_OBJ_LISTS = 13
+FRAME_HEADER = struct.Struct(
+    ">Q{}I{}I{}I{}HhI".format(NUM_PHASES + 1, NUM_OBJ_LISTS, NUM_OBJ_LISTS, NUM_OBJ_LISTS)
+)
+BEHAVIOR_TIME = struct.Struct(">IIHh")
+FRAME_SIZE = (FRAME_HEADER.size + NUM_BEHAVIORS * BEHAVIOR_TIME.size + 7) & ~7
+
+# Must match behavior_script.h
+BEHAVIOR_COST_CAPACITY = 512
+BEHAVIOR_COST = struct.Struct(">QIII4x")
+
+PHASE_NAMES = [
+    "clear dynamic surfaces",
+    "update terrain objects",
+    "detect object collisions",
+    "update other objects",
+    "unload deactivated objects",
+    "update mario platform",
+]
+
+LIST_NAMES = [
+    "OBJ_LIST_PLAYER",
+    "OBJ_LIST_UNUSED_1",
+    "OBJ_LIST_DESTRUCTIVE",
+    "OBJ_LIST_UNUSED_3",
+    "OBJ_LIST_GENACTOR",
+    "OBJ_LIST_PUSHABLE",
+    "OBJ_LIST_LEVEL",
+    "OBJ_LIST_UNUSED_7",
+    "OBJ_LIST_DEFAULT",
+    "OBJ_LIST_SURFACE",
+    "OBJ_LIST_POLELIKE",
+    "OBJ_LIST_SPAWNER",
+    "OBJ_LIST_UNIMPORTANT",
+]
+
+BEHAVIOR_SEGMENT = 0x13
+
+TID_PHASES = 1
+TID_LISTS = 2
+TID_BEHAVIORS = 3
+
+
+def read_map(path):
+    symbols = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_][A-Za-z0-9_]*)\s*$", line)
+            if m:
+                symbols[m.group(2)] = int(m.group(1), 16)
+    return symbols
+
+
+class Rdram:
+    def __init__(self, path, word_swap):
+        with open(path, "rb") as f:
+            data = f.read()
+        if word_swap:
+            data = b"".join(data[i : i + 4][::-1] for i in range(0, len(data) - 3, 4))
+        self.data = data
+
+    def read(self, addr, size):
+        offset = addr & 0x1FFFFFFF
+        if offset + size > len(self.data):
+            sys.exit("Address 0x{:08X} is outside the RAM dump".format(addr))
+        return self.data[offset : offset + size]
+
+    def u32(self, addr):
+        return struct.unpack(">I", self.read(addr, 4))[0]
+
+    def s16(self, addr):
+        return struct.unpack(">h", self.read(addr, 2))[0]
+
+
+def find_symbol(symbols, name):
+    if name not in symbols:
+        sys.exit("{} not found in the map file (was the build made with OBJECT_PROFILER?)".format(name))
+    return symbols[name]
+
+
+def read_frames(rdram, symbols):
+    base = find_symbol(symbols, "gObjectProfilerFrames")
+    current = rdram.s16(find_symbol(symbols, "gObjectProfilerFrameIndex"))
+
+    frames = []
+    # Oldest first. The current frame is complete unless the dump was taken
+    # during update_objects, in which case its end time is still 0.
+    for i in range(1, NUM_FRAMES + 1):
+        addr = base + ((current + i) % NUM_FRAMES) * FRAME_SIZE
+        raw = rdram.read(addr, FRAME_SIZE)
+        header = FRAME_HEADER.unpack_from(raw)
+
+        pos = 0
+        frame = {"start": header[pos]}
+        pos += 1
+        frame["phases"] = header[pos : pos + NUM_PHASES + 1]
+        pos += NUM_PHASES + 1
+        frame["listStarts"] = header[pos : pos + NUM_OBJ_LISTS]
+        pos += NUM_OBJ_LISTS
+        frame["listTimes"] = header[pos : pos + NUM_OBJ_LISTS]
+        pos += NUM_OBJ_LISTS
+        frame["listCounts"] = header[pos : pos + NUM_OBJ_LISTS]
+        pos += NUM_OBJ_LISTS
+        num_behaviors = header[pos]
+        frame["otherTime"] = header[pos + 1]
+
+        frame["behaviors"] = []
+        for j in range(max(0, min(num_behaviors, NUM_BEHAVIORS))):
+            behavior, time, count, list_index = BEHAVIOR_TIME.unpack_from(
+                raw, FRAME_HEADER.size + j * BEHAVIOR_TIME.size
+            )
+            frame["behaviors"].append((behavior, time, count, list_index))
+
+        if frame["start"] != 0 and frame["phases"][NUM_PHASES] != 0:
+            frames.append(frame)
+
+    return frames
+
+
+def behavior_namer(rdram, symbols):
+    names = {}
+    for name, addr in symbols.items():
+        if (addr >> 24) == BEHAVIOR_SEGMENT and name.startswith("bhv"):
+            names[addr] = name
+
+    segment_table = symbols.get("sSegmentTable")
+    segment_base = rdram.u32(segment_table + 4 * BEHAVIOR_SEGMENT) if segment_table is not None else None
+
+    def name(addr):
+        if segment_base is not None:
+            segmented = (BEHAVIOR_SEGMENT << 24) + ((addr & 0x1FFFFFFF) - segment_base)
+            if segmented in names:
+                return names[segmented]
+        return "behavior 0x{:08X}".format(addr)
+
+    return name
+
+
+def read_behavior_costs(rdram, symbols):
+    base = find_symbol(symbols, "gBehaviorCosts")
+    raw = rdram.read(base, BEHAVIOR_COST_CAPACITY * BEHAVIOR_COST.size)
+    costs = []
+    for i in range(BEHAVIOR_COST_CAPACITY):
+        time, behavior, updates, commands = BEHAVIOR_COST.unpack_from(raw, i * BEHAVIOR_COST.size)
+        if behavior != 0:
+            costs.append((time, behavior, updates, commands))
+    return costs
+
+
+def print_behavior_costs(costs, count, behavior_name, clock_rate, f):
+    costs = sorted(costs, reverse=True)
+    total = sum(cost[0] for cost in costs)
+    if total == 0:
+        sys.exit("The behavior profiler hasn't recorded anything")
+
+    f.write(
+        "{:<40} {:>10} {:>7} {:>10} {:>13} {:>13}\n".format(
+            "behavior", "time (ms)", "share", "updates", "us/update", "cmds/update"
+        )
+    )
+    for time, behavior, updates, commands in costs[:count]:
+        f.write(
+            "{:<40} {:>10.2f} {:>6.1f}% {:>10} {:>13.2f} {:>13.2f}\n".format(
+                behavior_name(behavior),
+                time * 1000.0 / clock_rate,
+                time * 100.0 / total,
+                updates,
+                time * 1000000.0 / clock_rate / updates,
+                commands / updates,
+            )
+        )
+    f.write("{} behaviors, {:.2f} ms in total\n".format(len(costs), total * 1000.0 / clock_rate))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert the object profiler's ring buffer in an RDRAM dump into a Chrome trace."
+    )
+    parser.add_argument("map", help="linker map file of the build")
+    parser.add_argument("rdram", help="RDRAM dump (big-endian unless --word-swap is given)")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    parser.add_argument(
+        "--word-swap",
+        action="store_true",
+        help="the dump stores each 32-bit word little-endian, as Project64 does",
+    )
+    parser.add_argument(
+        "--clock-rate", type=int, default=46875000, help="CPU count rate in Hz (default: 46875000)"
+    )
+    parser.add_argument(
+        "--top",
+        type=int,
+        metavar="N",
+        help="print the N most expensive behaviors from the behavior profiler instead",
+    )
+    args = parser.parse_args()
+
+    symbols = read_map(args.map)
+    rdram = Rdram(args.rdram, args.word_swap)
+
+    if args.top is not None:
+        costs = read_behavior_costs(rdram, symbols)
+        behavior_name = behavior_namer(rdram, symbols)
+        if args.output:
+            with open(args.output, "w") as f:
+                print_behavior_costs(costs, args.top, behavior_name, args.clock_rate, f)
+        else:
+            print_behavior_costs(costs, args.top, behavior_name, args.clock_rate, sys.stdout)
+        return
+
+    frames = read_frames(rdram, symbols)
+    behavior_name = behavior_namer(rdram, symbols)
+
+    if not frames:
+        sys.exit("No complete frames in the profiler buffer")
+
+    def us(cycles):
+        return cycles * 1000000.0 / args.clock_rate
+
+    events = []
+    for tid, name in [
+        (TID_PHASES, "update_objects"),
+        (TID_LISTS, "object lists"),
+        (TID_BEHAVIORS, "behaviors"),
+    ]:
+        events.append({"ph": "M", "name": "thread_name", "pid": 1, "tid": tid, "args": {"name": name}})
+
+    base = frames[0]["start"]
+    for frame_num, frame in enumerate(frames):
+        start = frame["start"] - base
+
+        events.append(
+            {
+                "name": "update_objects",
+                "cat": "frame",
+                "ph": "X",
+                "pid": 1,
+                "tid": TID_PHASES,
+                "ts": us(start),
+                "dur": us(frame["phases"][NUM_PHASES]),
+                "args": {"frame": frame_num},
+            }
+        )
+
+        for i in range(NUM_PHASES):
+            events.append(
+                {
+                    "name": PHASE_NAMES[i],
+                    "cat": "phase",
+                    "ph": "X",
+                    "pid": 1,
+                    "tid": TID_PHASES,
+                    "ts": us(start + frame["phases"][i]),
+                    "dur": us(frame["phases"][i + 1] - frame["phases"][i]),
+                }
+            )
+
+        # Behavior times are totals for the frame, so they're laid out one after
+        # another inside the list they were updated in.
+        list_cursors = {}
+        for i in range(NUM_OBJ_LISTS):
+            if frame["listCounts"][i] == 0 and frame["listTimes"][i] == 0:
+                continue
+            list_cursors[i] = start + frame["listStarts"][i]
+            events.append(
+                {
+                    "name": LIST_NAMES[i],
+                    "cat": "list",
+                    "ph": "X",
+                    "pid": 1,
+                    "tid": TID_LISTS,
+                    "ts": us(list_cursors[i]),
+                    "dur": us(frame["listTimes"][i]),
+                    "args": {"objects": frame["listCounts"][i]},
+                }
+            )
+
+        for behavior, time, count, list_index in frame["behaviors"]:
+            cursor = list_cursors.get(list_index, start)
+            events.append(
+                {
+                    "name": behavior_name(behavior),
+                    "cat": "behavior",
+                    "ph": "X",
+                    "pid": 1,
+                    "tid": TID_BEHAVIORS,
+                    "ts": us(cursor),
+                    "dur": us(time),
+                    "args": {"objects": count, "list": LIST_NAMES[list_index]},
+                }
+            )
+            list_cursors[list_index] = cursor + time
+
+        if frame["otherTime"] != 0:
+            events.append(
+                {
+                    "name": "other behaviors",
+                    "cat": "behavior",
+                    "ph": "X",
+                    "pid": 1,
+                    "tid": TID_BEHAVIORS,
+                    "ts": us(start + frame["phases"][NUM_PHASES]),
+                    "dur": us(frame["otherTime"]),
+                }
+            )
+
+    trace = {"traceEvents": events, "displayTimeUnit": "ms"}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
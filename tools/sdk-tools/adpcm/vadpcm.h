@@ -111,6 +111,7 @@ void vdecodeframe(FILE *ifile, s32 *outp, s32 order, s32 ***coefTable);
 
 // vencode.c
 void vencodeframe(FILE *ofile, s16 *inBuffer, s32 *state, s32 ***coefTable, s32 order, s32 npredictors, s32 nsam);
+void vencodeframe_search(FILE *ofile, s16 *inBuffer, s32 *state, s32 ***coefTable, s32 order, s32 npredictors, s32 nsam);
 
 // util.c
 u32 readbits(u32 nbits, FILE *ifile);
@@ -3,25 +3,175 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <getopt.h>
+#ifndef __sgi
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
 #include "vadpcm.h"
 
+/*
+ * The IRIX build is kept the same as the original program, so that it still
+ * matches the original binary. The native build also has batch mode (-b, -j),
+ * the predictor and scale search (-e) and the SNR report (-r), and what is
+ * main below is encode_file there, called for each file to encode.
+ */
+#ifdef __sgi
 static char usage[] = "[-t -l min_loop_length] -c codebook aifcfile compressedfile";
+#else
+static char usage[] = "[-t -e -r -l min_loop_length] -c codebook aifcfile compressedfile\n"
+                      "    or [-t -e -r -l min_loop_length -j threads] -b listfile";
+
+typedef struct
+{
+    s32 nFrames;
+    f64 signal; // sum of the squared input samples
+    f64 noise;  // sum of the squared errors of the decoded samples
+    f64 seconds;
+} EncodeStats;
+
+typedef struct
+{
+    char *codebook;
+    char *input;
+    char *output;
+    EncodeStats stats;
+} BatchEntry;
+
+static const char *sProgname;
+static s32 sMinLoopLength;
+static s32 sTruncate;
+static s32 sSearch;
+static BatchEntry *sEntries;
+static s32 sNumEntries;
+static s32 sNextEntry;
+static pthread_mutex_t sEntryLock = PTHREAD_MUTEX_INITIALIZER;
+
+static f64 cpu_seconds(void)
+{
+    struct timespec ts;
+
+    // Per thread, so that the files encoded at the same time are timed separately
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static f64 wall_seconds(void)
+{
+    struct timespec ts;
 
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static f64 snr_db(EncodeStats *stats)
+{
+    if (stats->noise == 0.0)
+    {
+        return HUGE_VAL;
+    }
+    return 10.0 * log10(stats->signal / stats->noise);
+}
+
+static void load_codebook(const char *filename, s32 ****coefTable, s32 *order, s32 *npredictors)
+{
+    FILE *fhandle;
+
+    if ((fhandle = fopen(filename, "r")) == NULL)
+    {
+        fprintf(stderr, "Codebook file %s could not be opened\n", filename);
+        exit(1);
+    }
+    if (readcodebook(fhandle, coefTable, order, npredictors) != 0)
+    {
+        fprintf(stderr, "Error reading codebook\n");
+        exit(1);
+    }
+    fclose(fhandle);
+}
+
+static void free_codebook(s32 ***coefTable, s32 npredictors)
+{
+    s32 i;
+    s32 j;
+
+    for (i = 0; i < npredictors; i++)
+    {
+        for (j = 0; j < 8; j++)
+        {
+            free(coefTable[i][j]);
+        }
+        free(coefTable[i]);
+    }
+    free(coefTable);
+}
+
+/**
+ * Encode a frame, and add how far the decoded samples are from the input to
+ * the stats.
+ */
+static void encode_frame(FILE *ofile, s16 *inBuffer, s32 *state, s32 ***coefTable, s32 order, s32 npredictors,
+                         s32 nsam, s32 search, EncodeStats *stats)
+{
+    s32 i;
+    s32 out;
+
+    if (search)
+    {
+        vencodeframe_search(ofile, inBuffer, state, coefTable, order, npredictors, nsam);
+    }
+    else
+    {
+        vencodeframe(ofile, inBuffer, state, coefTable, order, npredictors, nsam);
+    }
+
+    stats->nFrames++;
+    for (i = 0; i < nsam; i++)
+    {
+        out = clip(state[i], -0x8000, 0x7fff);
+        stats->signal += (f64) inBuffer[i] * inBuffer[i];
+        stats->noise += (f64) (inBuffer[i] - out) * (inBuffer[i] - out);
+    }
+}
+
+// Frames are encoded through encode_frame, for -e and -r
+#define vencodeframe(ofile, inBuffer, state, coefTable, order, npredictors, nsam) \
+    encode_frame(ofile, inBuffer, state, coefTable, order, npredictors, nsam, search, stats)
+#endif
+
+#ifdef __sgi
 int main(int argc, char **argv)
+#else
+/**
+ * Encode the AIFF file argv[1] into argv[2]. argv[0] is the program name for
+ * error messages.
+ */
+static int encode_file(char **argv, s32 ***coefTable, s32 order, s32 npredictors, s32 minLoopLength,
+                       s32 truncate, s32 search, EncodeStats *stats)
+#endif
 {
+#ifdef __sgi
     s32 c;
+#endif
     char *progname = argv[0];
     s16 nloops = 0;
     s16 numMarkers;
     s16 *inBuffer;
     s16 ts;
+#ifdef __sgi
     s32 minLoopLength = 800;
     s32 ***coefTable = NULL;
+#endif
     s32 *state;
+#ifdef __sgi
     s32 order;
     s32 npredictors;
+#endif
     s32 done = 0;
+#ifdef __sgi
     s32 truncate = 0;
+#endif
     s32 num;
     s32 tableSize;
     s32 nsam;
@@ -58,13 +208,15 @@ int main(int argc, char **argv)
     CodeChunk cChunk;
 #ifdef __sgi
     char filename[1024];
-#else
-    const char *filename;
-#endif
     FILE *fhandle;
+#endif
     FILE *ifile;
     FILE *ofile;
+#ifndef __sgi
+    f64 startTime;
+#endif
 
+#ifdef __sgi
     if (argc < 2)
     {
         fprintf(stderr, "%s %s\n", progname, usage);
@@ -76,12 +228,7 @@ int main(int argc, char **argv)
         switch (c)
         {
         case 'c':
-#ifdef __sgi
             if (sscanf(optarg, "%s", filename) == 1)
-#else
-            // Allow filenames with spaces
-            filename = optarg;
-#endif
             {
                 if ((fhandle = fopen(filename, "r")) == NULL)
                 {
@@ -116,6 +263,9 @@ int main(int argc, char **argv)
     }
 
     argv += optind - 1;
+#else
+    startTime = cpu_seconds();
+#endif
     if ((ifile = fopen(argv[1], MODE_READ)) == NULL)
     {
         fprintf(stderr, "%s: input file [%s] could not be opened.\n", progname, argv[1]);
@@ -523,5 +673,268 @@ int main(int argc, char **argv)
     fwrite(&CommChunk, sizeof(CommonChunk), 1, ofile);
     fclose(ifile);
     fclose(ofile);
+#ifndef __sgi
+    free(inBuffer);
+    free(state);
+    if (loops != NULL)
+    {
+        free(loops);
+        free(aloops);
+    }
+    stats->seconds = cpu_seconds() - startTime;
+#endif
+    return 0;
+}
+
+#ifndef __sgi
+#undef vencodeframe
+
+static void encode_entry(BatchEntry *entry)
+{
+    s32 ***coefTable;
+    s32 order;
+    s32 npredictors;
+    char *args[3];
+
+    args[0] = (char *) sProgname;
+    args[1] = entry->input;
+    args[2] = entry->output;
+    load_codebook(entry->codebook, &coefTable, &order, &npredictors);
+    encode_file(args, coefTable, order, npredictors, sMinLoopLength, sTruncate, sSearch, &entry->stats);
+    free_codebook(coefTable, npredictors);
+}
+
+/**
+ * Encode entries until there are none left. Entries are taken one at a time,
+ * so that a thread given a long sample doesn't hold up the rest.
+ */
+static void *batch_worker(void *arg)
+{
+    s32 i;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&sEntryLock);
+        i = sNextEntry++;
+        pthread_mutex_unlock(&sEntryLock);
+        if (i >= sNumEntries)
+        {
+            break;
+        }
+        encode_entry(&sEntries[i]);
+    }
+    return arg;
+}
+
+static void run_batch(s32 numThreads)
+{
+    pthread_t *threads;
+    s32 i;
+
+    if (numThreads > sNumEntries)
+    {
+        numThreads = sNumEntries;
+    }
+    threads = malloc((numThreads > 0 ? numThreads : 1) * sizeof(pthread_t));
+    for (i = 1; i < numThreads; i++)
+    {
+        if (pthread_create(&threads[i], NULL, batch_worker, NULL) != 0)
+        {
+            break;
+        }
+    }
+    // Threads that couldn't be started just leave more for the rest
+    numThreads = i;
+    batch_worker(NULL);
+    for (i = 1; i < numThreads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+/**
+ * Read a list of samples to encode, one per line as "codebook aifffile
+ * compressedfile". The fields are separated by tabs if there are any, so that
+ * paths can have spaces, and by spaces otherwise.
+ */
+static void read_list(const char *filename)
+{
+    char line[3072];
+    char *fields[3];
+    const char *sep;
+    s32 lineNum;
+    s32 capacity;
+    FILE *listFile;
+
+    if ((listFile = fopen(filename, "r")) == NULL)
+    {
+        fprintf(stderr, "%s: list file [%s] could not be opened.\n", sProgname, filename);
+        exit(1);
+    }
+
+    capacity = 64;
+    sEntries = malloc(capacity * sizeof(BatchEntry));
+    sNumEntries = 0;
+    lineNum = 0;
+    while (fgets(line, sizeof(line), listFile) != NULL)
+    {
+        lineNum++;
+        line[strcspn(line, "\r\n")] = '\0';
+        sep = strchr(line, '\t') != NULL ? "\t" : " ";
+        fields[0] = strtok(line, sep);
+        if (fields[0] == NULL)
+        {
+            continue;
+        }
+        fields[1] = strtok(NULL, sep);
+        fields[2] = strtok(NULL, sep);
+        if (fields[2] == NULL || strtok(NULL, sep) != NULL)
+        {
+            fprintf(stderr, "%s: line %d of [%s] should be \"codebook aifffile compressedfile\"\n",
+                    sProgname, lineNum, filename);
+            exit(1);
+        }
+
+        if (sNumEntries == capacity)
+        {
+            capacity *= 2;
+            sEntries = realloc(sEntries, capacity * sizeof(BatchEntry));
+        }
+        memset(&sEntries[sNumEntries], 0, sizeof(BatchEntry));
+        sEntries[sNumEntries].codebook = strdup(fields[0]);
+        sEntries[sNumEntries].input = strdup(fields[1]);
+        sEntries[sNumEntries].output = strdup(fields[2]);
+        sNumEntries++;
+    }
+    fclose(listFile);
+}
+
+static void print_stats(const char *name, EncodeStats *stats)
+{
+    printf("%8.2f dB %9.3f s %8d  %s\n", snr_db(stats), stats->seconds, stats->nFrames, name);
+}
+
+int main(int argc, char **argv)
+{
+    s32 c;
+    char *progname = argv[0];
+    s32 ***coefTable = NULL;
+    s32 order;
+    s32 npredictors;
+    s32 report = 0;
+    s32 numThreads = 0;
+    s32 i;
+    f64 startTime;
+    char *listName = NULL;
+    EncodeStats stats;
+    EncodeStats total;
+    const char *filename;
+
+    sProgname = progname;
+    sMinLoopLength = 800;
+    sTruncate = 0;
+    sSearch = 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "%s %s\n", progname, usage);
+        exit(1);
+    }
+
+    while ((c = getopt(argc, argv, "tc:l:erb:j:")) != -1)
+    {
+        switch (c)
+        {
+        case 'c':
+            // Allow filenames with spaces
+            filename = optarg;
+            load_codebook(filename, &coefTable, &order, &npredictors);
+            break;
+
+        case 't':
+            sTruncate = 1;
+            break;
+
+        case 'l':
+            sscanf(optarg, "%d", &sMinLoopLength);
+            break;
+
+        case 'e':
+            // Slower and usually closer to the input, but not how the game's samples were
+            // encoded, and tools/aifc_decode can't find inputs that encode to its frames
+            sSearch = 1;
+            break;
+
+        case 'r':
+            report = 1;
+            break;
+
+        case 'b':
+            listName = optarg;
+            break;
+
+        case 'j':
+            // 0, the default, uses all processors. The output is the same for any number of threads.
+            sscanf(optarg, "%d", &numThreads);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    argv += optind - 1;
+    memset(&total, 0, sizeof(total));
+
+    if (listName != NULL)
+    {
+        if (coefTable != NULL)
+        {
+            fprintf(stderr, "%s: the codebooks for [-b] are given in the list, not with [-c]\n", progname);
+            exit(1);
+        }
+        read_list(listName);
+        if (numThreads <= 0)
+        {
+            numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        if (numThreads <= 0)
+        {
+            numThreads = 1;
+        }
+
+        startTime = wall_seconds();
+        run_batch(numThreads);
+        if (report)
+        {
+            for (i = 0; i < sNumEntries; i++)
+            {
+                print_stats(sEntries[i].output, &sEntries[i].stats);
+                total.nFrames += sEntries[i].stats.nFrames;
+                total.signal += sEntries[i].stats.signal;
+                total.noise += sEntries[i].stats.noise;
+                total.seconds += sEntries[i].stats.seconds;
+            }
+            print_stats("total", &total);
+            printf("%d files in %.3f s with %d threads\n", sNumEntries, wall_seconds() - startTime, numThreads);
+        }
+        return 0;
+    }
+
+    if (coefTable == 0)
+    {
+        fprintf(stderr, "You should specify a coefficient codebook with the [-c] option\n");
+        exit(1);
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    encode_file(argv, coefTable, order, npredictors, sMinLoopLength, sTruncate, sSearch, &stats);
+    if (report)
+    {
+        print_stats(argv[2], &stats);
+    }
     return 0;
 }
+#endif
+
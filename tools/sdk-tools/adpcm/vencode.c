@@ -234,3 +234,121 @@ out:;
         fwrite(&c, 1, 1, ofile);
     }
 }
+
+#ifndef __sgi
+// Not in the IRIX build, which is kept the same as the original program
+/**
+ * Quantize a frame with the given predictor and scale, the same way as the
+ * last step of vencodeframe, starting from the decoded samples in prevState.
+ * Writes the 4-bit values to ix and the decoded samples to state, and returns
+ * the squared error of the decoded samples, clamped as the decoder would.
+ */
+static s64 quantize_frame(s16 *inBuffer, s32 *prevState, s32 **coefs, s32 order, s32 scale, s16 *ix, s32 *state)
+{
+    s32 prediction[16];
+    s32 inVector[16];
+    s32 llevel;
+    s32 ulevel;
+    s32 i;
+    s32 j;
+    s32 out;
+    s64 err;
+    f32 se;
+
+    llevel = -8;
+    ulevel = -llevel - 1;
+
+    for (i = 0; i < order; i++)
+    {
+        inVector[i] = prevState[16 - order + i];
+    }
+
+    for (j = 0; j < 2; j++)
+    {
+        if (j == 1)
+        {
+            for (i = 0; i < order; i++)
+            {
+                inVector[i] = state[8 - order + i];
+            }
+        }
+
+        for (i = 0; i < 8; i++)
+        {
+            prediction[j * 8 + i] = inner_product(order + i, coefs[i], inVector);
+            se = (f32) inBuffer[j * 8 + i] - (f32) prediction[j * 8 + i];
+            ix[j * 8 + i] = clip(qsample(se, 1 << scale), llevel, ulevel);
+            inVector[i + order] = ix[j * 8 + i] * (1 << scale);
+            state[j * 8 + i] = prediction[j * 8 + i] + inVector[i + order];
+        }
+    }
+
+    err = 0;
+    for (i = 0; i < 16; i++)
+    {
+        out = clip(state[i], -0x8000, 0x7fff);
+        err += (s64) (inBuffer[i] - out) * (inBuffer[i] - out);
+    }
+    return err;
+}
+
+/**
+ * Like vencodeframe, but tries every predictor with every scale and keeps
+ * the one whose decoded frame is closest to the input, instead of picking the
+ * predictor before quantizing and the smallest scale that (nearly) fits.
+ * This is about npredictors * 13 times as much work per frame.
+ */
+void vencodeframe_search(FILE *ofile, s16 *inBuffer, s32 *state, s32 ***coefTable, s32 order, s32 npredictors, s32 nsam)
+{
+    s16 ix[16];
+    s32 saveState[16];
+    s32 trialState[16];
+    s32 optimalp;
+    s32 scale;
+    s32 bestScale;
+    s32 i;
+    s32 k;
+    s64 err;
+    s64 minErr;
+    u8 header;
+    u8 c;
+
+    for (i = nsam; i < 16; i++)
+    {
+        inBuffer[i] = 0;
+    }
+
+    for (i = 0; i < 16; i++)
+    {
+        saveState[i] = state[i];
+    }
+
+    // Ties go to the lowest predictor and scale
+    minErr = -1;
+    optimalp = 0;
+    bestScale = 0;
+    for (k = 0; k < npredictors; k++)
+    {
+        for (scale = 0; scale <= 12; scale++)
+        {
+            err = quantize_frame(inBuffer, saveState, coefTable[k], order, scale, ix, trialState);
+            if (minErr < 0 || err < minErr)
+            {
+                minErr = err;
+                optimalp = k;
+                bestScale = scale;
+            }
+        }
+    }
+
+    quantize_frame(inBuffer, saveState, coefTable[optimalp], order, bestScale, ix, state);
+
+    header = (bestScale << 4) | (optimalp & 0xf);
+    fwrite(&header, 1, 1, ofile);
+    for (i = 0; i < 16; i += 2)
+    {
+        c = (ix[i] << 4) | (ix[i + 1] & 0xf);
+        fwrite(&c, 1, 1, ofile);
+    }
+}
+#endif
@@ -1,6 +1,11 @@
 #include <stdlib.h>
 #include "tabledesign.h"
 
+#if defined(__SSE2__) && !defined(TABLEDESIGN_NO_SIMD)
+#include <emmintrin.h>
+#define TABLEDESIGN_SSE2
+#endif
+
 void split(double **table, double *delta, int order, int npredictors, double scale)
 {
     int i, j;
@@ -14,16 +19,93 @@ void split(double **table, double *delta, int order, int npredictors, double sca
     }
 }
 
-void refine(double **table, int order, int npredictors, double **data, int dataSize, int refineIters, UNUSED double unused)
+struct ClassifyArgs
+{
+    double **dataR;
+    double *acfs; // model_acf of each predictor, order + 1 values each
+    int *best;
+    int order;
+    int npredictors;
+};
+
+/**
+ * Finds the closest predictor to each of the rows in [start, end), as
+ * model_dist measures it, taking the first one of any that are equally close.
+ */
+static void classify(void *arg, int start, int end)
+{
+    struct ClassifyArgs *args = arg;
+    int order = args->order;
+    double *acfs = args->acfs;
+    double *r;
+    double dist;
+    double bestValue;
+    int bestIndex;
+    int i, j, k;
+
+    for (i = start; i < end; i++)
+    {
+        r = args->dataR[i];
+        bestValue = 1e30;
+        bestIndex = 0;
+        j = 0;
+
+#ifdef TABLEDESIGN_SSE2
+        // Two predictors at a time, with the same operations as model_dist_acf
+        for (; j + 2 <= args->npredictors; j += 2)
+        {
+            double *acf0 = acfs + j * (order + 1);
+            double *acf1 = acf0 + order + 1;
+            double dists[2];
+            __m128d sum = _mm_mul_pd(_mm_set_pd(acf1[0], acf0[0]), _mm_set1_pd(r[0]));
+
+            for (k = 1; k <= order; k++)
+            {
+                sum = _mm_add_pd(sum, _mm_mul_pd(_mm_set1_pd(2 * r[k]), _mm_set_pd(acf1[k], acf0[k])));
+            }
+            _mm_storeu_pd(dists, sum);
+
+            if (dists[0] < bestValue)
+            {
+                bestValue = dists[0];
+                bestIndex = j;
+            }
+            if (dists[1] < bestValue)
+            {
+                bestValue = dists[1];
+                bestIndex = j + 1;
+            }
+        }
+#endif
+        for (; j < args->npredictors; j++)
+        {
+            dist = model_dist_acf(acfs + j * (order + 1), r, order);
+            if (dist < bestValue)
+            {
+                bestValue = dist;
+                bestIndex = j;
+            }
+        }
+
+        args->best[i] = bestIndex;
+    }
+}
+
+/**
+ * Improves the predictors in table by moving each one to the centroid of the
+ * rows closest to it, refineIters times. dataR has the output of rfroma for
+ * each row, which is all that's needed of them. Finding the closest predictors
+ * is split across numThreads threads, and the centroids are summed in row
+ * order, so the table is the same for any number of threads.
+ */
+void refine(double **table, int order, int npredictors, double **dataR, int dataSize, int refineIters, int numThreads)
 {
     int iter; // spD8
     double **rsums;
     int *counts; // spD0
     double *temp_s7;
-    double dist;
     double dummy; // spC0
-    double bestValue;
-    int bestIndex;
+    struct ClassifyArgs args;
     int i, j;
 
     rsums = malloc(npredictors * sizeof(double*));
@@ -35,6 +117,12 @@ void refine(double **table, int order, int npredictors, double **data, int dataS
     counts = malloc(npredictors * sizeof(int));
     temp_s7 = malloc((order + 1) * sizeof(double));
 
+    args.dataR = dataR;
+    args.acfs = malloc(npredictors * (order + 1) * sizeof(double));
+    args.best = malloc((dataSize > 0 ? dataSize : 1) * sizeof(int));
+    args.order = order;
+    args.npredictors = npredictors;
+
     for (iter = 0; iter < refineIters; iter++)
     {
         for (i = 0; i < npredictors; i++)
@@ -44,28 +132,17 @@ void refine(double **table, int order, int npredictors, double **data, int dataS
             {
                 rsums[i][j] = 0.0;
             }
+            model_acf(table[i], order, args.acfs + i * (order + 1));
         }
 
+        parallel_for(dataSize, numThreads, classify, &args);
+
         for (i = 0; i < dataSize; i++)
         {
-            bestValue = 1e30;
-            bestIndex = 0;
-
-            for (j = 0; j < npredictors; j++)
-            {
-                dist = model_dist(table[j], data[i], order);
-                if (dist < bestValue)
-                {
-                    bestValue = dist;
-                    bestIndex = j;
-                }
-            }
-
-            counts[bestIndex]++;
-            rfroma(data[i], order, temp_s7);
+            counts[args.best[i]]++;
             for (j = 0; j <= order; j++)
             {
-                rsums[bestIndex][j] += temp_s7[j];
+                rsums[args.best[i]][j] += dataR[i][j];
             }
         }
 
@@ -94,6 +171,8 @@ void refine(double **table, int order, int npredictors, double **data, int dataS
         }
     }
 
+    free(args.acfs);
+    free(args.best);
     free(counts);
     for (i = 0; i < npredictors; i++)
     {
@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include "tabledesign.h"
 
+#if defined(__SSE2__) && !defined(TABLEDESIGN_NO_SIMD)
+#include <emmintrin.h>
+#define TABLEDESIGN_SSE2
+#endif
+
 /**
  * Computes the autocorrelation of a vector. More precisely, it computes the
  * dot products of vec[i:] and vec[:-i] for i in [0, k). Unused.
@@ -160,50 +165,102 @@ void rfroma(double *arg0, int n, double *arg2)
     free(mat);
 }
 
-double model_dist(double *arg0, double *arg1, int n)
+/**
+ * Computes the autocorrelation of the coefficients of a predictor, for
+ * model_dist_acf.
+ */
+void model_acf(double *model, int n, double *out)
 {
-    double *sp3C;
-    double *sp38;
-    double ret;
     int i, j;
 
-    sp3C = malloc((n + 1) * sizeof(double));
-    sp38 = malloc((n + 1) * sizeof(double));
-    rfroma(arg1, n, sp3C);
-
     for (i = 0; i <= n; i++)
     {
-        sp38[i] = 0.0;
+        out[i] = 0.0;
         for (j = 0; j <= n - i; j++)
         {
-            sp38[i] += arg0[j] * arg0[i + j];
+            out[i] += model[j] * model[i + j];
         }
     }
+}
+
+/**
+ * The distance of model_dist, from the autocorrelation of the predictor
+ * (model_acf) and the output of rfroma for the other coefficients.
+ */
+double model_dist_acf(double *modelAcf, double *r, int n)
+{
+    double ret;
+    int i;
 
-    ret = sp38[0] * sp3C[0];
+    ret = modelAcf[0] * r[0];
     for (i = 1; i <= n; i++)
     {
-        ret += 2 * sp3C[i] * sp38[i];
+        ret += 2 * r[i] * modelAcf[i];
     }
+    return ret;
+}
+
+double model_dist(double *arg0, double *arg1, int n)
+{
+    double *sp3C;
+    double *sp38;
+    double ret;
+
+    sp3C = malloc((n + 1) * sizeof(double));
+    sp38 = malloc((n + 1) * sizeof(double));
+    rfroma(arg1, n, sp3C);
+    model_acf(arg0, n, sp38);
+    ret = model_dist_acf(sp38, sp3C, n);
 
     free(sp3C);
     free(sp38);
     return ret;
 }
 
+/**
+ * Sums a[k] * b[k] for k in [0, m). Every product and partial sum is an
+ * integer below 2^53, so the result is exact and doesn't depend on the order
+ * the products are added in.
+ */
+static double dot_s16(short *a, short *b, int m)
+{
+    double sum = 0.0;
+    int k = 0;
+#ifdef TABLEDESIGN_SSE2
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+
+    for (; k + 4 <= m; k += 4)
+    {
+        __m128i va = _mm_loadl_epi64((__m128i *)(a + k));
+        __m128i vb = _mm_loadl_epi64((__m128i *)(b + k));
+        va = _mm_srai_epi32(_mm_unpacklo_epi16(va, va), 16);
+        vb = _mm_srai_epi32(_mm_unpacklo_epi16(vb, vb), 16);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_cvtepi32_pd(va), _mm_cvtepi32_pd(vb)));
+        va = _mm_shuffle_epi32(va, _MM_SHUFFLE(1, 0, 3, 2));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_cvtepi32_pd(va), _mm_cvtepi32_pd(vb)));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    sum = _mm_cvtsd_f64(acc0) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc0, acc0));
+#endif
+    for (; k < m; k++)
+    {
+        sum += a[k] * b[k];
+    }
+    return sum;
+}
+
 // compute autocorrelation matrix?
 void acmat(short *in, int n, int m, double **out)
 {
-    int i, j, k;
+    int i, j;
     for (i = 1; i <= n; i++)
     {
-        for (j = 1; j <= n; j++)
+        for (j = i; j <= n; j++)
         {
-            out[i][j] = 0.0;
-            for (k = 0; k < m; k++)
-            {
-                out[i][j] += in[k - i] * in[k - j];
-            }
+            out[i][j] = dot_s16(in - i, in - j, m);
+            out[j][i] = out[i][j];
         }
     }
 }
@@ -211,14 +268,10 @@ void acmat(short *in, int n, int m, double **out)
 // compute autocorrelation vector?
 void acvect(short *in, int n, int m, double *out)
 {
-    int i, j;
+    int i;
     for (i = 0; i <= n; i++)
     {
-        out[i] = 0.0;
-        for (j = 0; j < m; j++)
-        {
-            out[i] -= in[j - i] * in[j];
-        }
+        out[i] = 0.0 - dot_s16(in - i, in, m);
     }
 }
 
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include "tabledesign.h"
+
+#ifndef __sgi
+#include <pthread.h>
+#include <unistd.h>
+
+struct ParallelRange
+{
+    void (*func)(void *arg, int start, int end);
+    void *arg;
+    int start;
+    int end;
+};
+
+static void *parallel_thread(void *arg)
+{
+    struct ParallelRange *range = arg;
+
+    range->func(range->arg, range->start, range->end);
+    return NULL;
+}
+#endif
+
+/**
+ * Returns the number of threads to use for -j 0.
+ */
+int default_thread_count(void)
+{
+#if !defined(__sgi) && defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * Calls func(arg, start, end) for contiguous ranges of [0, count) on up to
+ * numThreads threads, and waits for them to finish. The ranges are disjoint,
+ * so func can write per-index results without locking.
+ */
+void parallel_for(int count, int numThreads, void (*func)(void *arg, int start, int end), void *arg)
+{
+#ifndef __sgi
+    struct ParallelRange *ranges;
+    pthread_t *threads;
+    int i;
+
+    if (numThreads > count)
+    {
+        numThreads = count;
+    }
+    if (numThreads <= 1)
+    {
+        if (count > 0)
+        {
+            func(arg, 0, count);
+        }
+        return;
+    }
+
+    ranges = malloc(numThreads * sizeof(struct ParallelRange));
+    threads = malloc(numThreads * sizeof(pthread_t));
+    for (i = 0; i < numThreads; i++)
+    {
+        ranges[i].func = func;
+        ranges[i].arg = arg;
+        ranges[i].start = (int)((long long)count * i / numThreads);
+        ranges[i].end = (int)((long long)count * (i + 1) / numThreads);
+    }
+
+    // The first range is done on this thread
+    for (i = 1; i < numThreads; i++)
+    {
+        if (pthread_create(&threads[i], NULL, parallel_thread, &ranges[i]) != 0)
+        {
+            ranges[i].func = NULL;
+            func(arg, ranges[i].start, ranges[i].end);
+        }
+    }
+    func(arg, ranges[0].start, ranges[0].end);
+    for (i = 1; i < numThreads; i++)
+    {
+        if (ranges[i].func != NULL)
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    free(ranges);
+    free(threads);
+#else
+    if (count > 0)
+    {
+        func(arg, 0, count);
+    }
+#endif
+}
@@ -30,7 +30,82 @@ typedef int SampleFormat;
 
 #endif
 
-char usage[80] = "[-o order -s bits -t thresh -i refine_iter -f frame_size] aifcfile";
+char usage[96] = "[-o order -s bits -t thresh -i refine_iter -f frame_size -j threads] aifcfile";
+
+struct FrameArgs
+{
+    short *samples; // frameSize zeroes, then the frames
+    int order;
+    int frameSize;
+    double thresh;
+    double *coefs;  // order + 1 predictor coefficients for each frame
+    double *coefsR; // rfroma of each frame's coefficients
+    char *valid;    // whether the frame has coefficients
+};
+
+/**
+ * Finds the predictor coefficients of the frames in [start, end), for the
+ * frames that are loud enough and give a stable predictor.
+ */
+static void analyze_frames(void *arg, int start, int end)
+{
+    struct FrameArgs *args = arg;
+    int order = args->order;
+    double *vec = malloc((order + 1) * sizeof(double));
+    double *spF4 = malloc((order + 1) * sizeof(double));
+    double **mat = malloc((order + 1) * sizeof(double*));
+    int *perm = malloc((order + 1) * sizeof(int));
+    int permDet;
+    short *in;
+    double *row;
+    int f, i;
+
+    for (i = 0; i <= order; i++)
+    {
+        mat[i] = malloc((order + 1) * sizeof(double));
+    }
+
+    for (f = start; f < end; f++)
+    {
+        in = args->samples + args->frameSize * (f + 1);
+        args->valid[f] = 0;
+
+        acvect(in, order, args->frameSize, vec);
+        if (fabs(vec[0]) > args->thresh)
+        {
+            acmat(in, order, args->frameSize, mat);
+            if (lud(mat, order, perm, &permDet) == 0)
+            {
+                lubksb(mat, order, perm, vec);
+                vec[0] = 1.0;
+                if (kfroma(vec, spF4, order) == 0)
+                {
+                    row = args->coefs + f * (order + 1);
+                    row[0] = 1.0;
+
+                    for (i = 1; i <= order; i++)
+                    {
+                        if (spF4[i] >=  1.0) spF4[i] =  0.9999999999;
+                        if (spF4[i] <= -1.0) spF4[i] = -0.9999999999;
+                    }
+
+                    afromk(spF4, row, order);
+                    rfroma(row, order, args->coefsR + f * (order + 1));
+                    args->valid[f] = 1;
+                }
+            }
+        }
+    }
+
+    for (i = 0; i <= order; i++)
+    {
+        free(mat[i]);
+    }
+    free(mat);
+    free(perm);
+    free(spF4);
+    free(vec);
+}
 
 int main(int argc, char **argv)
 {
@@ -40,19 +115,18 @@ int main(int argc, char **argv)
     int bits; // sp108
     int refineIters; // sp104
     int frameSize; // sp100
+    int numThreads;
     UNUSED int rate;
     int frameCount;
     int opt;
     double *spF4;
     double dummy; // spE8
-    double **mat; // spE4
     double **data; // spD0
+    double **dataR;
     double *splitDelta; // spCC
     int j; // spC0
-    int permDet;
     int curBits; // spB8
     int npredictors; // spB4
-    int *perm; // spB0
     int numOverflows; // spAC
     SampleFormat sampleFormat; // sp90
     SampleFormat sampleWidth; // sp8C
@@ -61,7 +135,10 @@ int main(int argc, char **argv)
     int tracks;
     double *vec; // s2
     double **temp_s1;
-    short *temp_s3;
+    short *samples;
+    int numFrames;
+    int maxFrames;
+    struct FrameArgs frameArgs;
     int i;
     int dataSize; // s4
 
@@ -69,6 +146,7 @@ int main(int argc, char **argv)
     bits = 2;
     refineIters = 2;
     frameSize = 16;
+    numThreads = 1;
     numOverflows = 0;
     programName = argv[0];
     thresh = 10.0;
@@ -79,7 +157,7 @@ int main(int argc, char **argv)
         exit(1);
     }
 
-    while ((opt = getopt(argc, argv, "o:s:t:i:f:")) != -1)
+    while ((opt = getopt(argc, argv, "o:s:t:i:f:j:")) != -1)
     {
         switch (opt)
         {
@@ -103,6 +181,13 @@ int main(int argc, char **argv)
             if (sscanf(optarg, "%lf", &thresh) != 1)
                 thresh = 10.0;
             break;
+        case 'j':
+            // The codebook is the same for any number of threads; 0 uses all processors
+            if (sscanf(optarg, "%d", &numThreads) != 1 || numThreads < 0)
+                numThreads = 1;
+            if (numThreads == 0)
+                numThreads = default_thread_count();
+            break;
         }
     }
 
@@ -151,56 +236,49 @@ int main(int argc, char **argv)
     }
 
     splitDelta = malloc((order + 1) * sizeof(double));
-    temp_s3 = malloc(frameSize * 2 * sizeof(short));
-    for (i = 0; i < frameSize * 2; i++)
-    {
-        temp_s3[i] = 0;
-    }
-
     vec = malloc((order + 1) * sizeof(double));
     spF4 = malloc((order + 1) * sizeof(double));
-    mat = malloc((order + 1) * sizeof(double*));
-    for (i = 0; i <= order; i++)
-    {
-        mat[i] = malloc((order + 1) * sizeof(double));
-    }
 
-    perm = malloc((order + 1) * sizeof(int));
     frameCount = AFgetframecnt(afFile, AF_DEFAULT_TRACK);
     rate = AFgetrate(afFile, AF_DEFAULT_TRACK);
-    data = malloc(frameCount * sizeof(double*));
-    dataSize = 0;
 
-    while (AFreadframes(afFile, AF_DEFAULT_TRACK, temp_s3 + frameSize, frameSize) == frameSize)
+    // Read all of the frames first, after frameSize zeroes for the first one to look back on
+    maxFrames = (frameCount > 0 ? frameCount / frameSize : 0) + 1;
+    samples = malloc((maxFrames + 1) * frameSize * sizeof(short));
+    for (i = 0; i < frameSize; i++)
     {
-        acvect(temp_s3 + frameSize, order, frameSize, vec);
-        if (fabs(vec[0]) > thresh)
+        samples[i] = 0;
+    }
+    numFrames = 0;
+    while (AFreadframes(afFile, AF_DEFAULT_TRACK, samples + frameSize * (numFrames + 1), frameSize) == frameSize)
+    {
+        numFrames++;
+        if (numFrames == maxFrames)
         {
-            acmat(temp_s3 + frameSize, order, frameSize, mat);
-            if (lud(mat, order, perm, &permDet) == 0)
-            {
-                lubksb(mat, order, perm, vec);
-                vec[0] = 1.0;
-                if (kfroma(vec, spF4, order) == 0)
-                {
-                    data[dataSize] = malloc((order + 1) * sizeof(double));
-                    data[dataSize][0] = 1.0;
-
-                    for (i = 1; i <= order; i++)
-                    {
-                        if (spF4[i] >=  1.0) spF4[i] =  0.9999999999;
-                        if (spF4[i] <= -1.0) spF4[i] = -0.9999999999;
-                    }
-
-                    afromk(spF4, data[dataSize], order);
-                    dataSize++;
-                }
-            }
+            maxFrames *= 2;
+            samples = realloc(samples, (maxFrames + 1) * frameSize * sizeof(short));
         }
+    }
 
-        for (i = 0; i < frameSize; i++)
+    frameArgs.samples = samples;
+    frameArgs.order = order;
+    frameArgs.frameSize = frameSize;
+    frameArgs.thresh = thresh;
+    frameArgs.coefs = malloc((numFrames > 0 ? numFrames : 1) * (order + 1) * sizeof(double));
+    frameArgs.coefsR = malloc((numFrames > 0 ? numFrames : 1) * (order + 1) * sizeof(double));
+    frameArgs.valid = malloc(numFrames > 0 ? numFrames : 1);
+    parallel_for(numFrames, numThreads, analyze_frames, &frameArgs);
+
+    data = malloc((numFrames > 0 ? numFrames : 1) * sizeof(double*));
+    dataR = malloc((numFrames > 0 ? numFrames : 1) * sizeof(double*));
+    dataSize = 0;
+    for (i = 0; i < numFrames; i++)
+    {
+        if (frameArgs.valid[i])
         {
-            temp_s3[i] = temp_s3[i + frameSize];
+            data[dataSize] = frameArgs.coefs + i * (order + 1);
+            dataR[dataSize] = frameArgs.coefsR + i * (order + 1);
+            dataSize++;
         }
     }
 
@@ -212,10 +290,9 @@ int main(int argc, char **argv)
 
     for (i = 0; i < dataSize; i++)
     {
-        rfroma(data[i], order, temp_s1[0]);
         for (j = 1; j <= order; j++)
         {
-            vec[j] += temp_s1[0][j];
+            vec[j] += dataR[i][j];
         }
     }
 
@@ -243,7 +320,7 @@ int main(int argc, char **argv)
         splitDelta[order - 1] = -1.0;
         split(temp_s1, splitDelta, order, 1 << curBits, 0.01);
         curBits++;
-        refine(temp_s1, order, 1 << curBits, data, dataSize, refineIters, 0.0);
+        refine(temp_s1, order, 1 << curBits, dataR, dataSize, refineIters, numThreads);
     }
 
     npredictors = 1 << curBits;
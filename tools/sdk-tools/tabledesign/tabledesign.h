@@ -15,6 +15,8 @@ void afromk(double *in, double *out, int n);
 int kfroma(double *in, double *out, int n);
 void rfroma(double *dataRow, int n, double *thing3);
 double model_dist(double *first, double *second, int n);
+void model_acf(double *model, int n, double *out);
+double model_dist_acf(double *modelAcf, double *r, int n);
 void acmat(short *in, int n, int m, double **mat);
 void acvect(short *in, int n, int m, double *vec);
 int lud(double **a, int n, int *indx, int *d);
@@ -22,7 +24,11 @@ void lubksb(double **a, int n, int *indx, double *b);
 
 // codebook.c
 void split(double **table, double *delta, int order, int npredictors, double scale);
-void refine(double **table, int order, int npredictors, double **data, int dataSize, int refineIters, double unused);
+void refine(double **table, int order, int npredictors, double **dataR, int dataSize, int refineIters, int numThreads);
+
+// parallel.c
+int default_thread_count(void);
+void parallel_for(int count, int numThreads, void (*func)(void *arg, int start, int end), void *arg);
 
 // print.c
 int print_entry(FILE *out, double *row, int order);
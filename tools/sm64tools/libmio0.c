@@ -15,46 +15,68 @@
 
 #define GET_BIT(buf, bit) ((buf)[(bit) / 8] & (1 << (7 - ((bit) % 8))))
 
+// MIO0 back-references are 3 to 18 bytes long and reach back up to 4096 bytes
+#define MIN_MATCH 3
+#define MAX_MATCH 18
+#define WINDOW_SIZE 4096
+
 // types
+
+// match finder: every position of the input is chained, oldest first, to the
+// later positions whose first MIN_MATCH bytes have the same hash
 typedef struct
 {
-   int *indexes;
-   int allocated;
-   int count;
-   int start;
-} lookback;
+   int *head; // oldest position in each chain that may still be in the window, -1 if none
+   int *tail; // newest position in each chain, -1 if none
+   int *next; // next position with the same hash, -1 if none
+} match_finder;
 
 // functions
-#define LOOKBACK_COUNT 256
-#define LOOKBACK_INIT_SIZE 128
-static lookback *lookback_init(void)
+#define HASH_BITS 15
+#define HASH_SIZE (1 << HASH_BITS)
+static match_finder *match_finder_init(unsigned int length)
 {
-   lookback *lb = malloc(LOOKBACK_COUNT * sizeof(*lb));
-   for (int i = 0; i < LOOKBACK_COUNT; i++) {
-      lb[i].allocated = LOOKBACK_INIT_SIZE;
-      lb[i].indexes = malloc(lb[i].allocated * sizeof(*lb[i].indexes));
-      lb[i].count = 0;
-      lb[i].start = 0;
-   }
-   return lb;
+   match_finder *mf = malloc(sizeof(*mf));
+   mf->head = malloc(HASH_SIZE * sizeof(*mf->head));
+   mf->tail = malloc(HASH_SIZE * sizeof(*mf->tail));
+   mf->next = malloc((length + 1) * sizeof(*mf->next));
+   for (int i = 0; i < HASH_SIZE; i++) {
+      mf->head[i] = -1;
+      mf->tail[i] = -1;
+   }
+   return mf;
 }
 
-static void lookback_free(lookback *lb)
+static void match_finder_free(match_finder *mf)
 {
-   for (int i = 0; i < LOOKBACK_COUNT; i++) {
-      free(lb[i].indexes);
-   }
-   free(lb);
+   free(mf->head);
+   free(mf->tail);
+   free(mf->next);
+   free(mf);
 }
 
-static inline void lookback_push(lookback *lkbk, unsigned char val, int index)
+static inline unsigned int match_hash(const unsigned char *buf)
 {
-   lookback *lb = &lkbk[val];
-   if (lb->count == lb->allocated) {
-      lb->allocated *= 4;
-      lb->indexes = realloc(lb->indexes, lb->allocated * sizeof(*lb->indexes));
+   unsigned int val = (buf[0] << 16) | (buf[1] << 8) | buf[2];
+   return (val * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// add a position to the match finder, must be called for every position in order
+static inline void match_finder_push(match_finder *mf, const unsigned char *buf, unsigned int length, int index)
+{
+   unsigned int hash;
+   // too close to the end to start a match
+   if (index + MIN_MATCH > (int)length) {
+      return;
+   }
+   hash = match_hash(&buf[index]);
+   mf->next[index] = -1;
+   if (mf->tail[hash] < 0) {
+      mf->head[hash] = index;
+   } else {
+      mf->next[mf->tail[hash]] = index;
    }
-   lb->indexes[lb->count++] = index;
+   mf->tail[hash] = index;
 }
 
 static void PUT_BIT(unsigned char *buf, int bit, int val)
@@ -70,16 +92,20 @@ static void PUT_BIT(unsigned char *buf, int bit, int val)
 // max_search: max number of bytes to find
 // found_offset: returned offset found (0 if none found)
 // returns max length of matching stream (0 if none found)
-static int find_longest(const unsigned char *buf, int start_offset, int max_search, int *found_offset, lookback *lkbk)
+// only matches of at least MIN_MATCH bytes are looked for, shorter lengths may be
+// returned as 0. of the longest matches, the one farthest back is returned.
+// start_offset must not go backwards between calls.
+static int find_longest(const unsigned char *buf, int start_offset, int max_search, int *found_offset, match_finder *mf)
 {
    int best_length = 0;
    int best_offset = 0;
-   int cur_length;
-   int search_len;
    int farthest, off, i;
-   int lb_idx;
-   const unsigned char first = buf[start_offset];
-   lookback *lb = &lkbk[first];
+   unsigned int hash;
+
+   *found_offset = 0;
+   if (max_search < MIN_MATCH) {
+      return 0;
+   }
 
    // buf
    //  |    off        start                  max
@@ -89,34 +115,32 @@ static int find_longest(const unsigned char *buf, int start_offset, int max_sear
    //                       +cur_length
 
    // check at most the past 4096 values
-   farthest = MAX(start_offset - 4096, 0);
-   // find starting index
-   for (lb_idx = lb->start; lb_idx < lb->count && lb->indexes[lb_idx] < farthest; lb_idx++) {}
-   lb->start = lb_idx;
-   for ( ; lb_idx < lb->count && lb->indexes[lb_idx] < start_offset; lb_idx++) {
-      off = lb->indexes[lb_idx];
-      // check at most requested max or up until start
-      search_len = MIN(max_search, start_offset - off);
-      for (i = 0; i < search_len; i++) {
+   farthest = MAX(start_offset - WINDOW_SIZE, 0);
+   // drop positions that have left the window
+   hash = match_hash(&buf[start_offset]);
+   for (off = mf->head[hash]; off >= 0 && off < farthest; off = mf->next[off]) {}
+   mf->head[hash] = off;
+   if (off < 0) {
+      mf->tail[hash] = -1;
+   }
+   // oldest first, so the first longest match found is the farthest one
+   for ( ; off >= 0 && off < start_offset; off = mf->next[off]) {
+      // can't be longer unless the byte after the best length matches too
+      if (buf[off + best_length] != buf[start_offset + best_length]) {
+         continue;
+      }
+      // matches may run on into the bytes being matched
+      for (i = 0; i < max_search; i++) {
          if (buf[start_offset + i] != buf[off + i]) {
             break;
          }
       }
-      cur_length = i;
-      // if matched up until start, continue matching in already matched parts
-      if (cur_length == search_len) {
-         // check at most requested max less current length
-         search_len = max_search - cur_length;
-         for (i = 0; i < search_len; i++) {
-            if (buf[start_offset + cur_length + i] != buf[off + i]) {
-               break;
-            }
-         }
-         cur_length += i;
-      }
-      if (cur_length > best_length) {
+      if (i > best_length) {
          best_offset = start_offset - off;
-         best_length = cur_length;
+         best_length = i;
+         if (best_length == max_search) {
+            break;
+         }
       }
    }
 
@@ -193,23 +217,50 @@ int mio0_decode(const unsigned char *in, unsigned char *out, unsigned int *end)
    return bytes_written;
 }
 
+// write the MIO0 header and the three streams to out
+// returns size of compressed data in 'out' including MIO0 header
+static int mio0_write(unsigned char *out, unsigned int length, const unsigned char *bit_buf, int bit_idx,
+                      const unsigned char *comp_buf, int comp_idx, const unsigned char *uncomp_buf, int uncomp_idx)
+{
+   unsigned int bit_length;
+   unsigned int comp_offset;
+   unsigned int uncomp_offset;
+
+   // compute final sizes and offsets
+   // +7 so int division accounts for all bits
+   bit_length = ((bit_idx + 7) / 8);
+   // compressed data after control bits and aligned to 4-byte boundary
+   comp_offset = ALIGN(MIO0_HEADER_LENGTH + bit_length, 4);
+   uncomp_offset = comp_offset + comp_idx;
+
+   // output header
+   memcpy(out, "MIO0", 4);
+   write_u32_be(&out[4], length);
+   write_u32_be(&out[8], comp_offset);
+   write_u32_be(&out[12], uncomp_offset);
+   // output data
+   memcpy(&out[MIO0_HEADER_LENGTH], bit_buf, bit_length);
+   memset(&out[MIO0_HEADER_LENGTH + bit_length], 0, comp_offset - MIO0_HEADER_LENGTH - bit_length);
+   memcpy(&out[comp_offset], comp_buf, comp_idx);
+   memcpy(&out[uncomp_offset], uncomp_buf, uncomp_idx);
+
+   return uncomp_offset + uncomp_idx;
+}
+
 int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out)
 {
    unsigned char *bit_buf;
    unsigned char *comp_buf;
    unsigned char *uncomp_buf;
-   unsigned int bit_length;
-   unsigned int comp_offset;
-   unsigned int uncomp_offset;
    unsigned int bytes_proc = 0;
    int bytes_written;
    int bit_idx = 0;
    int comp_idx = 0;
    int uncomp_idx = 0;
-   lookback *lookbacks;
+   match_finder *mf;
 
-   // initialize lookback buffer
-   lookbacks = lookback_init();
+   // initialize match finder
+   mf = match_finder_init(length);
 
    // allocate some temporary buffers worst case size
    bit_buf = malloc((length + 7) / 8); // 1-bit/byte
@@ -219,22 +270,22 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
 
    // encode data
    // special case for first byte
-   lookback_push(lookbacks, in[0], 0);
+   match_finder_push(mf, in, length, 0);
    uncomp_buf[uncomp_idx] = in[0];
    uncomp_idx += 1;
    bytes_proc += 1;
    PUT_BIT(bit_buf, bit_idx++, 1);
    while (bytes_proc < length) {
       int offset;
-      int max_length = MIN(length - bytes_proc, 18);
-      int longest_match = find_longest(in, bytes_proc, max_length, &offset, lookbacks);
+      int max_length = MIN(length - bytes_proc, MAX_MATCH);
+      int longest_match = find_longest(in, bytes_proc, max_length, &offset, mf);
       // push current byte before checking next longer match
-      lookback_push(lookbacks, in[bytes_proc], bytes_proc);
+      match_finder_push(mf, in, length, bytes_proc);
       if (longest_match > 2) {
          int lookahead_offset;
          // lookahead to next byte to see if longer match
-         int lookahead_length = MIN(length - bytes_proc - 1, 18);
-         int lookahead_match = find_longest(in, bytes_proc + 1, lookahead_length, &lookahead_offset, lookbacks);
+         int lookahead_length = MIN(length - bytes_proc - 1, MAX_MATCH);
+         int lookahead_match = find_longest(in, bytes_proc + 1, lookahead_length, &lookahead_offset, mf);
          // better match found, use uncompressed + lookahead compressed
          if ((longest_match + 1) < lookahead_match) {
             // uncompressed byte
@@ -245,11 +296,11 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
             longest_match = lookahead_match;
             offset = lookahead_offset;
             bit_idx++;
-            lookback_push(lookbacks, in[bytes_proc], bytes_proc);
+            match_finder_push(mf, in, length, bytes_proc);
          }
          // first byte already pushed above
          for (int i = 1; i < longest_match; i++) {
-            lookback_push(lookbacks, in[bytes_proc + i], bytes_proc + i);
+            match_finder_push(mf, in, length, bytes_proc + i);
          }
          // compressed block
          comp_buf[comp_idx] = (((longest_match - 3) & 0x0F) << 4) |
@@ -268,29 +319,105 @@ int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out
       bit_idx++;
    }
 
-   // compute final sizes and offsets
-   // +7 so int division accounts for all bits
-   bit_length = ((bit_idx + 7) / 8);
-   // compressed data after control bits and aligned to 4-byte boundary
-   comp_offset = ALIGN(MIO0_HEADER_LENGTH + bit_length, 4);
-   uncomp_offset = comp_offset + comp_idx;
-   bytes_written = uncomp_offset + uncomp_idx;
-
-   // output header
-   memcpy(out, "MIO0", 4);
-   write_u32_be(&out[4], length);
-   write_u32_be(&out[8], comp_offset);
-   write_u32_be(&out[12], uncomp_offset);
-   // output data
-   memcpy(&out[MIO0_HEADER_LENGTH], bit_buf, bit_length);
-   memcpy(&out[comp_offset], comp_buf, comp_idx);
-   memcpy(&out[uncomp_offset], uncomp_buf, uncomp_idx);
+   bytes_written = mio0_write(out, length, bit_buf, bit_idx, comp_buf, comp_idx, uncomp_buf, uncomp_idx);
 
    // free allocated buffers
    free(bit_buf);
    free(comp_buf);
    free(uncomp_buf);
-   lookback_free(lookbacks);
+   match_finder_free(mf);
+
+   return bytes_written;
+}
+
+// cost in bits of each kind of block: a control bit plus the data
+#define UNCOMP_COST (1 + 8)
+#define COMP_COST (1 + 16)
+
+int mio0_encode_optimal(const unsigned char *in, unsigned int length, unsigned char *out)
+{
+   unsigned char *bit_buf;
+   unsigned char *comp_buf;
+   unsigned char *uncomp_buf;
+   unsigned char *match_lengths;
+   unsigned short *match_offsets;
+   unsigned int *costs;
+   unsigned char *choices;
+   unsigned int bytes_proc;
+   int bytes_written;
+   int bit_idx = 0;
+   int comp_idx = 0;
+   int uncomp_idx = 0;
+   match_finder *mf;
+
+   mf = match_finder_init(length);
+
+   bit_buf = malloc((length + 7) / 8);
+   comp_buf = malloc(length);
+   uncomp_buf = malloc(length);
+   memset(bit_buf, 0, (length + 7) / 8);
+   match_lengths = malloc(length);
+   match_offsets = malloc(length * sizeof(*match_offsets));
+   costs = malloc((length + 1) * sizeof(*costs));
+   choices = malloc(length);
+
+   // find the longest match at every position. a match can also be used for any
+   // length from 3 up to its own, so this is all the parse needs.
+   for (bytes_proc = 0; bytes_proc < length; bytes_proc++) {
+      int offset;
+      int max_length = MIN(length - bytes_proc, MAX_MATCH);
+      match_lengths[bytes_proc] = find_longest(in, bytes_proc, max_length, &offset, mf);
+      match_offsets[bytes_proc] = offset;
+      match_finder_push(mf, in, length, bytes_proc);
+   }
+
+   // cheapest way to encode everything from each position to the end, working
+   // back from the end. choices holds the length of the block to use there.
+   costs[length] = 0;
+   for (int i = length - 1; i >= 0; i--) {
+      costs[i] = costs[i + 1] + UNCOMP_COST;
+      choices[i] = 1;
+      for (int len = MIN_MATCH; len <= match_lengths[i]; len++) {
+         if (costs[i + len] + COMP_COST < costs[i]) {
+            costs[i] = costs[i + len] + COMP_COST;
+            choices[i] = len;
+         }
+      }
+   }
+
+   // encode data
+   bytes_proc = 0;
+   while (bytes_proc < length) {
+      int len = choices[bytes_proc];
+      if (len >= MIN_MATCH) {
+         // compressed block
+         int offset = match_offsets[bytes_proc];
+         comp_buf[comp_idx] = (((len - 3) & 0x0F) << 4) |
+                              (((offset - 1) >> 8) & 0x0F);
+         comp_buf[comp_idx + 1] = (offset - 1) & 0xFF;
+         comp_idx += 2;
+         PUT_BIT(bit_buf, bit_idx, 0);
+         bytes_proc += len;
+      } else {
+         // uncompressed byte
+         uncomp_buf[uncomp_idx] = in[bytes_proc];
+         uncomp_idx++;
+         PUT_BIT(bit_buf, bit_idx, 1);
+         bytes_proc++;
+      }
+      bit_idx++;
+   }
+
+   bytes_written = mio0_write(out, length, bit_buf, bit_idx, comp_buf, comp_idx, uncomp_buf, uncomp_idx);
+
+   free(bit_buf);
+   free(comp_buf);
+   free(uncomp_buf);
+   free(match_lengths);
+   free(match_offsets);
+   free(costs);
+   free(choices);
+   match_finder_free(mf);
 
    return bytes_written;
 }
@@ -382,7 +509,7 @@ free_all:
    return ret_val;
 }
 
-int mio0_encode_file(const char *in_file, const char *out_file)
+int mio0_encode_file(const char *in_file, const char *out_file, int optimal)
 {
    FILE *in;
    FILE *out;
@@ -412,11 +539,15 @@ int mio0_encode_file(const char *in_file, const char *out_file)
       goto free_all;
    }
 
-   // allocate worst case length
-   out_buf = malloc(MIO0_HEADER_LENGTH + ((file_size+7)/8) + file_size);
+   // allocate worst case length, +3 for aligning the compressed data
+   out_buf = malloc(MIO0_HEADER_LENGTH + ((file_size+7)/8) + 3 + file_size);
 
    // compress data in MIO0 format
-   bytes_encoded = mio0_encode(in_buf, file_size, out_buf);
+   if (optimal) {
+      bytes_encoded = mio0_encode_optimal(in_buf, file_size, out_buf);
+   } else {
+      bytes_encoded = mio0_encode(in_buf, file_size, out_buf);
+   }
 
    // open output file
    out = mio0_open_out_file(out_file);
@@ -455,6 +586,7 @@ typedef struct
    char *out_filename;
    unsigned int offset;
    int compress;
+   int optimal;
 } arg_config;
 
 static arg_config default_config =
@@ -462,18 +594,21 @@ static arg_config default_config =
    NULL,
    NULL,
    0,
-   1
+   1,
+   0
 };
 
 static void print_usage(void)
 {
-   ERROR("Usage: mio0 [-c / -d] [-o OFFSET] FILE [OUTPUT]\n"
+   ERROR("Usage: mio0 [-c / -d] [-s] [-o OFFSET] FILE [OUTPUT]\n"
          "\n"
          "mio0 v" MIO0_VERSION ": MIO0 compression and decompression tool\n"
          "\n"
          "Optional arguments:\n"
          " -c           compress raw data into MIO0 (default: compress)\n"
          " -d           decompress MIO0 into raw data\n"
+         " -s           compress to the smallest size MIO0 can (slower, output differs\n"
+         "              from the default)\n"
          " -o OFFSET    starting offset in FILE (default: 0)\n"
          "\n"
          "File arguments:\n"
@@ -500,6 +635,9 @@ static void parse_arguments(int argc, char *argv[], arg_config *config)
             case 'd':
                config->compress = 0;
                break;
+            case 's':
+               config->optimal = 1;
+               break;
             case 'o':
                if (++i >= argc) {
                   print_usage();
@@ -546,7 +684,7 @@ int main(int argc, char *argv[])
 
    // operation
    if (config.compress) {
-      ret_val = mio0_encode_file(config.in_filename, config.out_filename);
+      ret_val = mio0_encode_file(config.in_filename, config.out_filename, config.optimal);
    } else {
       ret_val = mio0_decode_file(config.in_filename, config.offset, config.out_filename);
    }
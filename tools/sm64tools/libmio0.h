@@ -36,6 +36,13 @@ int mio0_decode(const unsigned char *in, unsigned char *out, unsigned int *end);
 // returns size of compressed data in 'out' including MIO0 header
 int mio0_encode(const unsigned char *in, unsigned int length, unsigned char *out);
 
+// encode MIO0 data in memory, choosing the blocks that make the output as small
+// as possible instead of matching greedily. slower than mio0_encode.
+// in: buffer containing raw data
+// out: buffer for MIO0 data
+// returns size of compressed data in 'out' including MIO0 header
+int mio0_encode_optimal(const unsigned char *in, unsigned int length, unsigned char *out);
+
 // decode an entire MIO0 block at an offset from file to output file
 // in_file: input filename
 // offset: offset to start decoding from in_file
@@ -45,6 +52,7 @@ int mio0_decode_file(const char *in_file, unsigned long offset, const char *out_
 // encode an entire file
 // in_file: input filename containing raw data to be encoded
 // out_file: output filename to write MIO0 compressed data to
-int mio0_encode_file(const char *in_file, const char *out_file);
+// optimal: use mio0_encode_optimal instead of mio0_encode
+int mio0_encode_file(const char *in_file, const char *out_file, int optimal);
 
 #endif // LIBMIO0_H_
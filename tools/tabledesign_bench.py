@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Time tabledesign over the game's samples.
+
+Runs tools/tabledesign on every sound/samples/*/*.aiff, as aiff_extract_codebook
+does, once with one thread and once with each of the given thread counts, and
+prints how long each run took. The codebooks have to come out the same for any
+number of threads, so every run is checked against the first one. With
+--reference they are also checked against another tabledesign binary, such as
+one built before a change.
+
+Usage: tabledesign_bench.py [-j THREADS...] [--reference BIN] [-- TABLEDESIGN_ARGS]
+
+Run from the root of the repo. TABLEDESIGN_ARGS default to -s 1.
+"""
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import time
+
+
+def run_all(binary, args, samples):
+    outputs = []
+    start = time.perf_counter()
+    for sample in samples:
+        result = subprocess.run([binary] + args + [sample], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if result.returncode != 0:
+            sys.exit("%s failed on %s:\n%s" % (binary, sample, result.stdout.decode(errors="replace")))
+        outputs.append(result.stdout)
+    return time.perf_counter() - start, outputs
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Time tabledesign over the game's samples.")
+    parser.add_argument("-j", dest="threads", type=int, nargs="+", default=[os.cpu_count() or 1],
+                        help="thread counts to time besides 1 (default: the number of processors)")
+    parser.add_argument("--binary", default="tools/tabledesign", help="tabledesign to time")
+    parser.add_argument("--reference", help="tabledesign binary whose codebooks must match")
+    parser.add_argument("args", nargs="*", default=["-s", "1"], help="arguments for tabledesign")
+    args = parser.parse_args()
+
+    samples = sorted(glob.glob("sound/samples/*/*.aiff"))
+    if not samples:
+        sys.exit("No samples found, run from the root of the repo")
+
+    print("%d samples, tabledesign %s" % (len(samples), " ".join(args.args)))
+    print("%-12s %8s %8s" % ("run", "seconds", "speedup"))
+
+    base_time, base_outputs = run_all(args.binary, args.args + ["-j", "1"], samples)
+    print("%-12s %8.3f %8.2f" % ("-j 1", base_time, 1.0))
+
+    mismatches = 0
+    for threads in args.threads:
+        if threads == 1:
+            continue
+        seconds, outputs = run_all(args.binary, args.args + ["-j", str(threads)], samples)
+        print("%-12s %8.3f %8.2f" % ("-j %d" % threads, seconds, base_time / seconds))
+        for sample, a, b in zip(samples, base_outputs, outputs):
+            if a != b:
+                print("-j %d differs on %s" % (threads, sample))
+                mismatches += 1
+
+    if args.reference:
+        seconds, outputs = run_all(args.reference, args.args, samples)
+        print("%-12s %8.3f %8.2f" % ("reference", seconds, base_time / seconds))
+        for sample, a, b in zip(samples, base_outputs, outputs):
+            if a != b:
+                print("reference differs on %s" % sample)
+                mismatches += 1
+
+    if mismatches:
+        sys.exit("%d codebooks differ" % mismatches)
+    print("All codebooks match")
+
+
+if __name__ == "__main__":
+    main()